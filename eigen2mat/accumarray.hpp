@@ -0,0 +1,98 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef ACCUMARRAY_HPP_INCLUDED
+#define ACCUMARRAY_HPP_INCLUDED
+
+#include "eigen2mat/definitions.hpp"
+#include "eigen2mat/utils/include_mex"
+
+namespace eigen2mat {
+     //! \brief Reduction applied by accumarray()
+     enum ACCUM_OP_T {
+	  ACCUM_SUM,   //!< sum of the values
+	  ACCUM_MAX,   //!< maximum of the values (NaN values are ignored)
+	  ACCUM_MIN,   //!< minimum of the values (NaN values are ignored)
+	  ACCUM_COUNT, //!< number of values (the values are not used)
+	  ACCUM_MEAN   //!< mean of the values
+     };
+
+     /*
+      * The functions below are used to reproduce the following in MATLAB :
+      *
+      * accumarray(subs + 1, vals, [n 1], @op)
+      * accumarray([rows cols] + 1, vals, [M N], @op, 0, true)
+      *
+      * ie. element i of the result is the reduction (sum, max, min, numel
+      * or mean) of the values vals(k) such that subs(k) == i. Subscripts are
+      * 0-based; elements that do not receive any value are 0 (and are not
+      * stored in sparse results).
+      *
+      * Depending on the number of values and on the size of the result,
+      * the values are either accumulated into one private histogram per
+      * thread (merged at the end) or sorted by subscript in chunks, each
+      * chunk being reduced by one thread (the chunks are then merged); the
+      * latter avoids allocating a full histogram per thread for large
+      * results. For a given number of threads the result does not depend on
+      * the scheduling.
+      *
+      * An error is raised if a subscript is out of range or if the number of
+      * values does not match the number of subscripts (vals may be empty for
+      * ACCUM_COUNT).
+      */
+     real_vector_t accumarray(const idx_array_t& subs,
+			      const real_vector_t& vals,
+			      size_t n,
+			      ACCUM_OP_T op = ACCUM_SUM);
+     real_vector_t accumarray(const int_array_t& subs,
+			      const real_vector_t& vals,
+			      size_t n,
+			      ACCUM_OP_T op = ACCUM_SUM);
+
+     real_sp_matrix_t sp_accumarray(const idx_array_t& rows,
+				    const idx_array_t& cols,
+				    const real_vector_t& vals,
+				    size_t M, size_t N,
+				    ACCUM_OP_T op = ACCUM_SUM);
+     real_sp_matrix_t sp_accumarray(const int_array_t& rows,
+				    const int_array_t& cols,
+				    const real_vector_t& vals,
+				    size_t M, size_t N,
+				    ACCUM_OP_T op = ACCUM_SUM);
+
+     /*
+      * Same as above but writes the result directly into a new MATLAB array
+      * (n x 1 or M x N), dense or sparse.
+      */
+     mxArray* accumarray_to_mxArray(const idx_array_t& subs,
+				    const real_vector_t& vals,
+				    size_t n,
+				    ACCUM_OP_T op = ACCUM_SUM,
+				    bool sparse = false);
+     mxArray* accumarray_to_mxArray(const int_array_t& subs,
+				    const real_vector_t& vals,
+				    size_t n,
+				    ACCUM_OP_T op = ACCUM_SUM,
+				    bool sparse = false);
+
+     mxArray* accumarray_to_mxArray(const idx_array_t& rows,
+				    const idx_array_t& cols,
+				    const real_vector_t& vals,
+				    size_t M, size_t N,
+				    ACCUM_OP_T op = ACCUM_SUM,
+				    bool sparse = true);
+     mxArray* accumarray_to_mxArray(const int_array_t& rows,
+				    const int_array_t& cols,
+				    const real_vector_t& vals,
+				    size_t M, size_t N,
+				    ACCUM_OP_T op = ACCUM_SUM,
+				    bool sparse = true);
+} // namespace eigen2mat
+
+#endif /* ACCUMARRAY_HPP_INCLUDED */
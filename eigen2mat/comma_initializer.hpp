@@ -138,13 +138,27 @@ namespace eigen2mat {
 	  assert(col_end <= xpr_.cols());
 #endif /* EIGEN2MAT_RANGE_CHECK */
 
-	  for (Index i(row_start), io(0); i < row_end ; ++i, ++io) {
+	  // traverse the block in the storage order of the target
+	  if (XprType::IsRowMajor) {
+	       for (Index i(row_start), io(0); i < row_end ; ++i, ++io) {
+		    for (Index j(col_start), jo(0) ; j < col_end ; ++j, ++jo) {
+#ifdef NDEBUG
+			 xpr_.coeffRef(i, j) = other.coeff(io, jo);
+#else
+			 xpr_.coeffRef(i, j) = other(io, jo);
+#endif /* NDEBUG */
+		    }
+	       }
+	  }
+	  else {
 	       for (Index j(col_start), jo(0) ; j < col_end ; ++j, ++jo) {
+		    for (Index i(row_start), io(0); i < row_end ; ++i, ++io) {
 #ifdef NDEBUG
-		    xpr_.coeffRef(i, j) = other.coeff(io, jo);
+			 xpr_.coeffRef(i, j) = other.coeff(io, jo);
 #else
-		    xpr_.coeffRef(i, j) = other(io, jo);
+			 xpr_.coeffRef(i, j) = other(io, jo);
 #endif /* NDEBUG */
+		    }
 	       }
 	  }
      }
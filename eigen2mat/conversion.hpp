@@ -94,6 +94,15 @@ namespace eigen2mat {
       * \return converted value
       */
      real_sp_matrix_t mxArray_to_real_sp_matrix(const mxArray* m);
+     /*!
+      * \brief Convert mxArray to \link definitions::real_sp_rm_matrix_t real_sp_rm_matrix_t\endlink
+      * 
+      * The CSC arrays are transposed into CSR in a single parallel pass.
+      * 
+      * \param m mxArray to convert
+      * \return converted value
+      */
+     real_sp_rm_matrix_t mxArray_to_real_sp_rm_matrix(const mxArray* m);
      /*!
       * \brief Convert mxArray to \link definitions::real_tensor_t real_tensor_t\endlink
       * 
@@ -144,6 +153,15 @@ namespace eigen2mat {
       * \return converted value
       */
      cmplx_sp_matrix_t mxArray_to_cmplx_sp_matrix(const mxArray* m);
+     /*!
+      * \brief Convert mxArray to \link definitions::cmplx_sp_rm_matrix_t cmplx_sp_rm_matrix_t\endlink
+      * 
+      * The CSC arrays are transposed into CSR in a single parallel pass.
+      * 
+      * \param m mxArray to convert
+      * \return converted value
+      */
+     cmplx_sp_rm_matrix_t mxArray_to_cmplx_sp_rm_matrix(const mxArray* m);
      /*!
       * \brief Convert mxArray to \link definitions::cmplx_tensor_t cmplx_tensor_t\endlink
       * 
@@ -226,6 +244,15 @@ namespace eigen2mat {
       * \return mxArray with data stored in it
       */
      mxArray* to_mxArray(const real_sp_matrix_t& m);
+     /*!
+      * \brief Convert \link definitions::real_sp_rm_matrix_t real_sp_rm_matrix_t\endlink to mxArray
+      * 
+      * The CSR arrays are transposed into CSC in a single parallel pass.
+      * 
+      * \param m value to be converted
+      * \return mxArray with data stored in it
+      */
+     mxArray* to_mxArray(const real_sp_rm_matrix_t& m);
      /*!
       * \brief Convert \link definitions::real_tensor_t real_tensor_t\endlink to mxArray
       * 
@@ -248,6 +275,15 @@ namespace eigen2mat {
       * \return mxArray with data stored in it
       */
      mxArray* to_mxArray(const cmplx_sp_matrix_t& m);
+     /*!
+      * \brief Convert \link definitions::cmplx_sp_rm_matrix_t cmplx_sp_rm_matrix_t\endlink to mxArray
+      * 
+      * The CSR arrays are transposed into CSC in a single parallel pass.
+      * 
+      * \param m value to be converted
+      * \return mxArray with data stored in it
+      */
+     mxArray* to_mxArray(const cmplx_sp_rm_matrix_t& m);
      /*!
       * \brief Convert \link definitions::cmplx_tensor_t cmplx_tensor_t\endlink to mxArray
       * 
@@ -273,6 +309,7 @@ namespace eigen2mat {
 } // namespace eigen2mat
 
 #include "details/eigen_expressions_conversions.hpp"
+#include "details/sparse_expressions_conversions.hpp"
 
 // This is still experimental...
 // #include "details/generic_conversions.hpp"
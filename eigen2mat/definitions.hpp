@@ -62,6 +62,8 @@ namespace definitions {
      // Sparse matrices
      typedef Eigen::SparseMatrix<double,   0, int> real_sp_matrix_t;
      typedef Eigen::SparseMatrix<dcomplex, 0, int> cmplx_sp_matrix_t;
+     typedef Eigen::SparseMatrix<double,   Eigen::RowMajor, int> real_sp_rm_matrix_t;
+     typedef Eigen::SparseMatrix<dcomplex, Eigen::RowMajor, int> cmplx_sp_rm_matrix_t;
 
      // Sparse matrix blocks & slices
      typedef Eigen::Block<real_sp_matrix_t> real_spblock_t;
@@ -69,6 +71,13 @@ namespace definitions {
      typedef sparse_slice<real_sp_matrix_t> real_spslice_t;
      typedef sparse_slice<cmplx_sp_matrix_t> cmplx_spslice_t;
 
+     // Dense matrix slices
+     typedef dense_slice<real_matrix_t> real_dslice_t;
+     typedef dense_slice<cmplx_matrix_t> cmplx_dslice_t;
+
+     // Logical masks
+     typedef Eigen::Array<bool, Eigen::Dynamic, Eigen::Dynamic> bool_array_t;
+
      // Tensors
      typedef std::vector<real_matrix_t> real_tensor_t;
      typedef std::vector<cmplx_matrix_t> cmplx_tensor_t;
@@ -92,6 +101,13 @@ namespace definitions {
      typedef Eigen::Map<cmplx_vector_t> cmplx_map_vec_t;
      typedef Eigen::Map<real_matrix_t> real_map_mat_t;
      typedef Eigen::Map<cmplx_matrix_t> cmplx_map_mat_t;     
+
+     //! \brief Operation applied to a matrix operand
+     enum TRANSPOSE_T {
+	  NO_TRANSPOSE, //!< Use the operand as is
+	  TRANSPOSE,    //!< Use the transpose of the operand (.')
+	  CTRANSPOSE    //!< Use the conjugate transpose of the operand (')
+     };
 } // namespace definitions
 
      using namespace definitions;
@@ -99,5 +115,6 @@ namespace definitions {
 
 #include "tensor_block.hpp"
 #include "sparse_slice.hpp"
+#include "dense_slice.hpp"
 
 #endif //EIGEN2MAT_DEFINITIONS_HPP_INCLUDED
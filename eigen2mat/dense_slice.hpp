@@ -0,0 +1,626 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef DENSE_SLICE_HPP_INCLUDED
+#define DENSE_SLICE_HPP_INCLUDED
+
+#include "eigen2mat/utils/macros.hpp"
+#include "eigen2mat/comma_initializer.hpp"
+#include "eigen2mat/sparse_slice_op.hpp"
+#include "eigen2mat/details/op_scope.hpp"
+#include "eigen2mat/utils/parallel.hpp"
+
+#include "eigen2mat/utils/Eigen_Core"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+#ifdef EIGEN2MAT_RANGE_CHECK
+#  include <stdexcept>
+#endif /* EIGEN2MAT_RANGE_CHECK */
+
+MSVC_IGNORE_WARNINGS(4267)
+CLANG_IGNORE_WARNINGS_TWO(-Wshorten-64-to-32,-Wsign-conversion)
+GCC_IGNORE_WARNINGS_ONE(-Wconversion)
+
+namespace eigen2mat {
+     /*!
+      * \brief Class representing a slice A(I,J) of a dense matrix
+      *
+      * Dense counterpart of sparse_slice: s.coeff(i, j) accesses
+      * m.coeff(row_indices[i], col_indices[j]). The underlying matrix must
+      * give direct access to its coefficients (Matrix, Map or Block of
+      * those, with an inner stride of 1).
+      *
+      * The indices along the inner dimension (the rows for column-major
+      * matrices) are analysed once at construction: runs of at least
+      * \c min_run consecutive indices are copied as contiguous blocks, the
+      * remaining ones go through a gather/scatter loop on precomputed
+      * offsets (which the compiler can vectorise). Duplicated inner indices
+      * disable the runs, so that assignments keep the "last wins"
+      * semantics of sparse_slice. Large slices are
+      * processed in parallel over the outer indices, unless those contain
+      * duplicates.
+      *
+      * Slices are usually obtained with the slice() method that is added
+      * to Eigen::MatrixBase through EIGEN_MATRIXBASE_PLUGIN.
+      */
+     template<typename matrix_t>
+     class dense_slice
+     {
+     public:
+	  typedef typename matrix_t::Index Index;
+	  typedef typename matrix_t::Scalar Scalar;
+	  typedef typename matrix_t::PlainObject PlainObject;
+
+	  enum {
+	       IsRowMajor = matrix_t::IsRowMajor
+	  };
+
+	  typedef dense_slice<matrix_t> self_t;
+
+	  //! Minimum length of a run of inner indices copied as a block
+	  static const Index min_run = 4;
+
+	  /*!
+	   * \brief Constructor
+	   *
+	   * \param m matrix to take a slice of
+	   * \param row_indices array of row indices
+	   * \param col_indices array of column indices
+	   */
+	  template <typename index_t>
+	  dense_slice(matrix_t& m,
+		      const std::vector<index_t>& row_indices,
+		      const std::vector<index_t>& col_indices);
+	  /*!
+	   * \brief Constructor
+	   *
+	   * Convenience overload in the case of a single row index.
+	   */
+	  template <typename index_t>
+	  dense_slice(matrix_t& m,
+		      index_t row,
+		      const std::vector<index_t>& col_indices);
+	  /*!
+	   * \brief Constructor
+	   *
+	   * Convenience overload in the case of a single column index.
+	   */
+	  template <typename index_t>
+	  dense_slice(matrix_t& m,
+		      const std::vector<index_t>& row_indices,
+		      index_t col);
+
+	  dense_slice(const self_t&) = default;
+
+	  /*!
+	   * \brief Accessor
+	   *
+	   * \return Number of rows of the slice
+	   */
+	  inline Index rows() const
+	       { return row_indices_.size(); }
+	  /*!
+	   * \brief Accessor
+	   *
+	   * \return Number of columns of the slice
+	   */
+	  inline Index cols() const
+	       { return col_indices_.size(); }
+
+	  /*!
+	   * \brief Coefficient accessor
+	   *
+	   * \param row Index of row (inside the slice)
+	   * \param col Index of column (inside the slice)
+	   * \return Element at given row & column
+	   */
+	  Scalar coeff(Index row, Index col) const
+	       {
+		    assert(mat_);
+		    return mat_->coeff(row_indices_[row], col_indices_[col]);
+	       }
+
+	  /*!
+	   * \brief Coefficient accessor (mutable version)
+	   *
+	   * \param row Index of row (inside the slice)
+	   * \param col Index of column (inside the slice)
+	   * \return Element at given row & column
+	   */
+	  Scalar& coeffRef(Index row, Index col) const
+	       {
+		    assert(mat_);
+		    return mat_->coeffRef(row_indices_[row], col_indices_[col]);
+	       }
+
+	  /*!
+	   * \brief Copy the slice into a new matrix (gather)
+	   *
+	   * \return matrix of size rows() x cols()
+	   */
+	  PlainObject eval() const;
+
+	  // =====================================
+
+	  /*!
+	   * \brief Assignment operator for Eigen::DenseBase (ie. normal Matrices & expressions)
+	   *
+	   * \param rhs matrix or expression to assign
+	   * \return self_t& modified slice instance
+	   */
+	  template <typename Derived>
+	  self_t& operator= (const Eigen::DenseBase<Derived>& rhs)
+	       {
+		    apply_xpr_(rhs.derived(), internal::assign_op());
+		    return *this;
+	       }
+
+	  /*!
+	   * \brief Assignment operator for scalars (ie. A(I,J) = s)
+	   *
+	   * \param s value to assign to every element of the slice
+	   * \return self_t& modified slice instance
+	   */
+	  self_t& operator= (const Scalar& s)
+	       {
+		    apply_scalar_(s, internal::assign_op());
+		    return *this;
+	       }
+
+	  /*!
+	   * \brief Assignment operator for other slices
+	   *
+	   * \param other slice to assign
+	   * \return self_t& modified slice instance
+	   */
+	  self_t& operator= (const self_t& other)
+	       {
+		    const PlainObject tmp(other.eval());
+		    apply_(tmp, internal::assign_op());
+		    return *this;
+	       }
+
+	  // =====================================
+
+	  /*!
+	   * \brief Addition assignment operator for Eigen::DenseBase
+	   *
+	   * \param rhs matrix to add-assign
+	   * \return self_t& modified slice instance
+	   */
+	  template <typename Derived>
+	  self_t& operator+= (const Eigen::DenseBase<Derived>& rhs)
+	       {
+		    apply_xpr_(rhs.derived(), internal::scalar_sum_assign_op());
+		    return *this;
+	       }
+
+	  /*!
+	   * \brief Addition assignment operator for scalars
+	   *
+	   * \param s value to add to every element of the slice
+	   * \return self_t& modified slice instance
+	   */
+	  self_t& operator+= (const Scalar& s)
+	       {
+		    apply_scalar_(s, internal::scalar_sum_assign_op());
+		    return *this;
+	       }
+
+	  /*!
+	   * \brief Addition assignment operator other slices
+	   *
+	   * \param other slice to add-assign
+	   * \return self_t& modified slice instance
+	   */
+	  self_t& operator+= (const self_t& other)
+	       {
+		    const PlainObject tmp(other.eval());
+		    apply_(tmp, internal::scalar_sum_assign_op());
+		    return *this;
+	       }
+
+	  // =====================================
+
+	  /*!
+	   * \brief Subtraction assignment operator for Eigen::DenseBase
+	   *
+	   * \param rhs matrix to subtract-assign
+	   * \return self_t& modified slice instance
+	   */
+	  template <typename Derived>
+	  self_t& operator-= (const Eigen::DenseBase<Derived>& rhs)
+	       {
+		    apply_xpr_(rhs.derived(), internal::scalar_diff_assign_op());
+		    return *this;
+	       }
+
+	  /*!
+	   * \brief Subtraction assignment operator for scalars
+	   *
+	   * \param s value to subtract from every element of the slice
+	   * \return self_t& modified slice instance
+	   */
+	  self_t& operator-= (const Scalar& s)
+	       {
+		    apply_scalar_(s, internal::scalar_diff_assign_op());
+		    return *this;
+	       }
+
+	  /*!
+	   * \brief Subtraction assignment operator for other slices
+	   *
+	   * \param other slice to subtract-assign
+	   * \return self_t& modified slice instance
+	   */
+	  self_t& operator-= (const self_t& other)
+	       {
+		    const PlainObject tmp(other.eval());
+		    apply_(tmp, internal::scalar_diff_assign_op());
+		    return *this;
+	       }
+
+	  // =====================================
+
+	  /*!
+	   * \brief Streaming operator for initialisation
+	   *
+	   * Streaming operator for comma separated initialisation from a scalar.
+	   *
+	   * \param s first scalar to assign to slice
+	   * \return comme initializer proxy
+	   */
+	  comma_initializer<dense_slice> operator<< (const Scalar& s)
+	       {
+		    return comma_initializer<dense_slice>(*this, s);
+	       }
+
+	  /*!
+	   * \brief Streaming operator for initialisation
+	   *
+	   * Streaming operator for comma separated initialisation from an Eigen
+	   * matrix or expression.
+	   *
+	   * \param other first matrix/expression to assign to slice
+	   * \return comme initializer proxy
+	   */
+	  template<typename OtherDerived>
+	  comma_initializer<dense_slice> operator<< (
+	       const Eigen::DenseBase<OtherDerived>& other)
+	       {
+		    return comma_initializer<dense_slice>(*this, other);
+	       }
+
+     private:
+	  //! \brief Expressions are evaluated first (also takes care of aliasing)
+	  template <typename Derived, typename functor_t>
+	  void apply_xpr_(const Eigen::DenseBase<Derived>& rhs, functor_t op)
+	       {
+		    const PlainObject tmp(rhs);
+		    apply_(tmp, op);
+	       }
+
+	  /*!
+	   * \brief Matrices with the same layout are used directly, unless
+	   *        they share their storage with the underlying matrix
+	   */
+	  template <typename functor_t>
+	  void apply_xpr_(const PlainObject& rhs, functor_t op)
+	       {
+		    const Scalar* begin = mat_->data();
+		    const Scalar* end = begin + mat_->outerStride() * outer_size_();
+		    if (rhs.data() + rhs.size() > begin && rhs.data() < end) {
+			 const PlainObject tmp(rhs);
+			 apply_(tmp, op);
+		    }
+		    else {
+			 apply_(rhs, op);
+		    }
+	       }
+
+	  /*!
+	   * \brief Helper function to apply a binary operator coefficient-wise
+	   *        to a slice.
+	   *
+	   * \param other matrix of the same size as the slice
+	   * \param op binary functor
+	   */
+	  template <typename functor_t>
+	  void apply_(const PlainObject& other, functor_t op);
+
+	  //! \brief Same as apply_() with a constant right hand side
+	  template <typename functor_t>
+	  void apply_scalar_(const Scalar& s, functor_t op);
+
+	  /*!
+	   * \brief Call f(o, dst, src_offset) for each outer index o of the
+	   *        slice, where dst points to the outer vector of the matrix
+	   *        (in parallel if the slice is large enough)
+	   */
+	  template <typename kernel_t>
+	  void for_each_outer_(kernel_t f, bool writes) const;
+
+	  //! \brief Number of outer vectors of the underlying matrix
+	  Index outer_size_() const
+	       { return IsRowMajor ? mat_->rows() : mat_->cols(); }
+
+	  //! \brief Indices of the slice along the inner dimension
+	  const std::vector<Index>& inner_indices_() const
+	       { return IsRowMajor ? col_indices_ : row_indices_; }
+	  //! \brief Indices of the slice along the outer dimension
+	  const std::vector<Index>& outer_indices_() const
+	       { return IsRowMajor ? row_indices_ : col_indices_; }
+
+	  //! \brief Checks of the indices and analysis of the inner indices
+	  void init_();
+
+	  matrix_t* mat_; //!< Underlying matrix
+
+	  const std::vector<Index> row_indices_; //!< List of row indices
+	  const std::vector<Index> col_indices_; //!< List of column indices
+
+	  // runs of consecutive inner indices
+	  std::vector<Index> run_pos_;    //!< Position of each run in the slice
+	  std::vector<Index> run_start_;  //!< First inner index of each run
+	  std::vector<Index> run_length_; //!< Length of each run
+	  // remaining (scattered) inner indices
+	  std::vector<Index> scattered_pos_; //!< Position in the slice
+	  std::vector<Index> scattered_idx_; //!< Inner index in the matrix
+
+	  bool unique_outer_; //!< Whether the outer indices are all different
+     };
+
+     // =========================================================================
+
+     namespace internal {
+	  //! Apply a compound assignment to two contiguous ranges
+	  template <typename scalar_t, typename functor_t>
+	  inline void apply_run(scalar_t* dst, const scalar_t* src,
+				std::size_t n, functor_t op)
+	  {
+	       for (std::size_t k(0) ; k < n ; ++k) {
+		    op(dst[k], src[k]);
+	       }
+	  }
+
+	  //! Plain assignment of contiguous ranges is a memory copy
+	  template <typename scalar_t>
+	  inline void apply_run(scalar_t* dst, const scalar_t* src,
+				std::size_t n, assign_op)
+	  {
+	       std::copy(src, src + n, dst);
+	  }
+
+	  // Slices with fewer elements are processed serially
+	  const par_index_t dense_slice_parallel_threshold = 32768;
+     } // namespace internal
+
+     template <typename matrix_t>
+     template <typename index_t>
+     dense_slice<matrix_t>::dense_slice(
+	  matrix_t& m,
+	  const std::vector<index_t>& row_indices,
+	  const std::vector<index_t>& col_indices)
+	  : mat_(&m),
+	    row_indices_(row_indices.begin(), row_indices.end()),
+	    col_indices_(col_indices.begin(), col_indices.end()),
+	    run_pos_(), run_start_(), run_length_(),
+	    scattered_pos_(), scattered_idx_(),
+	    unique_outer_(false)
+     {
+	  init_();
+     }
+
+     template <typename matrix_t>
+     template <typename index_t>
+     dense_slice<matrix_t>::dense_slice(
+	  matrix_t& m,
+	  index_t row,
+	  const std::vector<index_t>& col_indices)
+	  : mat_(&m),
+	    row_indices_(1, row),
+	    col_indices_(col_indices.begin(), col_indices.end()),
+	    run_pos_(), run_start_(), run_length_(),
+	    scattered_pos_(), scattered_idx_(),
+	    unique_outer_(false)
+     {
+	  init_();
+     }
+
+     template <typename matrix_t>
+     template <typename index_t>
+     dense_slice<matrix_t>::dense_slice(
+	  matrix_t& m,
+	  const std::vector<index_t>& row_indices,
+	  index_t col)
+	  : mat_(&m),
+	    row_indices_(row_indices.begin(), row_indices.end()),
+	    col_indices_(1, col),
+	    run_pos_(), run_start_(), run_length_(),
+	    scattered_pos_(), scattered_idx_(),
+	    unique_outer_(false)
+     {
+	  init_();
+     }
+
+     template<typename matrix_t>
+     void dense_slice<matrix_t>::init_()
+     {
+	  e2m_assert(mat_->innerStride() == 1);
+	  for (auto i(0UL) ; i < row_indices_.size() ; ++i) {
+	       e2m_assert(row_indices_[i] >= 0);
+#ifdef EIGEN2MAT_RANGE_CHECK
+	       e2m_assert(row_indices_[i] < mat_->rows());
+	       if (row_indices_[i] >= mat_->rows()) {
+		    throw std::out_of_range("dense_slice: got row index out-of-range");
+	       }
+#endif /* EIGEN2MAT_RANGE_CHECK */
+	  }
+	  for (auto i(0UL) ; i < col_indices_.size() ; ++i) {
+	       e2m_assert(col_indices_[i] >= 0);
+#ifdef EIGEN2MAT_RANGE_CHECK
+	       e2m_assert(col_indices_[i] < mat_->cols());
+	       if (col_indices_[i] >= mat_->cols()) {
+		    throw std::out_of_range("dense_slice: got column index out-of-range");
+	       }
+#endif /* EIGEN2MAT_RANGE_CHECK */
+	  }
+
+	  // split the inner indices into runs & scattered indices. Runs are
+	  // applied before the scattered indices: with duplicated inner
+	  // indices, everything is scattered so that the updates are applied
+	  // in position order (the last assignment wins)
+	  const auto& inner = inner_indices_();
+	  const Index n = inner.size();
+	  bool unique_inner(true);
+	  {
+	       std::vector<Index> sorted(inner);
+	       std::sort(sorted.begin(), sorted.end());
+	       unique_inner = std::adjacent_find(sorted.begin(), sorted.end())
+		    == sorted.end();
+	  }
+	  for (Index k(0) ; k < n ; ) {
+	       Index l(1);
+	       while (unique_inner && k + l < n && inner[k + l] == inner[k] + l) {
+		    ++l;
+	       }
+	       if (l >= min_run) {
+		    run_pos_.push_back(k);
+		    run_start_.push_back(inner[k]);
+		    run_length_.push_back(l);
+	       }
+	       else {
+		    for (Index i(k) ; i < k + l ; ++i) {
+			 scattered_pos_.push_back(i);
+			 scattered_idx_.push_back(inner[i]);
+		    }
+	       }
+	       k += l;
+	  }
+
+	  // parallel updates are only possible without duplicated outer indices
+	  const auto& outer = outer_indices_();
+	  if (static_cast<internal::par_index_t>(rows() * cols())
+	      >= internal::dense_slice_parallel_threshold) {
+	       std::vector<char> seen(outer_size_(), 0);
+	       unique_outer_ = true;
+	       for (auto i(0UL) ; i < outer.size() && unique_outer_ ; ++i) {
+		    unique_outer_ = !seen[outer[i]];
+		    seen[outer[i]] = 1;
+	       }
+	  }
+     }
+
+     template<typename matrix_t>
+     template <typename kernel_t>
+     void dense_slice<matrix_t>::for_each_outer_(kernel_t f, bool writes) const
+     {
+	  const auto& outer = outer_indices_();
+	  const internal::par_index_t n_outer = outer.size();
+	  const Index inner_size = inner_indices_().size();
+	  auto* data = mat_->data();
+	  const auto stride = mat_->outerStride();
+
+	  const bool parallel = (!writes || unique_outer_)
+	       && n_outer * inner_size >= internal::dense_slice_parallel_threshold;
+	  internal::parallel_for(
+	       0, n_outer,
+	       [&](internal::par_index_t o) {
+		    f(data + outer[o] * stride, o * inner_size);
+	       }, parallel ? 2 : n_outer + 1);
+     }
+
+     template<typename matrix_t>
+     typename dense_slice<matrix_t>::PlainObject
+     dense_slice<matrix_t>::eval() const
+     {
+	  E2M_OP_SCOPE(DENSE_SLICE, rows() * cols() * sizeof(Scalar), 1);
+	  PlainObject ret(rows(), cols());
+	  auto* out = ret.data();
+	  for_each_outer_(
+	       [&](const Scalar* src, Index offset) {
+		    auto* dst = out + offset;
+		    for (auto r(0UL) ; r < run_pos_.size() ; ++r) {
+			 internal::apply_run(dst + run_pos_[r],
+					     src + run_start_[r],
+					     run_length_[r],
+					     internal::assign_op());
+		    }
+		    // gather
+		    const auto n = scattered_pos_.size();
+		    const auto* pos = scattered_pos_.data();
+		    const auto* idx = scattered_idx_.data();
+		    for (auto k(0UL) ; k < n ; ++k) {
+			 dst[pos[k]] = src[idx[k]];
+		    }
+	       }, false);
+	  return ret;
+     }
+
+     template<typename matrix_t>
+     template <typename functor_t>
+     void dense_slice<matrix_t>::apply_(const PlainObject& other, functor_t op)
+     {
+	  e2m_assert(mat_);
+	  e2m_assert(rows() == other.rows());
+	  e2m_assert(cols() == other.cols());
+	  E2M_OP_SCOPE(DENSE_SLICE, rows() * cols() * sizeof(Scalar), 0);
+
+	  const auto* in = other.data();
+	  for_each_outer_(
+	       [&](Scalar* dst, Index offset) {
+		    const auto* src = in + offset;
+		    for (auto r(0UL) ; r < run_pos_.size() ; ++r) {
+			 internal::apply_run(dst + run_start_[r],
+					     src + run_pos_[r],
+					     run_length_[r],
+					     op);
+		    }
+		    // scatter
+		    const auto n = scattered_pos_.size();
+		    const auto* pos = scattered_pos_.data();
+		    const auto* idx = scattered_idx_.data();
+		    for (auto k(0UL) ; k < n ; ++k) {
+			 op(dst[idx[k]], src[pos[k]]);
+		    }
+	       }, true);
+     }
+
+     template<typename matrix_t>
+     template <typename functor_t>
+     void dense_slice<matrix_t>::apply_scalar_(const Scalar& s, functor_t op)
+     {
+	  e2m_assert(mat_);
+	  E2M_OP_SCOPE(DENSE_SLICE, rows() * cols() * sizeof(Scalar), 0);
+
+	  for_each_outer_(
+	       [&](Scalar* dst, Index) {
+		    for (auto r(0UL) ; r < run_pos_.size() ; ++r) {
+			 auto* d = dst + run_start_[r];
+			 for (Index k(0) ; k < run_length_[r] ; ++k) {
+			      op(d[k], s);
+			 }
+		    }
+		    const auto n = scattered_idx_.size();
+		    const auto* idx = scattered_idx_.data();
+		    for (auto k(0UL) ; k < n ; ++k) {
+			 op(dst[idx[k]], s);
+		    }
+	       }, true);
+     }
+} // namespace eigen2mat
+
+GCC_RESTORE_WARNINGS
+CLANG_RESTORE_WARNINGS
+MSVC_RESTORE_WARNINGS
+
+#endif /* DENSE_SLICE_HPP_INCLUDED */
@@ -11,6 +11,7 @@
 #define EIGEN_EXPRESSIONS_CONVERSIONS_HPP_INCLUDED
 
 #include "complex_traits.hpp"
+#include "op_scope.hpp"
 
 #include <type_traits>
 
@@ -40,6 +41,8 @@ namespace eigen2mat {
 #endif /* EIGEN2MAT_TYPE_CHECK */
 	  
 	  typedef typename integer_mat_t::Scalar Scalar;
+	  E2M_OP_SCOPE(MXARRAY_TO_REAL_DENSE,
+		       mxGetNumberOfElements(m) * sizeof(Scalar), 1);
 	       
 	  CLANG_IGNORE_WARNINGS_ONE(-Wsign-conversion)
 	  return Eigen::Map<integer_mat_t>(reinterpret_cast<Scalar*>(mxGetPr(m)), 
@@ -89,6 +92,8 @@ namespace eigen2mat {
 #endif /* EIGEN2MAT_TYPE_CHECK */
 
 	  typedef typename real_mat_t::Scalar Scalar;
+	  E2M_OP_SCOPE(MXARRAY_TO_REAL_DENSE,
+		       mxGetNumberOfElements(m) * sizeof(Scalar), 1);
 	       
 	  CLANG_IGNORE_WARNINGS_ONE(-Wsign-conversion)
 	  return Eigen::Map<real_mat_t>(reinterpret_cast<Scalar*>(mxGetPr(m)), 
@@ -147,6 +152,7 @@ namespace eigen2mat {
 #endif /* EIGEN2MAT_TYPE_CHECK */
 
 	  typedef typename real_vec_t::Scalar Scalar;
+	  E2M_OP_SCOPE(MXARRAY_TO_REAL_DENSE, numel * sizeof(Scalar), 1);
 
 	  CLANG_IGNORE_WARNINGS_ONE(-Wsign-conversion)
 	  return Eigen::Map<real_vec_t>(reinterpret_cast<Scalar*>(mxGetPr(m)), numel);
@@ -202,6 +208,8 @@ namespace eigen2mat {
 
 	  const auto rows(mxGetM(m));
 	  const auto cols(mxGetN(m));
+	  E2M_OP_SCOPE(MXARRAY_TO_CMPLX_DENSE,
+		       rows * cols * sizeof(typename cmplx_mat_t::Scalar), 1);
 	  
 	  CLANG_IGNORE_WARNINGS_ONE(-Wsign-conversion)
 	       
@@ -272,6 +280,8 @@ namespace eigen2mat {
 #endif /* EIGEN2MAT_TYPE_CHECK */
 	  
 	  const auto numel(mxGetNumberOfElements(m));
+	  E2M_OP_SCOPE(MXARRAY_TO_CMPLX_DENSE,
+		       numel * sizeof(typename cmplx_vec_t::Scalar), 1);
 
 	  auto* imag_data = mxGetPi(m);
 	  const auto real(Eigen::Map<real_vec_t>(mxGetPr(m), numel));
@@ -305,6 +315,7 @@ namespace eigen2mat {
 	  typedef Eigen::DenseBase<Derived> mat_t;
 	  const auto O = xpr.outerSize();
 	  const auto I = xpr.innerSize();
+	  E2M_OP_SCOPE(TO_MXARRAY_REAL_DENSE, O * I * sizeof(double), 1);
 
 	  auto ret = mxCreateDoubleMatrix(xpr.rows(), xpr.cols(), mxREAL);
 	  auto real = mxGetPr(ret);
@@ -337,6 +348,7 @@ namespace eigen2mat {
      {
 	  const auto M = m.rows();
 	  const auto N = m.cols();
+	  E2M_OP_SCOPE(TO_MXARRAY_REAL_DENSE, M * N * sizeof(double), 1);
 
 	  auto ret = mxCreateDoubleMatrix(M, N, mxREAL);
 	  e2m_assert(ret);
@@ -362,6 +374,7 @@ namespace eigen2mat {
 	  typedef Eigen::DenseBase<Derived> mat_t;
 	  const auto O = xpr.outerSize();
 	  const auto I = xpr.innerSize();
+	  E2M_OP_SCOPE(TO_MXARRAY_CMPLX_DENSE, O * I * sizeof(dcomplex), 1);
 
 	  auto ret = mxCreateDoubleMatrix(xpr.rows(), xpr.cols(), mxCOMPLEX);
 	  e2m_assert(ret);
@@ -402,6 +415,7 @@ namespace eigen2mat {
 	  const size_t M = m.rows();
 	  const size_t N = m.cols();
 	  const size_t S = M * N;
+	  E2M_OP_SCOPE(TO_MXARRAY_CMPLX_DENSE, S * sizeof(dcomplex), 1);
 
 	  auto ret = mxCreateDoubleMatrix(M, N, mxCOMPLEX);
 	  e2m_assert(ret);
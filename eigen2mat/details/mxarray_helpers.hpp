@@ -0,0 +1,496 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef MXARRAY_HELPERS_HPP_INCLUDED
+#define MXARRAY_HELPERS_HPP_INCLUDED
+
+#include "eigen2mat/definitions.hpp"
+#include "eigen2mat/utils/include_mex"
+#include "eigen2mat/utils/macros.hpp"
+#include "eigen2mat/utils/parallel.hpp"
+
+#include <algorithm>
+#include <vector>
+
+MSVC_IGNORE_WARNINGS(4244 4267)
+CLANG_IGNORE_WARNINGS_THREE(-Wundefined-reinterpret-cast,
+			    -Wconversion,
+			    -Wsign-conversion)
+GCC_IGNORE_WARNINGS_ONE(-Wconversion)
+
+namespace eigen2mat {
+     namespace internal {
+	  /*!
+	   * \brief Read the first element of a numeric mxArray as a \c T
+	   *
+	   * \param a mxArray to read from (must contain exactly one element)
+	   * \return converted value
+	   */
+	  template <typename T>
+	  T mxArray_to_single_helper(const mxArray* a)
+	  {
+	       const auto M = mxGetM(a);
+	       const auto N = mxGetN(a);
+
+	       if (M != 1 || N != 1) {
+		    mexErrMsgTxt("Input is not a scalar");
+	       }
+	       else if (M == 0 || N == 0) {
+		    mexErrMsgTxt("Input is empty!");
+	       }
+
+	       mxClassID id = mxGetClassID(a);
+	       T r(0);
+	       // integer T: callers check that the value is integral & in range
+	       // (T = bool compares the value with 0)
+	       GCC_IGNORE_WARNINGS_ONE(-Wfloat-equal)
+	       if (id == mxSINGLE_CLASS) {
+		    r = static_cast<T>(*reinterpret_cast<float*>(mxGetPr(a)));
+	       }
+	       else if (id == mxDOUBLE_CLASS) {
+		    r = static_cast<T>(*mxGetPr(a));
+	       }
+	       else if (id == mxLOGICAL_CLASS) {
+		    r = *reinterpret_cast<mxLogical*>(mxGetPr(a));
+	       }
+	       else if (id == mxINT8_CLASS) {
+		    r = *reinterpret_cast<char*>(mxGetPr(a));
+	       }
+	       else if (id == mxINT16_CLASS) {
+		    r = *reinterpret_cast<short*>(mxGetPr(a));
+	       }
+	       else if (id == mxINT32_CLASS) {
+		    r = *reinterpret_cast<int*>(mxGetPr(a));
+	       }
+	       else if (id == mxINT64_CLASS) {
+		    r = *reinterpret_cast<long long*>(mxGetPr(a));
+	       }
+	       else if (id == mxUINT8_CLASS) {
+		    r = *reinterpret_cast<unsigned char*>(mxGetPr(a));
+	       }
+	       else if (id == mxUINT16_CLASS) {
+		    r = *reinterpret_cast<unsigned short*>(mxGetPr(a));
+	       }
+	       else if (id == mxUINT32_CLASS) {
+		    r = *reinterpret_cast<unsigned int*>(mxGetPr(a));
+	       }
+	       else if (id == mxUINT64_CLASS) {
+		    r = *reinterpret_cast<unsigned long long*>(mxGetPr(a));
+	       }
+	       else {
+		    mexErrMsgTxt("mxArray_to_single_helper(): argument is not numeric!");
+	       }
+	       GCC_RESTORE_WARNINGS
+
+	       return r;
+	  }
+
+
+	  /*!
+	   * \brief Copy SIZE elements from a to dest, whatever the class of a
+	   *
+	   * \param a numeric mxArray to copy from
+	   * \param SIZE number of elements to copy
+	   * \param dest output iterator
+	   */
+	  template <typename pointer_t>
+	  void copy_from_mxArray_helper(const mxArray* a,
+					eigen2mat::size_t SIZE,
+					pointer_t dest)
+	  {
+	       mxClassID id = mxGetClassID(a);
+	       if (id == mxSINGLE_CLASS) {
+		    float* data = reinterpret_cast<float*>(mxGetPr(a));
+		    std::copy(data, data + SIZE, dest);
+	       }
+	       else if ( id == mxDOUBLE_CLASS) {
+		    double* data = mxGetPr(a);
+		    std::copy(data, data + SIZE, dest);
+	       }
+	       else if (id == mxINT8_CLASS) {
+		    char* data = reinterpret_cast<char*>(mxGetPr(a));
+		    std::copy(data, data + SIZE, dest);
+	       }
+	       else if (id == mxINT16_CLASS) {
+		    short* data = reinterpret_cast<short*>(mxGetPr(a));
+		    std::copy(data, data + SIZE, dest);
+	       }
+	       else if (id == mxINT32_CLASS) {
+		    int* data = reinterpret_cast<int*>(mxGetPr(a));
+		    std::copy(data, data + SIZE, dest);
+	       }
+	       else if (id == mxINT64_CLASS) {
+		    long long* data = reinterpret_cast<long long*>(mxGetPr(a));
+		    std::copy(data, data + SIZE, dest);
+	       }
+	       else if (id == mxUINT8_CLASS) {
+		    unsigned char* data =
+			 reinterpret_cast<unsigned char*>(mxGetPr(a));
+		    std::copy(data, data + SIZE, dest);
+	       }
+	       else if (id == mxUINT16_CLASS) {
+		    unsigned short* data =
+			 reinterpret_cast<unsigned short*>(mxGetPr(a));
+		    std::copy(data, data + SIZE, dest);
+	       }
+	       else if (id == mxUINT32_CLASS) {
+		    unsigned int* data = reinterpret_cast<unsigned int*>(mxGetPr(a));
+		    std::copy(data, data + SIZE, dest);
+	       }
+	       else if (id == mxUINT64_CLASS) {
+		    unsigned long long* data =
+			 reinterpret_cast<unsigned long long*>(mxGetPr(a));
+		    std::copy(data, data + SIZE, dest);
+	       }
+	       else {
+		    mexErrMsgTxt("copy_from_mxArray_helper(): argument is not numeric!");
+	       }
+	  }
+
+	  //! Copy real values (plain std::copy)
+	  inline void copy_values(const double* pr, const double*,
+				       std::size_t nnz, double* out)
+	  {
+	       std::copy(pr, pr + nnz, out);
+	  }
+
+	  //! Merge split real/imaginary MATLAB storage into complex values
+	  inline void copy_values(const double* pr, const double* pi,
+				       std::size_t nnz, dcomplex* out)
+	  {
+	       if (pi == nullptr) {
+		    for (std::size_t i(0) ; i < nnz ; ++i) {
+			 out[i] = dcomplex(pr[i], 0.0);
+		    }
+	       }
+	       else {
+		    for (std::size_t i(0) ; i < nnz ; ++i) {
+			 out[i] = dcomplex(pr[i], pi[i]);
+		    }
+	       }
+	  }
+
+	  /*!
+	   * \brief Copy MATLAB CSC arrays into an Eigen sparse matrix
+	   *
+	   * MATLAB guarantees that the row indices are sorted & unique inside
+	   * each column so that we can fill the compressed storage of \c out
+	   * directly instead of going through triplets.
+	   *
+	   * This function does not call any function of the MEX API, it is
+	   * therefore safe to call it from any thread.
+	   *
+	   * \param M number of rows
+	   * \param N number of columns
+	   * \param pr real part of the values
+	   * \param pi imaginary part of the values (may be \c nullptr)
+	   * \param ir row indices
+	   * \param jc column pointers
+	   * \param out matrix to fill
+	   */
+	  template <typename sp_matrix_t>
+	  void csc_to_eigen(mwSize M, mwSize N,
+			    const double* pr, const double* pi,
+			    const mwIndex* ir, const mwIndex* jc,
+			    sp_matrix_t& out)
+	  {
+	       const auto nnz = jc[N];
+	       out.resize(M, N);
+	       out.resizeNonZeros(nnz);
+
+	       std::copy(jc, jc + N + 1, out.outerIndexPtr());
+	       std::copy(ir, ir + nnz, out.innerIndexPtr());
+	       copy_values(pr, pi, nnz, out.valuePtr());
+	  }
+
+	  //! Overload of csc_to_eigen() taking an mxArray
+	  template <typename sp_matrix_t>
+	  void csc_to_eigen(const mxArray* a, sp_matrix_t& out)
+	  {
+	       csc_to_eigen(mxGetM(a), mxGetN(a),
+			    mxGetPr(a), mxGetPi(a),
+			    mxGetIr(a), mxGetJc(a),
+			    out);
+	  }
+
+	  //! Copy real values (plain std::copy)
+	  inline void split_values(const double* in, std::size_t nnz,
+				   double* pr, double*)
+	  {
+	       std::copy(in, in + nnz, pr);
+	  }
+
+	  //! Split complex values into MATLAB's real/imaginary storage
+	  inline void split_values(const dcomplex* in, std::size_t nnz,
+				   double* pr, double* pi)
+	  {
+	       for (std::size_t i(0) ; i < nnz ; ++i) {
+		    pr[i] = in[i].real();
+		    pi[i] = in[i].imag();
+	       }
+	  }
+
+	  /*!
+	   * \brief Copy an Eigen sparse matrix into MATLAB CSC arrays
+	   *
+	   * Counterpart of csc_to_eigen(). The destination arrays must be
+	   * large enough to hold \c m.nonZeros() elements (and \c m.cols()+1
+	   * column pointers) and \c jc must be zero-initialised (as returned
+	   * by mxCreateSparse). Works for compressed and uncompressed
+	   * matrices.
+	   *
+	   * This function does not call any function of the MEX API, it is
+	   * therefore safe to call it from any thread.
+	   *
+	   * \param m matrix to copy
+	   * \param pr real part of the values
+	   * \param pi imaginary part of the values (ignored for real matrices)
+	   * \param ir row indices
+	   * \param jc column pointers
+	   */
+	  template <typename sp_matrix_t>
+	  void eigen_to_csc(const sp_matrix_t& m,
+			    double* pr, double* pi,
+			    mwIndex* ir, mwIndex* jc)
+	  {
+	       const std::size_t nnz = m.nonZeros();
+	       if (nnz == 0) {
+		    return;
+	       }
+
+	       const auto* values = m.valuePtr();
+	       const auto* inner = m.innerIndexPtr();
+	       const auto* outer = m.outerIndexPtr();
+
+	       if (m.isCompressed()) {
+		    // matrix is compressed => easy !
+		    split_values(values, nnz, pr, pi);
+		    std::copy(inner, inner + nnz, ir);
+		    std::copy(outer, outer + m.outerSize() + 1, jc);
+	       }
+	       else {
+		    /*
+		     * Matrix not in compressed mode => pain in the #@!%#!
+		     *
+		     * Basically the problem is that the inner index array of
+		     * the matrix 'm' is not contiguous, it has holes:
+		     *    values: 22 7 _ 3 5 14 _ _ 1 _ 17 8
+		     *    inner:   1 2 _ 0 2  4 _ _ 2 _  1 4
+		     *    outer:   0 3 5 8 10 12
+		     *    innz:    2 2 1 1 2
+		     * where _ are empty elements for fast insertion (cf. Eigen
+		     * doc)
+		     *
+		     * And then we still need to correct the outer index array...
+		     *
+		     * The new outer index array is the prefix sum of innz; once
+		     * it is known, each column is copied as one block,
+		     * independently of the others.
+		     */
+		    const par_index_t N = m.outerSize();
+		    const auto* inz = m.innerNonZeroPtr();
+		    parallel_exclusive_scan(N, inz, jc);
+		    e2m_assert(jc[N] == nnz);
+
+		    // chunks of columns with ~32k non-zeros each on average
+		    const auto n_chunks = std::min(
+			 num_chunks(static_cast<par_index_t>(nnz), 32768), N);
+		    parallel_for(
+			 0, n_chunks,
+			 [&](par_index_t c) {
+			      par_index_t begin(0), end(0);
+			      chunk_range(N, n_chunks, c, begin, end);
+			      for (auto o_idx(begin) ; o_idx < end ; ++o_idx) {
+				   const auto i = jc[o_idx];
+				   const auto n = jc[o_idx+1] - i;
+				   const auto k = outer[o_idx];
+				   split_values(values + k, n, pr + i,
+						pi == nullptr ? nullptr : pi + i);
+				   std::copy(inner + k, inner + k + n, ir + i);
+			      }
+			 });
+	       }
+	  }
+
+	  /*!
+	   * \brief Allocate a MATLAB sparse matrix from its column pointers
+	   *
+	   * The matrix is allocated with exactly \c col_ptr[N] non-zeros and
+	   * \c col_ptr is copied into its Jc array; Ir and Pr(/Pi) are left
+	   * for the caller to fill.
+	   *
+	   * \param M number of rows
+	   * \param N number of columns
+	   * \param col_ptr column pointers (N+1 elements)
+	   * \param is_cmplx whether the matrix is complex
+	   * \return MATLAB sparse matrix
+	   */
+	  template <typename index_t>
+	  mxArray* create_sparse(mwSize M, mwSize N,
+				 const index_t* col_ptr, bool is_cmplx)
+	  {
+	       auto* ret = mxCreateSparse(M, N, static_cast<mwSize>(col_ptr[N]),
+					  is_cmplx ? mxCOMPLEX : mxREAL);
+	       e2m_assert(ret);
+	       e2m_assert(mxGetPr(ret));
+	       e2m_assert(mxGetIr(ret));
+	       e2m_assert(mxGetJc(ret));
+	       std::copy(col_ptr, col_ptr + N + 1, mxGetJc(ret));
+	       return ret;
+	  }
+
+	  /*!
+	   * \brief Allocate a MATLAB sparse matrix from its column counts
+	   *
+	   * Same as create_sparse() but the column pointers are computed
+	   * (in parallel) from the number of non-zeros of each column.
+	   *
+	   * \param M number of rows
+	   * \param N number of columns
+	   * \param counts number of non-zeros of each column (N elements)
+	   * \param is_cmplx whether the matrix is complex
+	   * \return MATLAB sparse matrix
+	   */
+	  template <typename count_t>
+	  mxArray* create_sparse_from_counts(mwSize M, mwSize N,
+					     const count_t* counts,
+					     bool is_cmplx)
+	  {
+	       std::vector<mwIndex> col_ptr(N + 1);
+	       parallel_exclusive_scan(static_cast<par_index_t>(N), counts,
+				       col_ptr.data());
+	       return create_sparse(M, N, col_ptr.data(), is_cmplx);
+	  }
+
+	  /*!
+	   * \brief Range of the stored elements of column j of an Eigen sparse
+	   *        matrix, whether it is compressed or not
+	   *
+	   * \param m sparse matrix (column-major)
+	   * \param j column index
+	   * \param begin position of the first element of the column
+	   * \param end position one past the last element of the column
+	   */
+	  template <typename sp_matrix_t>
+	  void column_range(const sp_matrix_t& m, eigen2mat::size_t j,
+			    int& begin, int& end)
+	  {
+	       begin = m.outerIndexPtr()[j];
+	       end = m.isCompressed()
+		    ? m.outerIndexPtr()[j+1]
+		    : begin + m.innerNonZeroPtr()[j];
+	  }
+
+	  /*!
+	   * \brief Transpose compressed storage, ie. convert between CSC and
+	   *        CSR
+	   *
+	   * The outer vectors of the source are split into one chunk per
+	   * thread. Each thread counts the elements of its chunk in each
+	   * outer vector of the result; the counts are then turned into
+	   * offsets and each thread scatters its chunk. Since the chunks are
+	   * scattered at increasing offsets, the inner indices of the result
+	   * are sorted.
+	   *
+	   * This function does not call any function of the MEX API, it is
+	   * therefore safe to call it from any thread.
+	   *
+	   * \param n_outer number of outer vectors of the source
+	   * \param n_inner inner size of the source (ie. number of outer
+	   *                vectors of the result)
+	   * \param outer outer index array of the source
+	   * \param inz number of non-zeros of each outer vector of the source
+	   *            (\c nullptr if compressed)
+	   * \param inner inner index array of the source
+	   * \param t_outer outer index array of the result (n_inner + 1)
+	   * \param t_inner inner index array of the result
+	   * \param copy copy(k, p) copies value k of the source to value p of
+	   *             the result
+	   */
+	  template <typename src_index_t, typename dst_index_t, typename copy_t>
+	  void transpose_compressed(std::size_t n_outer, std::size_t n_inner,
+				    const src_index_t* outer,
+				    const src_index_t* inz,
+				    const src_index_t* inner,
+				    dst_index_t* t_outer, dst_index_t* t_inner,
+				    copy_t copy)
+	  {
+	       const par_index_t N = n_outer;
+	       const par_index_t M = n_inner;
+	       const auto end_of = [&](par_index_t o) {
+		    return inz == nullptr ? outer[o+1] : outer[o] + inz[o];
+	       };
+
+	       std::size_t nnz(0);
+	       if (inz == nullptr) {
+		    nnz = outer[N];
+	       }
+	       else {
+		    for (par_index_t o(0) ; o < N ; ++o) {
+			 nnz += inz[o];
+		    }
+	       }
+	       const auto n_chunks = std::max<par_index_t>(
+		    1, std::min(num_chunks(static_cast<par_index_t>(nnz), 32768), N));
+
+	       // 1. per chunk counts
+	       std::vector<std::size_t> offsets(n_chunks * M, 0);
+	       parallel_for(
+		    0, n_chunks,
+		    [&](par_index_t c) {
+			 par_index_t begin(0), end(0);
+			 chunk_range(N, n_chunks, c, begin, end);
+			 auto* count = offsets.data() + c * M;
+			 for (auto o(begin) ; o < end ; ++o) {
+			      for (auto k(outer[o]) ; k < end_of(o) ; ++k) {
+				   ++count[inner[k]];
+			      }
+			 }
+		    });
+
+	       // 2. offsets of each chunk, then outer index array
+	       std::vector<std::size_t> sizes(M);
+	       parallel_for(
+		    0, M,
+		    [&](par_index_t i) {
+			 std::size_t sum(0);
+			 for (par_index_t c(0) ; c < n_chunks ; ++c) {
+			      const auto n = offsets[c * M + i];
+			      offsets[c * M + i] = sum;
+			      sum += n;
+			 }
+			 sizes[i] = sum;
+		    }, 4096);
+	       parallel_exclusive_scan(M, sizes.data(), t_outer);
+
+	       // 3. scatter
+	       parallel_for(
+		    0, n_chunks,
+		    [&](par_index_t c) {
+			 par_index_t begin(0), end(0);
+			 chunk_range(N, n_chunks, c, begin, end);
+			 auto* offset = offsets.data() + c * M;
+			 for (auto o(begin) ; o < end ; ++o) {
+			      for (auto k(outer[o]) ; k < end_of(o) ; ++k) {
+				   const auto i = inner[k];
+				   const auto p = t_outer[i] + offset[i]++;
+				   t_inner[p] = o;
+				   copy(k, p);
+			      }
+			 }
+		    });
+	  }
+     } // namespace internal
+} // namespace eigen2mat
+
+GCC_RESTORE_WARNINGS
+CLANG_RESTORE_WARNINGS
+MSVC_RESTORE_WARNINGS
+
+#endif /* MXARRAY_HELPERS_HPP_INCLUDED */
@@ -0,0 +1,48 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef NAN_OPS_HPP_INCLUDED
+#define NAN_OPS_HPP_INCLUDED
+
+#include <cmath>
+
+namespace eigen2mat {
+     namespace internal {
+	  /*!
+	   * \brief max(a, b) ignoring NaN values, as MATLAB's max
+	   *
+	   * NaN is only returned if both values are NaN, so that a reduction
+	   * gives the same result whatever the order of its values.
+	   */
+	  inline double nan_max(double a, double b)
+	  {
+	       return std::isnan(a) || b > a ? b : a;
+	  }
+
+	  //! min(a, b) ignoring NaN values, as MATLAB's min
+	  inline double nan_min(double a, double b)
+	  {
+	       return std::isnan(a) || b < a ? b : a;
+	  }
+
+	  //! nan_max() as a functor (for Eigen's redux() & binaryExpr())
+	  struct nan_max_op
+	  {
+	       double operator()(double a, double b) const {return nan_max(a, b);}
+	  };
+
+	  //! nan_min() as a functor (for Eigen's redux() & binaryExpr())
+	  struct nan_min_op
+	  {
+	       double operator()(double a, double b) const {return nan_min(a, b);}
+	  };
+     } // namespace internal
+} // namespace eigen2mat
+
+#endif /* NAN_OPS_HPP_INCLUDED */
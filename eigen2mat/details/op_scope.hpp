@@ -0,0 +1,95 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OP_SCOPE_HPP_INCLUDED
+#define OP_SCOPE_HPP_INCLUDED
+
+#include "eigen2mat/stats.hpp"
+#include "eigen2mat/trace.hpp"
+
+#if defined(EIGEN2MAT_STATS) || defined(EIGEN2MAT_TRACE)
+namespace eigen2mat {
+     namespace internal {
+	  /*!
+	   * \brief RAII helper recording one call of an operation
+	   *
+	   * Feeds the statistics counters (if \c EIGEN2MAT_STATS is defined)
+	   * and the trace buffers (if \c EIGEN2MAT_TRACE is defined and tracing
+	   * was started). Timings are inclusive: nested operations (eg. the
+	   * conversion of each element of a cell array) are also accounted for
+	   * in the enclosing operation.
+	   */
+	  class op_scope_t
+	  {
+	  public:
+	       op_scope_t(stats::op_t op,
+			  unsigned long long bytes,
+			  unsigned long long allocations)
+		    : op_(op), bytes_(bytes), allocations_(allocations)
+#ifdef EIGEN2MAT_STATS
+		    , start_cycles_(stats::read_cycles())
+#endif /* EIGEN2MAT_STATS */
+#ifdef EIGEN2MAT_TRACE
+		    , traced_(trace::is_active())
+		    , start_ns_(traced_ ? trace::now() : 0)
+#endif /* EIGEN2MAT_TRACE */
+		    {}
+
+	       ~op_scope_t()
+		    {
+#ifdef EIGEN2MAT_STATS
+			 stats::record(op_, bytes_, allocations_,
+				       stats::read_cycles() - start_cycles_);
+#endif /* EIGEN2MAT_STATS */
+#ifdef EIGEN2MAT_TRACE
+			 if (traced_) {
+			      trace::record(op_, bytes_, start_ns_, trace::now());
+			 }
+#endif /* EIGEN2MAT_TRACE */
+		    }
+
+	  private:
+	       op_scope_t(const op_scope_t&);
+	       op_scope_t& operator=(const op_scope_t&);
+
+	       const stats::op_t op_;
+	       const unsigned long long bytes_;
+	       const unsigned long long allocations_;
+#ifdef EIGEN2MAT_STATS
+	       const unsigned long long start_cycles_;
+#endif /* EIGEN2MAT_STATS */
+#ifdef EIGEN2MAT_TRACE
+	       const bool traced_;
+	       const unsigned long long start_ns_;
+#endif /* EIGEN2MAT_TRACE */
+	  };
+     } // namespace internal
+} // namespace eigen2mat
+#endif /* EIGEN2MAT_STATS || EIGEN2MAT_TRACE */
+
+/*!
+ * \brief Record one call to an operation of eigen2mat for the remaining of
+ *        the current scope
+ *
+ * Expands to nothing unless \c EIGEN2MAT_STATS or \c EIGEN2MAT_TRACE is
+ * defined.
+ *
+ * \param op operation (member of eigen2mat::stats::op_t)
+ * \param bytes number of bytes copied
+ * \param allocs number of objects allocated
+ */
+#if defined(EIGEN2MAT_STATS) || defined(EIGEN2MAT_TRACE)
+#  define E2M_OP_SCOPE(op, bytes, allocs)				\
+     const eigen2mat::internal::op_scope_t e2m_op_scope_(		\
+	  eigen2mat::stats::op, (bytes), (allocs))
+#else
+#  define E2M_OP_SCOPE(op, bytes, allocs)
+#endif /* EIGEN2MAT_STATS || EIGEN2MAT_TRACE */
+
+#endif /* OP_SCOPE_HPP_INCLUDED */
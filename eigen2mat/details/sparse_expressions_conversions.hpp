@@ -0,0 +1,328 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef SPARSE_EXPRESSIONS_CONVERSIONS_HPP_INCLUDED
+#define SPARSE_EXPRESSIONS_CONVERSIONS_HPP_INCLUDED
+
+#include "complex_traits.hpp"
+#include "mxarray_helpers.hpp"
+#include "op_scope.hpp"
+#include "eigen2mat/utils/parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <type_traits>
+#include <vector>
+
+namespace eigen2mat {
+     namespace internal {
+	  /*!
+	   * \brief Traversal of the non-zeros of a sparse expression
+	   *
+	   * Eigen 3.2 iterates directly over expressions while Eigen 3.3 and
+	   * later go through an evaluator.
+	   */
+#if EIGEN_VERSION_AT_LEAST(3,2,90)
+	  template <typename Derived>
+	  struct sparse_traversal_t
+	  {
+	       typedef Eigen::internal::evaluator<Derived> evaluator_t;
+	       typedef typename evaluator_t::InnerIterator iterator_t;
+	  };
+#else
+	  template <typename Derived>
+	  struct sparse_traversal_t
+	  {
+	       typedef const Derived& evaluator_t;
+	       typedef typename Derived::InnerIterator iterator_t;
+	  };
+#endif /* EIGEN_VERSION_AT_LEAST(3,2,90) */
+
+	  /*!
+	   * \brief Type to use to access the coefficients of a dense expression
+	   *        several times (expensive expressions get evaluated once)
+	   */
+#if EIGEN_VERSION_AT_LEAST(3,2,90)
+	  template <typename Derived>
+	  struct dense_nested_t
+	  {
+	       typedef typename Eigen::internal::nested_eval<Derived, 2>::type type;
+	  };
+#else
+	  template <typename Derived>
+	  struct dense_nested_t
+	  {
+	       typedef typename Eigen::internal::nested<Derived, 2>::type type;
+	  };
+#endif /* EIGEN_VERSION_AT_LEAST(3,2,90) */
+
+	  //! Store a real value into MATLAB storage
+	  template <typename T>
+	  inline void store_value(double* pr, double*, std::size_t i, const T& v)
+	  {
+	       pr[i] = static_cast<double>(v);
+	  }
+
+	  //! Store a complex value into MATLAB's split real/imaginary storage
+	  template <typename T>
+	  inline void store_value(double* pr, double* pi, std::size_t i,
+				  const std::complex<T>& v)
+	  {
+	       pr[i] = static_cast<double>(v.real());
+	       pi[i] = static_cast<double>(v.imag());
+	  }
+
+	  //! Keep every stored element
+	  struct keep_all_t
+	  {
+	       template <typename T>
+	       bool operator()(const T&) const
+		    {
+			 return true;
+		    }
+	  };
+
+	  //! Keep the elements with a magnitude strictly above a tolerance (and NaNs)
+	  struct keep_above_t
+	  {
+	       explicit keep_above_t(double tol) : tol_(tol) {}
+
+	       template <typename T>
+	       bool operator()(const T& v) const
+		    {
+			 // NaNs are kept (as MATLAB's sparse() does)
+			 return !(std::abs(v) <= tol_);
+		    }
+
+	       const double tol_;
+	  };
+
+	  /*!
+	   * \brief Evaluate a sparse expression into a new MATLAB sparse matrix
+	   *
+	   * The expression is traversed twice: once to count the non-zeros of
+	   * each column (so that the mxArray is allocated once with the exact
+	   * nzmax) and once to write the values straight into its Ir/Jc/Pr(/Pi)
+	   * arrays. For column-major expressions both passes run in parallel
+	   * over the columns; row-major expressions (eg. the transpose of a
+	   * column-major matrix) are scattered column-wise serially.
+	   *
+	   * \param xpr expression to convert
+	   * \param keep predicate on the values; elements for which it returns
+	   *             false are not exported
+	   * \param op operation recorded by the statistics
+	   * \return MATLAB sparse matrix
+	   */
+	  template <typename Derived, typename keep_t>
+	  mxArray* sparse_xpr_to_mxArray(const Eigen::SparseMatrixBase<Derived>& xpr,
+					 const keep_t& keep,
+					 stats::op_t op)
+	  {
+	       typedef typename Derived::Scalar Scalar;
+	       typedef typename sparse_traversal_t<Derived>::evaluator_t evaluator_t;
+	       typedef typename sparse_traversal_t<Derived>::iterator_t iterator_t;
+	       const bool is_cmplx = complex_traits<Scalar>::is_cmplx;
+	       const bool row_major = (Derived::Flags & Eigen::RowMajorBit) != 0;
+
+	       const par_index_t M = xpr.rows();
+	       const par_index_t N = xpr.cols();
+	       const par_index_t O = xpr.outerSize();
+
+	       evaluator_t eval(xpr.derived());
+
+	       // symbolic pass: number of non-zeros in each column
+	       std::vector<mwIndex> counts(N, 0);
+	       if (row_major) {
+		    for (par_index_t o(0) ; o < O ; ++o) {
+			 for (iterator_t it(eval, o) ; it ; ++it) {
+			      if (keep(it.value())) {
+				   ++counts[it.index()];
+			      }
+			 }
+		    }
+	       }
+	       else {
+		    parallel_for_dynamic(
+			 0, O,
+			 [&](par_index_t o) {
+			      mwIndex n(0);
+			      for (iterator_t it(eval, o) ; it ; ++it) {
+				   if (keep(it.value())) {
+					++n;
+				   }
+			      }
+			      counts[o] = n;
+			 }, 256);
+	       }
+	       auto* ret = create_sparse_from_counts(M, N, counts.data(), is_cmplx);
+	       auto* pr = mxGetPr(ret);
+	       auto* pi = mxGetPi(ret);
+	       auto* ir = mxGetIr(ret);
+	       const auto* jc = mxGetJc(ret);
+
+#if defined(EIGEN2MAT_STATS) || defined(EIGEN2MAT_TRACE)
+	       const op_scope_t scope(op,
+				      jc[N] * ((is_cmplx ? 2 : 1) * sizeof(double)
+					       + sizeof(mwIndex))
+				      + (N + 1) * sizeof(mwIndex),
+				      1);
+#else
+	       (void) op;
+#endif /* EIGEN2MAT_STATS || EIGEN2MAT_TRACE */
+
+	       // numeric pass
+	       if (row_major) {
+		    // rows are visited in order => row indices sorted in each column
+		    // (counts is reused for the next free position of each column)
+		    std::copy(jc, jc + N, counts.begin());
+		    for (par_index_t o(0) ; o < O ; ++o) {
+			 for (iterator_t it(eval, o) ; it ; ++it) {
+			      const Scalar v = it.value();
+			      if (keep(v)) {
+				   const auto k = counts[it.index()]++;
+				   ir[k] = o;
+				   store_value(pr, pi, k, v);
+			      }
+			 }
+		    }
+	       }
+	       else {
+		    parallel_for_dynamic(
+			 0, O,
+			 [&](par_index_t o) {
+			      auto k = jc[o];
+			      for (iterator_t it(eval, o) ; it ; ++it) {
+				   const Scalar v = it.value();
+				   if (keep(v)) {
+					ir[k] = it.index();
+					store_value(pr, pi, k++, v);
+				   }
+			      }
+			 }, 256);
+	       }
+	       return ret;
+	  }
+     } // namespace internal
+
+     /*!
+      * \brief Convert sparse matrices & expressions (eg. <tt>A + B</tt>,
+      *        <tt>A * s</tt>, <tt>A.transpose()</tt> or blocks) to mxArray
+      *
+      * The expression is evaluated directly into the MATLAB array, without
+      * any temporary Eigen::SparseMatrix.
+      *
+      * \param xpr matrix/expression to convert
+      * \return converted value
+      */
+     template<typename Derived>
+     mxArray* to_mxArray(const Eigen::SparseMatrixBase<Derived>& xpr)
+     {
+	  return internal::sparse_xpr_to_mxArray(xpr,
+						 internal::keep_all_t(),
+						 stats::TO_MXARRAY_SPARSE_XPR);
+     }
+
+     /*!
+      * \brief Convert sparse matrices & expressions to mxArray, dropping the
+      *        elements with a magnitude smaller than or equal to \c tol
+      *
+      * MATLAB sparse arrays should not hold explicit zeros; with the default
+      * tolerance only those are removed. NaNs are always kept (as with
+      * MATLAB's sparse()). The elements are filtered while
+      * copying, no pruned copy of the expression is made.
+      *
+      * \param xpr matrix/expression to convert
+      * \param tol tolerance (>= 0)
+      * \return converted value
+      */
+     template<typename Derived>
+     mxArray* prune_to_mxArray(const Eigen::SparseMatrixBase<Derived>& xpr,
+			       double tol = 0.)
+     {
+	  if (tol < 0) {
+	       mexErrMsgIdAndTxt("eigen2mat:invalid_argument",
+				 "prune_to_mxArray(): tolerance must be >= 0");
+	  }
+	  return internal::sparse_xpr_to_mxArray(xpr,
+						 internal::keep_above_t(tol),
+						 stats::TO_MXARRAY_SPARSE_XPR);
+     }
+
+     /*!
+      * \brief Convert dense matrices & expressions to a MATLAB sparse matrix
+      *
+      * Only the elements with a magnitude strictly greater than \c tol (and
+      * NaNs) are exported. The non-zeros of each column are first counted
+      * (vectorised) so that the mxArray is allocated once with the exact
+      * nzmax, then the elements are written straight into it; both passes
+      * run in parallel over the columns. Expensive expressions (eg. products) are evaluated
+      * once beforehand.
+      *
+      * \param xpr matrix/expression to convert
+      * \param tol tolerance (>= 0)
+      * \return converted value
+      */
+     template<typename Derived>
+     mxArray* dense_to_sparse_mxArray(const Eigen::DenseBase<Derived>& xpr,
+				      double tol = 0.)
+     {
+	  typedef typename Derived::Scalar Scalar;
+	  typedef typename internal::dense_nested_t<Derived>::type nested_t;
+	  const bool is_cmplx = internal::complex_traits<Scalar>::is_cmplx;
+
+	  if (tol < 0) {
+	       mexErrMsgIdAndTxt("eigen2mat:invalid_argument",
+				 "dense_to_sparse_mxArray(): tolerance must be >= 0");
+	  }
+
+	  nested_t m(xpr.derived());
+	  const internal::par_index_t M = m.rows();
+	  const internal::par_index_t N = m.cols();
+	  const internal::par_index_t min_size = std::max<internal::par_index_t>(
+	       2, 32768 / std::max<internal::par_index_t>(M, 1));
+
+	  // count pass
+	  std::vector<mwIndex> counts(N);
+	  internal::parallel_for(
+	       0, N,
+	       [&](internal::par_index_t j) {
+		    counts[j] = m.col(j).size()
+			 - (m.col(j).array().abs() <= tol).count();
+	       }, min_size);
+	  auto* ret = internal::create_sparse_from_counts(M, N, counts.data(),
+							  is_cmplx);
+	  auto* pr = mxGetPr(ret);
+	  auto* pi = mxGetPi(ret);
+	  auto* ir = mxGetIr(ret);
+	  const auto* jc = mxGetJc(ret);
+
+	  E2M_OP_SCOPE(TO_MXARRAY_DENSE_TO_SPARSE,
+		       jc[N] * ((is_cmplx ? 2 : 1) * sizeof(double) + sizeof(mwIndex))
+		       + (N + 1) * sizeof(mwIndex),
+		       1);
+
+	  // fill pass
+	  internal::parallel_for(
+	       0, N,
+	       [&](internal::par_index_t j) {
+		    auto k = jc[j];
+		    for (internal::par_index_t i(0) ; i < M ; ++i) {
+			 const Scalar v = m.coeff(i, j);
+			 if (!(std::abs(v) <= tol)) {
+			      ir[k] = i;
+			      internal::store_value(pr, pi, k++, v);
+			 }
+		    }
+	       }, min_size);
+	  return ret;
+     }
+} // namespace eigen2mat
+
+#endif /* SPARSE_EXPRESSIONS_CONVERSIONS_HPP_INCLUDED */
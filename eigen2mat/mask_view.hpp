@@ -0,0 +1,649 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef MASK_VIEW_HPP_INCLUDED
+#define MASK_VIEW_HPP_INCLUDED
+
+#include "eigen2mat/definitions.hpp"
+#include "eigen2mat/sparse_slice_op.hpp"
+#include "eigen2mat/details/op_scope.hpp"
+#include "eigen2mat/utils/include_mex"
+#include "eigen2mat/utils/macros.hpp"
+#include "eigen2mat/utils/parallel.hpp"
+
+#include <cstring>
+#include <vector>
+
+MSVC_IGNORE_WARNINGS(4267)
+CLANG_IGNORE_WARNINGS_TWO(-Wshorten-64-to-32,-Wsign-conversion)
+GCC_IGNORE_WARNINGS_ONE(-Wconversion)
+
+namespace eigen2mat {
+     namespace internal {
+	  /*
+	   * The masks are scanned 8 bytes at a time: a bool is stored as a
+	   * 0/1 byte, so that the sum of the 8 bytes of a word ends up in its
+	   * most significant byte after a multiplication by 0x0101...01, and
+	   * words of 8 false values can be skipped at once.
+	   */
+	  inline unsigned long long load_mask_word(const bool* m)
+	  {
+	       unsigned long long w;
+	       std::memcpy(&w, m, sizeof(w));
+	       return w;
+	  }
+
+	  //! Number of true values in m[0..n)
+	  inline std::size_t mask_count(const bool* m, std::size_t n)
+	  {
+	       std::size_t ret(0), i(0);
+	       for ( ; i + 8 <= n ; i += 8) {
+		    ret += (load_mask_word(m + i) * 0x0101010101010101ULL) >> 56;
+	       }
+	       for ( ; i < n ; ++i) {
+		    ret += m[i];
+	       }
+	       return ret;
+	  }
+
+	  //! Call f(i) for each i in [0, n) such that m[i] is true (in order)
+	  template <typename function_t>
+	  inline void mask_for_each(const bool* m, std::size_t n, function_t f)
+	  {
+	       std::size_t i(0);
+	       for ( ; i + 8 <= n ; i += 8) {
+		    if (load_mask_word(m + i) != 0) {
+			 for (std::size_t k(i) ; k < i + 8 ; ++k) {
+			      if (m[k]) {
+				   f(k);
+			      }
+			 }
+		    }
+	       }
+	       for ( ; i < n ; ++i) {
+		    if (m[i]) {
+			 f(i);
+		    }
+	       }
+	  }
+
+	  // Masks with fewer elements are processed serially
+	  const par_index_t mask_parallel_threshold = 65536;
+     } // namespace internal
+
+     /*!
+      * \brief Logical mask with the same number of elements as a matrix
+      *
+      * Non-owning: the array the mask was built from must outlive it.
+      */
+     class mask_t
+     {
+     public:
+	  /*!
+	   * \brief Constructor from a MATLAB logical array
+	   *
+	   * \param mask full (ie. not sparse) logical mxArray
+	   */
+	  explicit mask_t(const mxArray* mask)
+	       : data_(nullptr), numel_(0)
+	       {
+		    e2m_assert(mask);
+		    if (!mxIsLogical(mask) || mxIsSparse(mask)) {
+			 mexErrMsgIdAndTxt("eigen2mat:invalid_argument",
+					   "mask_t: mask is not a full logical array");
+		    }
+		    static_assert(sizeof(mxLogical) == sizeof(bool),
+				  "mxLogical must be a bool");
+		    data_ = reinterpret_cast<const bool*>(mxGetLogicals(mask));
+		    numel_ = mxGetNumberOfElements(mask);
+	       }
+
+	  /*!
+	   * \brief Constructor from an Eigen array (or matrix) of bool
+	   *
+	   * \param mask column-major array
+	   */
+	  template <typename Derived>
+	  explicit mask_t(const Eigen::PlainObjectBase<Derived>& mask)
+	       : data_(mask.data()), numel_(mask.size())
+	       {
+		    static_assert(std::is_same<typename Derived::Scalar, bool>::value,
+				  "mask_t: mask must be an array of bool");
+		    static_assert(!Derived::IsRowMajor || Derived::IsVectorAtCompileTime,
+				  "mask_t: mask must be column-major");
+	       }
+
+	  //! \brief Pointer to the values of the mask
+	  const bool* data() const {return data_;}
+	  //! \brief Number of elements of the mask
+	  size_t size() const {return numel_;}
+
+     private:
+	  const bool* data_;
+	  size_t numel_;
+     };
+
+     // =========================================================================
+
+     /*!
+      * \brief View of the elements of a matrix selected by a logical mask,
+      *        ie. A(mask) in MATLAB
+      *
+      * The selected elements are taken in column-major order. eval() returns
+      * them as a column vector; the assignment operators take a scalar or a
+      * vector with one element per selected element.
+      *
+      * This is the version for dense (column-major) matrices; large views
+      * are processed in parallel.
+      */
+     template <typename matrix_t>
+     class mask_view
+     {
+     public:
+	  typedef typename matrix_t::Index Index;
+	  typedef typename matrix_t::Scalar Scalar;
+	  typedef Eigen::Matrix<Scalar, Eigen::Dynamic, 1> vector_t;
+	  typedef mask_view<matrix_t> self_t;
+
+	  /*!
+	   * \brief Constructor
+	   *
+	   * \param m matrix to take a view of
+	   * \param mask mask with as many elements as \c m
+	   */
+	  mask_view(matrix_t& m, const mask_t& mask);
+
+	  mask_view(const self_t&) = default;
+	  //! Deleted: would rebind the view instead of assigning its elements
+	  self_t& operator= (const self_t&) = delete;
+
+	  //! \brief Number of selected elements
+	  Index size() const {return count_;}
+
+	  //! \brief Copy the selected elements into a column vector
+	  vector_t eval() const;
+
+	  template <typename Derived>
+	  self_t& operator= (const Eigen::DenseBase<Derived>& v)
+	       {
+		    apply_vector_(v, internal::assign_op());
+		    return *this;
+	       }
+	  template <typename Derived>
+	  self_t& operator+= (const Eigen::DenseBase<Derived>& v)
+	       {
+		    apply_vector_(v, internal::scalar_sum_assign_op());
+		    return *this;
+	       }
+	  template <typename Derived>
+	  self_t& operator-= (const Eigen::DenseBase<Derived>& v)
+	       {
+		    apply_vector_(v, internal::scalar_diff_assign_op());
+		    return *this;
+	       }
+
+	  self_t& operator= (const Scalar& s)
+	       {
+		    apply_(scalar_wrapper_t<Scalar>(s), internal::assign_op());
+		    return *this;
+	       }
+	  self_t& operator+= (const Scalar& s)
+	       {
+		    apply_(scalar_wrapper_t<Scalar>(s), internal::scalar_sum_assign_op());
+		    return *this;
+	       }
+	  self_t& operator-= (const Scalar& s)
+	       {
+		    apply_(scalar_wrapper_t<Scalar>(s), internal::scalar_diff_assign_op());
+		    return *this;
+	       }
+
+     private:
+	  template <typename Derived, typename functor_t>
+	  void apply_vector_(const Eigen::DenseBase<Derived>& v, functor_t op)
+	       {
+		    e2m_assert(v.size() == count_);
+		    // evaluated first: also takes care of aliasing
+		    const vector_t tmp(v);
+		    apply_(tmp, op);
+	       }
+
+	  /*!
+	   * \brief Apply op(m[i], src.coeff(rank, 0)) to each selected element,
+	   *        rank being the position of i among the selected elements
+	   */
+	  template <typename source_t, typename functor_t>
+	  void apply_(const source_t& src, functor_t op);
+
+	  //! \brief Call f(begin, end, rank) on contiguous chunks of the mask
+	  template <typename function_t>
+	  void for_each_chunk_(function_t f) const;
+
+	  //! \brief Whether element k (column-major) is at data()[k]
+	  bool contiguous_() const
+	       {
+		    if (matrix_t::IsRowMajor) {
+			 // row vector
+			 return mat_->innerStride() == 1;
+		    }
+		    return mat_->innerStride() == 1
+			 && (mat_->cols() <= 1 || mat_->outerStride() == mat_->rows());
+	       }
+
+	  matrix_t* mat_;
+	  const bool* mask_;
+	  Index count_;
+     };
+
+     // =========================================================================
+
+     /*!
+      * \brief Specialisation of mask_view for sparse matrices
+      *
+      * The mask is intersected with the stored elements of each column in a
+      * single merge pass. eval() returns a sparse column vector (like MATLAB
+      * does). Assignments rebuild the structure of the matrix: masked
+      * elements that end up equal to zero are removed, masked elements that
+      * become non-zero are inserted.
+      */
+     template <typename _Scalar, int _Options, typename _Index>
+     class mask_view<Eigen::SparseMatrix<_Scalar, _Options, _Index>>
+     {
+     public:
+	  typedef Eigen::SparseMatrix<_Scalar, _Options, _Index> matrix_t;
+	  typedef typename matrix_t::Index Index;
+	  typedef typename matrix_t::Scalar Scalar;
+	  typedef matrix_t sp_vector_t;
+	  typedef mask_view<matrix_t> self_t;
+
+	  /*!
+	   * \brief Constructor
+	   *
+	   * \param m matrix to take a view of
+	   * \param mask mask with as many elements as \c m
+	   */
+	  mask_view(matrix_t& m, const mask_t& mask);
+
+	  mask_view(const self_t&) = default;
+	  //! Deleted: would rebind the view instead of assigning its elements
+	  self_t& operator= (const self_t&) = delete;
+
+	  //! \brief Number of selected elements
+	  Index size() const {return col_rank_.back();}
+
+	  //! \brief Copy the selected elements into a sparse column vector
+	  sp_vector_t eval() const;
+
+	  template <typename Derived>
+	  self_t& operator= (const Eigen::DenseBase<Derived>& v)
+	       {
+		    apply_vector_(v, internal::assign_op());
+		    return *this;
+	       }
+	  template <typename Derived>
+	  self_t& operator+= (const Eigen::DenseBase<Derived>& v)
+	       {
+		    apply_vector_(v, internal::scalar_sum_assign_op());
+		    return *this;
+	       }
+	  template <typename Derived>
+	  self_t& operator-= (const Eigen::DenseBase<Derived>& v)
+	       {
+		    apply_vector_(v, internal::scalar_diff_assign_op());
+		    return *this;
+	       }
+
+	  self_t& operator= (const Scalar& s)
+	       {
+		    apply_(scalar_wrapper_t<Scalar>(s), internal::assign_op());
+		    return *this;
+	       }
+	  self_t& operator+= (const Scalar& s)
+	       {
+		    apply_(scalar_wrapper_t<Scalar>(s), internal::scalar_sum_assign_op());
+		    return *this;
+	       }
+	  self_t& operator-= (const Scalar& s)
+	       {
+		    apply_(scalar_wrapper_t<Scalar>(s), internal::scalar_diff_assign_op());
+		    return *this;
+	       }
+
+     private:
+	  template <typename Derived, typename functor_t>
+	  void apply_vector_(const Eigen::DenseBase<Derived>& v, functor_t op)
+	       {
+		    e2m_assert(v.size() == size());
+		    const Eigen::Matrix<Scalar, Eigen::Dynamic, 1> tmp(v);
+		    apply_(tmp, op);
+	       }
+
+	  template <typename source_t, typename functor_t>
+	  void apply_(const source_t& src, functor_t op);
+
+	  /*!
+	   * \brief Merge the stored elements of column j with its mask
+	   *
+	   * Calls stored(row, value) for each stored element that is not
+	   * masked and masked(row, rank, value_ptr) for each masked element
+	   * (value_ptr is nullptr if the element is not stored), in increasing
+	   * row order.
+	   */
+	  template <typename stored_t, typename masked_t>
+	  void merge_column_(Index j, stored_t stored, masked_t masked) const;
+
+	  matrix_t* mat_;
+	  const bool* mask_;
+	  std::vector<Index> col_rank_; //!< Number of selected elements before each column
+     };
+
+     // =========================================================================
+
+     /*!
+      * \brief Create a view of the elements of a matrix selected by a mask
+      *
+      * \code
+      * auto v = e2m::masked(A, e2m::mask_t(prhs[1]));
+      * plhs[0] = e2m::to_mxArray(v.eval()); // x = A(mask)
+      * v = 0.;                              // A(mask) = 0
+      * \endcode
+      *
+      * \param m matrix
+      * \param mask mask with as many elements as \c m
+      * \return mask view
+      */
+     template <typename matrix_t>
+     mask_view<matrix_t> masked(matrix_t& m, const mask_t& mask)
+     {
+	  return mask_view<matrix_t>(m, mask);
+     }
+
+     // =========================================================================
+     // Dense version
+
+     template <typename matrix_t>
+     mask_view<matrix_t>::mask_view(matrix_t& m, const mask_t& mask)
+	  : mat_(&m), mask_(mask.data()), count_(0)
+     {
+	  static_assert(!matrix_t::IsRowMajor || matrix_t::IsVectorAtCompileTime,
+			"mask_view: matrix must be column-major");
+	  if (mask.size() != static_cast<size_t>(m.size())) {
+	       mexErrMsgIdAndTxt("eigen2mat:invalid_argument",
+				 "mask_view: the mask has %d elements, expected %d",
+				 static_cast<int>(mask.size()),
+				 static_cast<int>(m.size()));
+	  }
+	  count_ = internal::mask_count(mask_, mask.size());
+     }
+
+     template <typename matrix_t>
+     template <typename function_t>
+     void mask_view<matrix_t>::for_each_chunk_(function_t f) const
+     {
+	  typedef internal::par_index_t index_t;
+	  const index_t n = mat_->size();
+	  const auto n_chunks = internal::num_chunks(
+	       n, internal::mask_parallel_threshold);
+
+	  // rank of the first selected element of each chunk
+	  std::vector<index_t> rank(n_chunks + 1, 0);
+	  if (n_chunks > 1) {
+	       internal::parallel_for(
+		    0, n_chunks,
+		    [&](index_t c) {
+			 index_t begin(0), end(0);
+			 internal::chunk_range(n, n_chunks, c, begin, end);
+			 rank[c+1] = internal::mask_count(mask_ + begin, end - begin);
+		    });
+	       for (index_t c(0) ; c < n_chunks ; ++c) {
+		    rank[c+1] += rank[c];
+	       }
+	  }
+	  internal::parallel_for(
+	       0, n_chunks,
+	       [&](index_t c) {
+		    index_t begin(0), end(0);
+		    internal::chunk_range(n, n_chunks, c, begin, end);
+		    f(begin, end, rank[c]);
+	       });
+     }
+
+     template <typename matrix_t>
+     typename mask_view<matrix_t>::vector_t mask_view<matrix_t>::eval() const
+     {
+	  E2M_OP_SCOPE(MASK_VIEW, count_ * sizeof(Scalar), 1);
+	  vector_t ret(count_);
+	  const auto* data = mat_->data();
+	  const bool contiguous = contiguous_();
+	  const Index M = mat_->rows();
+	  const matrix_t& m = *mat_;
+	  for_each_chunk_(
+	       [&](internal::par_index_t begin, internal::par_index_t end,
+		   internal::par_index_t rank) {
+		    auto* out = ret.data() + rank;
+		    internal::mask_for_each(
+			 mask_ + begin, end - begin,
+			 [&](std::size_t i) {
+			      const Index k = begin + i;
+			      *out++ = contiguous ? data[k] : m.coeff(k % M, k / M);
+			 });
+	       });
+	  return ret;
+     }
+
+     template <typename matrix_t>
+     template <typename source_t, typename functor_t>
+     void mask_view<matrix_t>::apply_(const source_t& src, functor_t op)
+     {
+	  E2M_OP_SCOPE(MASK_VIEW, count_ * sizeof(Scalar), 0);
+	  const bool is_scalar = internal::is_scalar<source_t>::value;
+	  auto* data = mat_->data();
+	  const bool contiguous = contiguous_();
+	  const Index M = mat_->rows();
+	  matrix_t& m = *mat_;
+	  for_each_chunk_(
+	       [&](internal::par_index_t begin, internal::par_index_t end,
+		   internal::par_index_t rank) {
+		    auto r = rank;
+		    internal::mask_for_each(
+			 mask_ + begin, end - begin,
+			 [&](std::size_t i) {
+			      const Index k = begin + i;
+			      op(contiguous ? data[k] : m.coeffRef(k % M, k / M),
+				 src.coeff(is_scalar ? 0 : r++, 0));
+			 });
+	       });
+     }
+
+     // =========================================================================
+     // Sparse version
+
+     template <typename _Scalar, int _Options, typename _Index>
+     mask_view<Eigen::SparseMatrix<_Scalar, _Options, _Index>>::mask_view(
+	  matrix_t& m, const mask_t& mask)
+	  : mat_(&m), mask_(mask.data()), col_rank_(m.cols() + 1, 0)
+     {
+	  static_assert(!matrix_t::IsRowMajor,
+			"mask_view: sparse matrix must be column-major");
+	  if (mask.size() != static_cast<size_t>(m.rows() * m.cols())) {
+	       mexErrMsgIdAndTxt("eigen2mat:invalid_argument",
+				 "mask_view: the mask has %d elements, expected %d",
+				 static_cast<int>(mask.size()),
+				 static_cast<int>(m.rows() * m.cols()));
+	  }
+	  const Index M = m.rows();
+	  const Index N = m.cols();
+	  std::vector<Index> count(N);
+	  internal::parallel_for(
+	       0, N,
+	       [&](internal::par_index_t j) {
+		    count[j] = internal::mask_count(mask_ + j * M, M);
+	       }, std::max<Index>(2, internal::mask_parallel_threshold / std::max<Index>(M, 1)));
+	  internal::parallel_exclusive_scan(N, count.data(), col_rank_.data());
+     }
+
+     template <typename _Scalar, int _Options, typename _Index>
+     template <typename stored_t, typename masked_t>
+     void mask_view<Eigen::SparseMatrix<_Scalar, _Options, _Index>>::merge_column_(
+	  Index j, stored_t stored, masked_t masked) const
+     {
+	  const Index M = mat_->rows();
+	  const auto* inner = mat_->innerIndexPtr();
+	  const auto* values = mat_->valuePtr();
+	  Index k = mat_->outerIndexPtr()[j];
+	  const Index k_end = mat_->isCompressed()
+	       ? mat_->outerIndexPtr()[j+1]
+	       : k + mat_->innerNonZeroPtr()[j];
+	  Index rank = col_rank_[j];
+
+	  internal::mask_for_each(
+	       mask_ + j * M, M,
+	       [&](std::size_t i) {
+		    const Index row = i;
+		    for ( ; k < k_end && inner[k] < row ; ++k) {
+			 stored(inner[k], values[k]);
+		    }
+		    if (k < k_end && inner[k] == row) {
+			 masked(row, rank++, values + k);
+			 ++k;
+		    }
+		    else {
+			 masked(row, rank++, static_cast<const Scalar*>(nullptr));
+		    }
+	       });
+	  for ( ; k < k_end ; ++k) {
+	       stored(inner[k], values[k]);
+	  }
+     }
+
+     template <typename _Scalar, int _Options, typename _Index>
+     typename mask_view<Eigen::SparseMatrix<_Scalar, _Options, _Index>>::sp_vector_t
+     mask_view<Eigen::SparseMatrix<_Scalar, _Options, _Index>>::eval() const
+     {
+	  const internal::par_index_t N = mat_->cols();
+	  const Index min_size = 64;
+
+	  // 1. number of selected stored elements in each column
+	  std::vector<Index> count(N);
+	  internal::parallel_for_dynamic(
+	       0, N,
+	       [&](internal::par_index_t j) {
+		    Index n(0);
+		    merge_column_(j,
+				  [](Index, const Scalar&) {},
+				  [&](Index, Index, const Scalar* v) {
+				       n += (v != nullptr);
+				  });
+		    count[j] = n;
+	       }, min_size);
+	  std::vector<Index> start(N + 1);
+	  const auto nnz = internal::parallel_exclusive_scan(N, count.data(),
+							     start.data());
+	  E2M_OP_SCOPE(MASK_VIEW, nnz * (sizeof(Scalar) + sizeof(Index)), 1);
+
+	  // 2. copy them (the rank of an element is its row in the result)
+	  sp_vector_t ret(size(), 1);
+	  ret.resizeNonZeros(nnz);
+	  ret.outerIndexPtr()[0] = 0;
+	  ret.outerIndexPtr()[1] = nnz;
+	  auto* inner = ret.innerIndexPtr();
+	  auto* values = ret.valuePtr();
+	  internal::parallel_for_dynamic(
+	       0, N,
+	       [&](internal::par_index_t j) {
+		    auto k = start[j];
+		    merge_column_(j,
+				  [](Index, const Scalar&) {},
+				  [&](Index, Index rank, const Scalar* v) {
+				       if (v != nullptr) {
+					    inner[k] = rank;
+					    values[k++] = *v;
+				       }
+				  });
+	       }, min_size);
+	  return ret;
+     }
+
+     // masked elements are removed when they are exactly zero
+     GCC_IGNORE_WARNINGS_ONE(-Wfloat-equal)
+     CLANG_IGNORE_WARNINGS_ONE(-Wfloat-equal)
+     template <typename _Scalar, int _Options, typename _Index>
+     template <typename source_t, typename functor_t>
+     void mask_view<Eigen::SparseMatrix<_Scalar, _Options, _Index>>::apply_(
+	  const source_t& src, functor_t op)
+     {
+	  const bool is_scalar = internal::is_scalar<source_t>::value;
+	  const internal::par_index_t N = mat_->cols();
+	  const Index min_size = 64;
+	  const Scalar zero(0);
+
+	  // new value of a masked element (removed if zero)
+	  auto masked_value = [&](Index rank, const Scalar* v) {
+	       Scalar x = v == nullptr ? zero : *v;
+	       op(x, src.coeff(is_scalar ? 0 : rank, 0));
+	       return x;
+	  };
+
+	  // 1. number of elements of each column of the result
+	  std::vector<Index> count(N);
+	  internal::parallel_for_dynamic(
+	       0, N,
+	       [&](internal::par_index_t j) {
+		    Index n(0);
+		    merge_column_(j,
+				  [&](Index, const Scalar&) {++n;},
+				  [&](Index, Index rank, const Scalar* v) {
+				       n += (masked_value(rank, v) != zero);
+				  });
+		    count[j] = n;
+	       }, min_size);
+
+	  // 2. fill the new matrix
+	  std::vector<Index> start(N + 1);
+	  const auto nnz = internal::parallel_exclusive_scan(N, count.data(),
+							     start.data());
+	  E2M_OP_SCOPE(MASK_VIEW, nnz * (sizeof(Scalar) + sizeof(Index)), 1);
+	  matrix_t ret(mat_->rows(), mat_->cols());
+	  auto* ret_outer = ret.outerIndexPtr();
+	  for (internal::par_index_t j(0) ; j <= N ; ++j) {
+	       ret_outer[j] = static_cast<_Index>(start[j]);
+	  }
+	  ret.resizeNonZeros(nnz);
+	  auto* inner = ret.innerIndexPtr();
+	  auto* values = ret.valuePtr();
+	  const auto* outer = ret.outerIndexPtr();
+	  internal::parallel_for_dynamic(
+	       0, N,
+	       [&](internal::par_index_t j) {
+		    auto k = outer[j];
+		    merge_column_(j,
+				  [&](Index row, const Scalar& v) {
+				       inner[k] = row;
+				       values[k++] = v;
+				  },
+				  [&](Index row, Index rank, const Scalar* v) {
+				       const Scalar x = masked_value(rank, v);
+				       if (x != zero) {
+					    inner[k] = row;
+					    values[k++] = x;
+				       }
+				  });
+	       }, min_size);
+
+	  mat_->swap(ret);
+     }
+     CLANG_RESTORE_WARNINGS
+     GCC_RESTORE_WARNINGS
+} // namespace eigen2mat
+
+GCC_RESTORE_WARNINGS
+CLANG_RESTORE_WARNINGS
+MSVC_RESTORE_WARNINGS
+
+#endif /* MASK_VIEW_HPP_INCLUDED */
@@ -0,0 +1,648 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef MEX_ARGS_HPP_INCLUDED
+#define MEX_ARGS_HPP_INCLUDED
+
+#include "eigen2mat/definitions.hpp"
+#include "eigen2mat/details/complex_traits.hpp"
+#include "eigen2mat/details/mxarray_helpers.hpp"
+#include "eigen2mat/details/op_scope.hpp"
+#include "eigen2mat/utils/include_mex"
+#include "eigen2mat/utils/macros.hpp"
+#include "eigen2mat/utils/parallel.hpp"
+
+#include <cmath>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+MSVC_IGNORE_WARNINGS(4244 4267)
+CLANG_IGNORE_WARNINGS_THREE(-Wshorten-64-to-32,
+			    -Wsign-conversion,
+			    -Wfloat-equal)
+
+namespace eigen2mat {
+     /*!
+      * \brief Tag type requesting a zero-copy, read-only view of an argument
+      *
+      * When used in a mex_args signature, \c const_view<real_matrix_t> yields
+      * an \c Eigen::Map<const real_matrix_t> pointing directly to the data of
+      * the mxArray instead of a copy.
+      *
+      * Only types that share MATLAB's memory layout can be viewed (real double
+      * matrices & vectors).
+      */
+     template <typename T>
+     struct const_view {};
+
+     namespace internal {
+	  //! Arguments bigger than this (in bytes) are converted in parallel
+	  const std::size_t mex_args_parallel_threshold = 1 << 20;
+
+	  //! Report an invalid argument and abort the MEX function
+	  inline void mex_args_error(const char* fname, std::size_t pos,
+				     const char* what)
+	  {
+	       mexErrMsgIdAndTxt("eigen2mat:invalid_argument",
+				 "%s: argument %d must be %s",
+				 fname, static_cast<int>(pos + 1), what);
+	  }
+
+	  //! Dense, real, double precision array
+	  inline bool is_real_double_(const mxArray* a)
+	  {
+	       return (mxGetClassID(a) == mxDOUBLE_CLASS
+		       && !mxIsComplex(a)
+		       && !mxIsSparse(a));
+	  }
+
+	  //! Dense, double precision array (real or complex)
+	  inline bool is_double_(const mxArray* a)
+	  {
+	       return mxGetClassID(a) == mxDOUBLE_CLASS && !mxIsSparse(a);
+	  }
+
+	  //! 2D array with at most one row or one column
+	  inline bool is_vector_(const mxArray* a)
+	  {
+	       return (mxGetNumberOfDimensions(a) == 2
+		       && (mxGetM(a) <= 1 || mxGetN(a) <= 1));
+	  }
+
+	  //! Real, dense, numeric or logical array
+	  inline bool is_real_numeric_(const mxArray* a)
+	  {
+	       return ((mxIsNumeric(a) || mxIsLogical(a))
+		       && !mxIsComplex(a)
+		       && !mxIsSparse(a));
+	  }
+
+	  //! Floating-point \c x is an integer in the range of \c T
+	  template <typename T, typename in_t>
+	  bool is_integer_in_range_(in_t x, std::true_type)
+	  {
+	       typedef std::numeric_limits<T> limits_t;
+	       const double d = x;
+	       // max + 1, exact for all integer types
+	       const double hi = std::ldexp(1., limits_t::digits);
+	       // exact comparison: d must be an integer (NaN fails the range test)
+	       GCC_IGNORE_WARNINGS_ONE(-Wfloat-equal)
+	       const bool ok = (d >= static_cast<double>(limits_t::min()) && d < hi
+				&& std::floor(d) == d);
+	       GCC_RESTORE_WARNINGS
+	       return ok;
+	  }
+
+	  //! Integer \c x is in the range of \c T (compared in its own type)
+	  template <typename T, typename in_t>
+	  bool is_integer_in_range_(in_t x, std::false_type)
+	  {
+	       typedef std::numeric_limits<T> limits_t;
+	       if (std::numeric_limits<in_t>::is_signed
+		   && static_cast<long long>(x) < 0) {
+		    return (limits_t::is_signed
+			    && (static_cast<long long>(x)
+				>= static_cast<long long>(limits_t::min())));
+	       }
+	       return (static_cast<unsigned long long>(x)
+		       <= static_cast<unsigned long long>(limits_t::max()));
+	  }
+
+	  template <typename T, typename in_t>
+	  bool is_integer_in_range_(const void* data)
+	  {
+	       const in_t x = *static_cast<const in_t*>(data);
+	       return is_integer_in_range_<T>(x, std::is_floating_point<in_t>());
+	  }
+
+	  /*!
+	   * \brief Check that the first element of \c a is an integer in the
+	   *        range of \c T
+	   *
+	   * The value is read in the type of the mxArray so that 64 bit
+	   * integers are not rounded to double precision first.
+	   */
+	  template <typename T>
+	  bool is_integer_scalar_(const mxArray* a)
+	  {
+	       const void* data = mxGetData(a);
+	       mxClassID id = mxGetClassID(a);
+	       if (id == mxSINGLE_CLASS) {
+		    return is_integer_in_range_<T, float>(data);
+	       }
+	       else if (id == mxDOUBLE_CLASS) {
+		    return is_integer_in_range_<T, double>(data);
+	       }
+	       else if (id == mxINT8_CLASS) {
+		    return is_integer_in_range_<T, signed char>(data);
+	       }
+	       else if (id == mxINT16_CLASS) {
+		    return is_integer_in_range_<T, short>(data);
+	       }
+	       else if (id == mxINT32_CLASS) {
+		    return is_integer_in_range_<T, int>(data);
+	       }
+	       else if (id == mxINT64_CLASS) {
+		    return is_integer_in_range_<T, long long>(data);
+	       }
+	       else if (id == mxUINT8_CLASS) {
+		    return is_integer_in_range_<T, unsigned char>(data);
+	       }
+	       else if (id == mxUINT16_CLASS) {
+		    return is_integer_in_range_<T, unsigned short>(data);
+	       }
+	       else if (id == mxUINT32_CLASS) {
+		    return is_integer_in_range_<T, unsigned int>(data);
+	       }
+	       else if (id == mxUINT64_CLASS) {
+		    return is_integer_in_range_<T, unsigned long long>(data);
+	       }
+	       // logical
+	       return true;
+	  }
+
+	  /*!
+	   * \brief Conversion traits used by mex_args
+	   *
+	   * Each specialisation provides:
+	   * - \c holder_t: type stored inside mex_args
+	   * - \c result_type: type returned by mex_args::get()
+	   * - \c check(): validation of the mxArray (called on the MATLAB thread)
+	   * - \c bytes(): number of bytes copied by convert()
+	   * - \c convert(): conversion of an already validated mxArray. Must not
+	   *   call any function of the MEX API that may fail as it can be run
+	   *   on a worker thread.
+	   * - \c get(): access to the converted value
+	   */
+	  template <typename T>
+	  struct mex_arg_traits;
+
+	  //! Common traits for floating-point and logical scalars
+	  template <typename T>
+	  struct mex_scalar_arg_traits
+	  {
+	       typedef T holder_t;
+	       typedef T result_type;
+
+	       static void check(const mxArray* a, const char* fname, std::size_t pos)
+		    {
+			 if (!is_real_numeric_(a) || mxGetNumberOfElements(a) != 1) {
+			      mex_args_error(fname, pos, "a real scalar");
+			 }
+		    }
+	       static std::size_t bytes(const mxArray*) { return 0; }
+	       static void convert(const mxArray* a, holder_t& h)
+		    { h = mxArray_to_single_helper<T>(a); }
+	       static result_type get(holder_t& h) { return h; }
+	  };
+
+	  //! Common traits for integer scalars (floating-point input must be integral)
+	  template <typename T>
+	  struct mex_integer_arg_traits : public mex_scalar_arg_traits<T>
+	  {
+	       static void check(const mxArray* a, const char* fname, std::size_t pos)
+		    {
+			 mex_scalar_arg_traits<T>::check(a, fname, pos);
+			 // NaN, Inf, non-integers & values out of the range of T
+			 // are rejected before the conversion
+			 if (!is_integer_scalar_<T>(a)) {
+			      mex_args_error(fname, pos,
+					     std::is_signed<T>::value ?
+					     "an integer scalar" :
+					     "a non-negative integer scalar");
+			 }
+		    }
+	  };
+
+	  template <> struct mex_arg_traits<bool>
+	       : public mex_scalar_arg_traits<bool> {};
+	  template <> struct mex_arg_traits<double>
+	       : public mex_scalar_arg_traits<double> {};
+	  template <> struct mex_arg_traits<int>
+	       : public mex_integer_arg_traits<int> {};
+	  template <> struct mex_arg_traits<size_t>
+	       : public mex_integer_arg_traits<size_t> {};
+
+	  //! Raw access to the mxArray (no check, no conversion)
+	  template <>
+	  struct mex_arg_traits<const mxArray*>
+	  {
+	       typedef const mxArray* holder_t;
+	       typedef const mxArray* result_type;
+
+	       static void check(const mxArray*, const char*, std::size_t) {}
+	       static std::size_t bytes(const mxArray*) { return 0; }
+	       static void convert(const mxArray* a, holder_t& h) { h = a; }
+	       static result_type get(holder_t& h) { return h; }
+	  };
+
+	  //! Common traits for std::vector of integers
+	  template <typename array_t>
+	  struct mex_array_arg_traits
+	  {
+	       typedef array_t holder_t;
+	       typedef array_t& result_type;
+
+	       static void check(const mxArray* a, const char* fname, std::size_t pos)
+		    {
+			 if (!is_real_numeric_(a) || !is_vector_(a)) {
+			      mex_args_error(fname, pos, "a real numeric vector");
+			 }
+		    }
+	       static std::size_t bytes(const mxArray* a)
+		    {
+			 return (mxGetNumberOfElements(a)
+				 * sizeof(typename array_t::value_type));
+		    }
+	       static void convert(const mxArray* a, holder_t& h)
+		    {
+			 h.resize(mxGetNumberOfElements(a));
+			 copy_from_mxArray_helper(a, h.size(), h.begin());
+		    }
+	       static result_type get(holder_t& h) { return h; }
+	  };
+
+	  template <> struct mex_arg_traits<int_array_t>
+	       : public mex_array_arg_traits<int_array_t> {};
+	  template <> struct mex_arg_traits<idx_array_t>
+	       : public mex_array_arg_traits<idx_array_t> {};
+
+	  //! Common traits for dense Eigen matrices & vectors (copy)
+	  template <typename matrix_t>
+	  struct mex_dense_arg_traits
+	  {
+	       typedef typename matrix_t::Scalar Scalar;
+	       typedef matrix_t holder_t;
+	       typedef matrix_t& result_type;
+
+	       enum {
+		    is_cmplx = internal::complex_traits<Scalar>::is_cmplx,
+		    is_vector = matrix_t::IsVectorAtCompileTime
+	       };
+
+	       static void check(const mxArray* a, const char* fname, std::size_t pos)
+		    {
+			 const bool type_ok = is_cmplx ? is_double_(a) : is_real_double_(a);
+			 const bool shape_ok = (is_vector ?
+						is_vector_(a) :
+						mxGetNumberOfDimensions(a) == 2);
+			 if (!type_ok || !shape_ok) {
+			      mex_args_error(fname, pos,
+					     is_vector ?
+					     (is_cmplx ? "a double vector" : "a real double vector") :
+					     (is_cmplx ? "a double matrix" : "a real double matrix"));
+			 }
+		    }
+	       static std::size_t bytes(const mxArray* a)
+		    { return mxGetNumberOfElements(a) * sizeof(Scalar); }
+	       //! Size of the Eigen object (vectors are always 1D)
+	       static void dimensions(const mxArray* a,
+				      typename matrix_t::Index& rows,
+				      typename matrix_t::Index& cols)
+		    {
+			 if (is_vector) {
+			      const auto numel = mxGetNumberOfElements(a);
+			      rows = matrix_t::RowsAtCompileTime == 1 ? 1 : numel;
+			      cols = matrix_t::RowsAtCompileTime == 1 ? numel : 1;
+			 }
+			 else {
+			      rows = mxGetM(a);
+			      cols = mxGetN(a);
+			 }
+		    }
+	       static void convert(const mxArray* a, holder_t& h)
+		    {
+			 typename matrix_t::Index rows, cols;
+			 dimensions(a, rows, cols);
+			 h.resize(rows, cols);
+			 copy_values(mxGetPr(a), mxGetPi(a), h.size(), h.data());
+		    }
+	       static result_type get(holder_t& h) { return h; }
+	  };
+
+	  template <> struct mex_arg_traits<real_vector_t>
+	       : public mex_dense_arg_traits<real_vector_t> {};
+	  template <> struct mex_arg_traits<real_row_vector_t>
+	       : public mex_dense_arg_traits<real_row_vector_t> {};
+	  template <> struct mex_arg_traits<real_matrix_t>
+	       : public mex_dense_arg_traits<real_matrix_t> {};
+	  template <> struct mex_arg_traits<cmplx_vector_t>
+	       : public mex_dense_arg_traits<cmplx_vector_t> {};
+	  template <> struct mex_arg_traits<cmplx_row_vector_t>
+	       : public mex_dense_arg_traits<cmplx_row_vector_t> {};
+	  template <> struct mex_arg_traits<cmplx_matrix_t>
+	       : public mex_dense_arg_traits<cmplx_matrix_t> {};
+
+	  //! Zero-copy view of real double matrices & vectors
+	  template <typename matrix_t>
+	  struct mex_arg_traits<const_view<matrix_t>>
+	  {
+	       static_assert(!internal::complex_traits<
+				  typename matrix_t::Scalar>::is_cmplx,
+			     "const_view<T> is only available for real matrices");
+
+	       struct holder_t
+	       {
+		    holder_t() : data(nullptr), rows(0), cols(0) {}
+		    const double* data;
+		    typename matrix_t::Index rows;
+		    typename matrix_t::Index cols;
+	       };
+	       typedef Eigen::Map<const matrix_t> result_type;
+
+	       static void check(const mxArray* a, const char* fname, std::size_t pos)
+		    {
+			 mex_dense_arg_traits<matrix_t>::check(a, fname, pos);
+		    }
+	       static std::size_t bytes(const mxArray*) { return 0; }
+	       static void convert(const mxArray* a, holder_t& h)
+		    {
+			 h.data = mxGetPr(a);
+			 mex_dense_arg_traits<matrix_t>::dimensions(a, h.rows, h.cols);
+		    }
+	       static result_type get(holder_t& h)
+		    { return result_type(h.data, h.rows, h.cols); }
+	  };
+
+	  //! Common traits for Eigen sparse matrices
+	  template <typename sp_matrix_t>
+	  struct mex_sparse_arg_traits
+	  {
+	       typedef typename sp_matrix_t::Scalar Scalar;
+	       typedef sp_matrix_t holder_t;
+	       typedef sp_matrix_t& result_type;
+
+	       enum {
+		    is_cmplx = internal::complex_traits<Scalar>::is_cmplx
+	       };
+
+	       static void check(const mxArray* a, const char* fname, std::size_t pos)
+		    {
+			 if (!mxIsSparse(a)
+			     || mxGetClassID(a) != mxDOUBLE_CLASS
+			     || (!is_cmplx && mxIsComplex(a))) {
+			      mex_args_error(fname, pos,
+					     is_cmplx ?
+					     "a sparse matrix" :
+					     "a real sparse matrix");
+			 }
+		    }
+	       static std::size_t bytes(const mxArray* a)
+		    {
+			 const auto N = mxGetN(a);
+			 const auto nnz = mxGetJc(a)[N];
+			 return (nnz * (sizeof(Scalar) + sizeof(typename sp_matrix_t::Index))
+				 + (N + 1) * sizeof(typename sp_matrix_t::Index));
+		    }
+	       static void convert(const mxArray* a, holder_t& h)
+		    { csc_to_eigen(a, h); }
+	       static result_type get(holder_t& h) { return h; }
+	  };
+
+	  template <> struct mex_arg_traits<real_sp_matrix_t>
+	       : public mex_sparse_arg_traits<real_sp_matrix_t> {};
+	  template <> struct mex_arg_traits<cmplx_sp_matrix_t>
+	       : public mex_sparse_arg_traits<cmplx_sp_matrix_t> {};
+
+	  /*!
+	   * \brief Common traits for tensors
+	   *
+	   * Contrary to mxArray_to_real_tensor(), a 2D array is considered as a
+	   * tensor with a single page (as in MATLAB).
+	   */
+	  template <typename tensor_t>
+	  struct mex_tensor_arg_traits
+	  {
+	       typedef typename tensor_t::value_type matrix_t;
+	       typedef typename matrix_t::Scalar Scalar;
+	       typedef tensor_t holder_t;
+	       typedef tensor_t& result_type;
+
+	       enum {
+		    is_cmplx = internal::complex_traits<Scalar>::is_cmplx
+	       };
+
+	       static void check(const mxArray* a, const char* fname, std::size_t pos)
+		    {
+			 const bool type_ok = is_cmplx ? is_double_(a) : is_real_double_(a);
+			 if (!type_ok || mxGetNumberOfDimensions(a) > 3) {
+			      mex_args_error(fname, pos,
+					     is_cmplx ?
+					     "a 3D double array" :
+					     "a real 3D double array");
+			 }
+		    }
+	       static std::size_t bytes(const mxArray* a)
+		    { return mxGetNumberOfElements(a) * sizeof(Scalar); }
+	       static void convert(const mxArray* a, holder_t& h)
+		    {
+			 const auto ndims = mxGetNumberOfDimensions(a);
+			 const auto* dims = mxGetDimensions(a);
+			 const auto P = ndims > 2 ? dims[2] : 1;
+			 const auto mat_size = dims[0] * dims[1];
+
+			 const double* real = mxGetPr(a);
+			 const double* imag = mxGetPi(a);
+			 h.assign(P, matrix_t(dims[0], dims[1]));
+			 for (auto k(0UL) ; k < P ; ++k) {
+			      copy_values(real + k * mat_size,
+					  imag == nullptr ? nullptr : imag + k * mat_size,
+					  mat_size,
+					  h[k].data());
+			 }
+		    }
+	       static result_type get(holder_t& h) { return h; }
+	  };
+
+	  template <> struct mex_arg_traits<real_tensor_t>
+	       : public mex_tensor_arg_traits<real_tensor_t> {};
+	  template <> struct mex_arg_traits<cmplx_tensor_t>
+	       : public mex_tensor_arg_traits<cmplx_tensor_t> {};
+     } // namespace internal
+
+     /*!
+      * \brief Check the number of output arguments of a MEX function
+      *
+      * \param nlhs number of output arguments requested by MATLAB
+      * \param min_nlhs minimum number of output arguments
+      * \param max_nlhs maximum number of output arguments
+      * \param fname name of the MEX function (for error messages)
+      */
+     inline void check_nlhs(int nlhs, int min_nlhs, int max_nlhs,
+			    const char* fname = "mexFunction")
+     {
+	  if (nlhs < min_nlhs || nlhs > max_nlhs) {
+	       mexErrMsgIdAndTxt("eigen2mat:invalid_argument",
+				 "%s: expected between %d and %d output arguments, got %d",
+				 fname, min_nlhs, max_nlhs, nlhs);
+	  }
+     }
+
+     /*!
+      * \brief Typed signature of the input arguments of a MEX function
+      *
+      * All the arguments are validated up front (number of arguments, class,
+      * complexity, sparsity and shape) and are then converted without any
+      * further check. Each argument is either copied or viewed in place
+      * depending on its type (see const_view). Arguments whose copy is large
+      * are converted concurrently when OpenMP is enabled.
+      *
+      * Example:
+      * \code
+      * void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
+      * {
+      *      using namespace eigen2mat;
+      *      check_nlhs(nlhs, 0, 1, "my_mex");
+      *      mex_args<const_view<real_matrix_t>, real_sp_matrix_t, int_array_t>
+      *           args(nrhs, prhs, "my_mex");
+      *
+      *      auto A = args.get<0>();   // Eigen::Map<const real_matrix_t>
+      *      auto& S = args.get<1>();  // real_sp_matrix_t&
+      *      auto& idx = args.get<2>(); // int_array_t&
+      *      ...
+      * }
+      * \endcode
+      */
+     template <typename... args_t>
+     class mex_args
+     {
+	  typedef std::tuple<args_t...> signature_t;
+
+	  template <std::size_t I>
+	  struct arg_
+	  {
+	       typedef internal::mex_arg_traits<
+		    typename std::tuple_element<I, signature_t>::type> traits;
+	  };
+
+     public:
+	  //! Number of input arguments of the signature
+	  static const std::size_t size = sizeof...(args_t);
+
+	  /*!
+	   * \brief Constructor
+	   *
+	   * Check and convert all the input arguments. Any error is reported
+	   * using \c mexErrMsgIdAndTxt before any conversion takes place.
+	   *
+	   * \param nrhs number of input arguments
+	   * \param prhs input arguments
+	   * \param fname name of the MEX function (for error messages)
+	   */
+	  mex_args(int nrhs, const mxArray* prhs[],
+		   const char* fname = "mexFunction")
+	       : holders_()
+	       {
+		    if (nrhs != static_cast<int>(size)) {
+			 mexErrMsgIdAndTxt("eigen2mat:invalid_argument",
+					   "%s: expected %d input arguments, got %d",
+					   fname, static_cast<int>(size), nrhs);
+		    }
+		    for (auto i(0UL) ; i < size ; ++i) {
+			 if (prhs[i] == nullptr) {
+			      internal::mex_args_error(fname, i, "a valid array");
+			 }
+		    }
+		    check_<0>(prhs, fname);
+		    convert_(prhs);
+	       }
+
+	  /*!
+	   * \brief Access to the I-th converted argument
+	   *
+	   * \return a reference to the copy, or a view (Eigen::Map) for
+	   *         const_view arguments
+	   */
+	  template <std::size_t I>
+	  typename arg_<I>::traits::result_type get()
+	       {
+		    return arg_<I>::traits::get(std::get<I>(holders_));
+	       }
+
+     private:
+	  template <std::size_t I>
+	  typename std::enable_if<(I < size)>::type
+	  check_(const mxArray* prhs[], const char* fname)
+	       {
+		    arg_<I>::traits::check(prhs[I], fname, I);
+		    check_<I+1>(prhs, fname);
+	       }
+	  template <std::size_t I>
+	  typename std::enable_if<(I == size)>::type
+	  check_(const mxArray**, const char*)
+	       {}
+
+	  template <std::size_t I>
+	  typename std::enable_if<(I < size), std::size_t>::type
+	  bytes_at_(std::size_t k, const mxArray* prhs[]) const
+	       {
+		    return (k == I ?
+			    arg_<I>::traits::bytes(prhs[I]) :
+			    bytes_at_<I+1>(k, prhs));
+	       }
+	  template <std::size_t I>
+	  typename std::enable_if<(I == size), std::size_t>::type
+	  bytes_at_(std::size_t, const mxArray**) const
+	       { return 0; }
+
+	  template <std::size_t I>
+	  typename std::enable_if<(I < size)>::type
+	  convert_at_(std::size_t k, const mxArray* prhs[])
+	       {
+		    if (k == I) {
+			 arg_<I>::traits::convert(prhs[I], std::get<I>(holders_));
+		    }
+		    else {
+			 convert_at_<I+1>(k, prhs);
+		    }
+	       }
+	  template <std::size_t I>
+	  typename std::enable_if<(I == size)>::type
+	  convert_at_(std::size_t, const mxArray**)
+	       {}
+
+	  //! Convert small arguments in place & large ones concurrently
+	  void convert_(const mxArray* prhs[])
+	       {
+		    std::size_t bytes[size > 0 ? size : 1] = {0};
+		    std::size_t total(0);
+		    for (auto i(0UL) ; i < size ; ++i) {
+			 bytes[i] = bytes_at_<0>(i, prhs);
+			 total += bytes[i];
+		    }
+		    E2M_OP_SCOPE(MEX_ARGS, total, size);
+		    (void) total;
+
+		    std::vector<std::size_t> large;
+		    for (auto i(0UL) ; i < size ; ++i) {
+			 if (bytes[i] >= internal::mex_args_parallel_threshold) {
+			      large.push_back(i);
+			 }
+			 else {
+			      convert_at_<0>(i, prhs);
+			 }
+		    }
+
+		    internal::parallel_for_dynamic(
+			 0, large.size(),
+			 [&](internal::par_index_t k) {
+			      convert_at_<0>(large[k], prhs);
+			 });
+	       }
+
+	  std::tuple<typename internal::mex_arg_traits<args_t>::holder_t...> holders_;
+     };
+} // namespace eigen2mat
+
+CLANG_RESTORE_WARNINGS
+MSVC_RESTORE_WARNINGS
+
+#endif /* MEX_ARGS_HPP_INCLUDED */
@@ -0,0 +1,27 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef MATRIX_BASE_PLUGIN_HPP_INCLUDED
+#define MATRIX_BASE_PLUGIN_HPP_INCLUDED
+
+template <typename index_t>
+eigen2mat::dense_slice<Derived> slice(const std::vector<index_t>& row_indices,
+				      const std::vector<index_t>& col_indices)
+{
+     return eigen2mat::dense_slice<Derived>(derived(), row_indices, col_indices);
+}
+
+template <typename index_t>
+eigen2mat::dense_slice<const Derived> slice(const std::vector<index_t>& row_indices,
+					    const std::vector<index_t>& col_indices) const
+{
+     return eigen2mat::dense_slice<const Derived>(derived(), row_indices, col_indices);
+}
+
+#endif /* MATRIX_BASE_PLUGIN_HPP_INCLUDED */
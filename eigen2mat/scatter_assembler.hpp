@@ -0,0 +1,158 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef SCATTER_ASSEMBLER_HPP_INCLUDED
+#define SCATTER_ASSEMBLER_HPP_INCLUDED
+
+#include "eigen2mat/definitions.hpp"
+#include "eigen2mat/details/op_scope.hpp"
+#include "eigen2mat/utils/include_mex"
+#include "eigen2mat/utils/macros.hpp"
+#include "eigen2mat/utils/parallel.hpp"
+
+#include <vector>
+
+MSVC_IGNORE_WARNINGS(4267)
+CLANG_IGNORE_WARNINGS_TWO(-Wshorten-64-to-32,-Wsign-conversion)
+
+namespace eigen2mat {
+     /*!
+      * \brief Assembly of element matrices into a fixed sparsity pattern,
+      *        ie. <tt>A(dofs{e},dofs{e}) += Ke</tt> for each element e
+      *
+      * The constructor computes, once for a given mesh:
+      *   - the sparsity pattern of the matrix (union of the dofs x dofs
+      *     blocks of all the elements),
+      *   - for each element, the position of each coefficient of its
+      *     element matrix in the value array of the matrix,
+      *   - a greedy colouring of the elements such that two elements of
+      *     the same colour do not share any dof.
+      *
+      * Elements of the same colour can then be scattered concurrently
+      * without atomics or locks: assemble() processes the colours one after
+      * the other and the elements of each colour in parallel. Repeated dofs
+      * (inside an element or across elements) are summed.
+      *
+      * \code
+      * e2m::real_scatter_assembler_t A(n_dofs, element_dofs);
+      * A.assemble([&](e2m::size_t e, e2m::real_matrix_t& Ke) {
+      *      ... compute Ke (already sized) ...
+      * });
+      * plhs[0] = e2m::to_mxArray(A.matrix());
+      * \endcode
+      */
+     template <typename scalar_t>
+     class scatter_assembler
+     {
+     public:
+	  typedef scalar_t Scalar;
+	  typedef Eigen::SparseMatrix<scalar_t, 0, int> sp_matrix_t;
+	  typedef Eigen::Matrix<scalar_t, Eigen::Dynamic, Eigen::Dynamic> element_matrix_t;
+
+	  /*!
+	   * \brief Constructor
+	   *
+	   * An error is raised if a dof is out of range.
+	   *
+	   * \param n_dofs size of the (square) matrix
+	   * \param elements dofs of each element (0-based)
+	   */
+	  scatter_assembler(size_t n_dofs, const std::vector<idx_array_t>& elements);
+
+	  //! \brief Number of elements
+	  size_t size() const {return elem_ptr_.size() - 1;}
+	  //! \brief Number of colours
+	  size_t n_colors() const {return color_ptr_.size() - 1;}
+	  //! \brief Elements of colour c are color_elements()[color_ptr()[c]..color_ptr()[c+1])
+	  const std::vector<size_t>& color_ptr() const {return color_ptr_;}
+	  //! \brief Elements sorted by colour
+	  const std::vector<size_t>& color_elements() const {return color_elements_;}
+
+	  //! \brief Assembled matrix (compressed, with the full sparsity pattern)
+	  const sp_matrix_t& matrix() const {return matrix_;}
+
+	  //! \brief Reset the values of the matrix to zero (keeps the pattern)
+	  void set_zero();
+
+	  /*!
+	   * \brief Add an element matrix to the matrix
+	   *
+	   * Can be called concurrently for elements of the same colour.
+	   *
+	   * \param e element
+	   * \param Ke element matrix (n x n, n being the number of dofs of e)
+	   */
+	  template <typename Derived>
+	  void add(size_t e, const Eigen::MatrixBase<Derived>& Ke)
+	       {
+		    e2m_assert(e < size());
+		    const auto n = elem_ptr_[e+1] - elem_ptr_[e];
+		    e2m_assert(static_cast<size_t>(Ke.rows()) == n);
+		    e2m_assert(static_cast<size_t>(Ke.cols()) == n);
+		    const auto* pos = positions_.data() + pos_ptr_[e];
+		    auto* values = matrix_.valuePtr();
+		    for (size_t j(0) ; j < n ; ++j) {
+			 for (size_t i(0) ; i < n ; ++i) {
+			      values[*pos++] += Ke.coeff(i, j);
+			 }
+		    }
+	       }
+
+	  /*!
+	   * \brief Assemble the matrix, colour by colour
+	   *
+	   * \c f(e, Ke) must fill the element matrix of element e; Ke is
+	   * resized beforehand and is private to the calling thread. The
+	   * elements of each colour are processed in parallel, so \c f must be
+	   * thread-safe.
+	   *
+	   * \param f element matrix function
+	   */
+	  template <typename function_t>
+	  void assemble(function_t f)
+	       {
+		    E2M_OP_SCOPE(SCATTER_ASSEMBLE,
+				 positions_.size() * sizeof(scalar_t),
+				 0);
+		    // one element matrix per thread; the loops below run serially
+		    // (eg. inside an enclosing parallel region) if T == 1
+		    const auto T = internal::max_threads();
+		    std::vector<element_matrix_t> Ke(T);
+		    for (size_t c(0) ; c < n_colors() ; ++c) {
+			 internal::parallel_for_dynamic(
+			      color_ptr_[c], color_ptr_[c+1],
+			      [&](internal::par_index_t k) {
+				   const auto e = color_elements_[k];
+				   const auto n = elem_ptr_[e+1] - elem_ptr_[e];
+				   auto& K = Ke[T > 1 ? internal::thread_id() : 0];
+				   K.resize(n, n);
+				   f(e, K);
+				   add(e, K);
+			      }, 64);
+		    }
+	       }
+
+     private:
+	  std::vector<size_t> elem_ptr_;       //!< Dofs of e are elem_dofs_[elem_ptr_[e]..elem_ptr_[e+1])
+	  std::vector<size_t> elem_dofs_;
+	  std::vector<size_t> pos_ptr_;        //!< Positions of e are positions_[pos_ptr_[e]..]
+	  std::vector<int> positions_;         //!< Column-major position of Ke(i,j) in matrix_
+	  std::vector<size_t> color_ptr_;
+	  std::vector<size_t> color_elements_;
+	  sp_matrix_t matrix_;
+     };
+
+     typedef scatter_assembler<double> real_scatter_assembler_t;
+     typedef scatter_assembler<dcomplex> cmplx_scatter_assembler_t;
+} // namespace eigen2mat
+
+CLANG_RESTORE_WARNINGS
+MSVC_RESTORE_WARNINGS
+
+#endif /* SCATTER_ASSEMBLER_HPP_INCLUDED */
@@ -0,0 +1,160 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef SPARSE_ASSEMBLER_HPP_INCLUDED
+#define SPARSE_ASSEMBLER_HPP_INCLUDED
+
+#include "eigen2mat/definitions.hpp"
+#include "eigen2mat/utils/include_mex"
+#include "eigen2mat/utils/macros.hpp"
+#include "eigen2mat/utils/parallel.hpp"
+
+#include <vector>
+
+namespace eigen2mat {
+     /*!
+      * \brief Parallel assembly of a sparse matrix from (row, col, value)
+      *        contributions, eg. element matrices of a FEM code
+      *
+      * Contributions are appended to one buffer per OpenMP thread, so add()
+      * can be called concurrently from a parallel region without any
+      * locking. Duplicate contributions are summed, just like with
+      * Eigen::SparseMatrix::setFromTriplets() or MATLAB's sparse(i,j,v).
+      *
+      * The buffers are merged by to_mxArray() or to_eigen(): a parallel
+      * counting sort by column, then a sort by row and a sum of the
+      * duplicates inside each column. The result is written straight into
+      * the MATLAB (or Eigen) arrays, without any intermediate Eigen matrix.
+      * The buffers are released as soon as they have been sorted, so that
+      * the peak memory usage is about twice the size of the contributions,
+      * plus a table of counters of at most max(contributions, columns)
+      * entries (one row per thread, or a single row for wide matrices).
+      *
+      * \code
+      * e2m::real_sp_assembler_t A(n_dofs, n_dofs);
+      * #pragma omp parallel for
+      * for (int e = 0 ; e < n_elements ; ++e) {
+      *      ... compute Ke, dofs ...
+      *      for (int j = 0 ; j < 4 ; ++j)
+      *           for (int i = 0 ; i < 4 ; ++i)
+      *                A.add(dofs[i], dofs[j], Ke(i,j));
+      * }
+      * plhs[0] = A.to_mxArray();
+      * \endcode
+      *
+      * \warning The assembler must be constructed outside of any parallel
+      *          region and contributions may not be added from nested
+      *          parallel regions. Once merged (ie. after to_mxArray() or
+      *          to_eigen()), clear() must be called before adding new
+      *          contributions.
+      */
+     template <typename scalar_t>
+     class sparse_assembler
+     {
+     public:
+	  typedef scalar_t Scalar;
+	  typedef Eigen::SparseMatrix<scalar_t, 0, int> sp_matrix_t;
+
+	  /*!
+	   * \brief Constructor
+	   *
+	   * \param rows number of rows of the matrix
+	   * \param cols number of columns of the matrix
+	   */
+	  sparse_assembler(size_t rows, size_t cols);
+
+	  //! \brief Number of rows of the matrix
+	  size_t rows() const {return rows_;}
+	  //! \brief Number of columns of the matrix
+	  size_t cols() const {return cols_;}
+
+	  /*!
+	   * \brief Reserve memory for the contributions
+	   *
+	   * \param n expected number of contributions of each thread
+	   */
+	  void reserve(size_t n);
+
+	  /*!
+	   * \brief Add a contribution to element (row, col) (thread-safe)
+	   *
+	   * \param row row index (0-based)
+	   * \param col column index (0-based)
+	   * \param value value to add
+	   */
+	  void add(int row, int col, const scalar_t& value)
+	       {
+		    const auto id = static_cast<size_t>(internal::thread_id());
+		    e2m_assert(!merged_);
+		    e2m_assert(id < buffers_.size());
+#ifdef EIGEN2MAT_RANGE_CHECK
+		    e2m_assert(row >= 0 && static_cast<size_t>(row) < rows_);
+		    e2m_assert(col >= 0 && static_cast<size_t>(col) < cols_);
+#endif /* EIGEN2MAT_RANGE_CHECK */
+		    auto& b = buffers_[id];
+		    b.rows.push_back(row);
+		    b.cols.push_back(col);
+		    b.values.push_back(value);
+	       }
+
+	  //! \brief Number of contributions added so far (not thread-safe)
+	  size_t size() const;
+
+	  /*!
+	   * \brief Merge the contributions into a new MATLAB sparse matrix
+	   *
+	   * \return MATLAB sparse matrix
+	   */
+	  mxArray* to_mxArray();
+
+	  /*!
+	   * \brief Merge the contributions into an Eigen sparse matrix
+	   *
+	   * Can be used in addition to to_mxArray(); the contributions are
+	   * only merged once.
+	   *
+	   * \param out compressed sparse matrix (resized)
+	   */
+	  void to_eigen(sp_matrix_t& out);
+
+	  //! \brief Remove all the contributions
+	  void clear();
+
+     private:
+	  // padded to keep the buffers of two threads on different cache lines
+	  struct buffer_t
+	  {
+	       buffer_t() : rows(), cols(), values(), padding() {}
+
+	       std::vector<int> rows;
+	       std::vector<int> cols;
+	       std::vector<scalar_t> values;
+	       char padding[64];
+	  };
+
+	  void merge_();
+
+	  const size_t rows_;
+	  const size_t cols_;
+	  std::vector<buffer_t> buffers_;
+
+	  // merged data: column c is stored at [start_[c], start_[c] + nnz_[c])
+	  bool merged_;
+	  std::vector<size_t> start_;
+	  std::vector<mwIndex> nnz_;
+	  std::vector<mwIndex> jc_;
+	  std::vector<int> merged_rows_;
+	  std::vector<scalar_t> merged_values_;
+     };
+
+     typedef sparse_assembler<double> real_sp_assembler_t;
+     typedef sparse_assembler<dcomplex> cmplx_sp_assembler_t;
+} // namespace eigen2mat
+
+#endif /* SPARSE_ASSEMBLER_HPP_INCLUDED */
@@ -0,0 +1,145 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef SPARSE_BLOCK_BUILDER_HPP_INCLUDED
+#define SPARSE_BLOCK_BUILDER_HPP_INCLUDED
+
+#include "eigen2mat/definitions.hpp"
+#include "eigen2mat/utils/include_mex"
+
+#include <vector>
+
+namespace eigen2mat {
+     /*!
+      * \brief Concatenation of sparse blocks, ie. <tt>[A B; C D]</tt> in
+      *        MATLAB
+      *
+      * The blocks are referenced (not copied) until the matrix is built, so
+      * they must outlive the builder. Each block may be scaled and/or
+      * (conjugate) transposed; blocks that are not set are empty. The size
+      * of a block row (column) is given by any of its blocks; set_zero()
+      * can be used to give the size of an empty block.
+      *
+      * The number of non-zeros of each column of the result is computed
+      * first, so that the result is allocated once; the CSC segments of
+      * the blocks are then copied (in parallel over the columns) straight
+      * to their final location. Transposed blocks are scattered without
+      * forming their transpose.
+      *
+      * \code
+      * e2m::real_sp_block_builder_t b(2, 2);
+      * b.set(0, 0, K);
+      * b.set(0, 1, B, 1., e2m::TRANSPOSE);
+      * b.set(1, 0, B);
+      * b.set(1, 1, C, -1.);
+      * plhs[0] = b.to_mxArray(); // [K B.'; B -C]
+      * \endcode
+      */
+     template <typename scalar_t>
+     class sparse_block_builder
+     {
+     public:
+	  typedef scalar_t Scalar;
+	  typedef Eigen::SparseMatrix<scalar_t, 0, int> sp_matrix_t;
+
+	  /*!
+	   * \brief Constructor
+	   *
+	   * \param block_rows number of block rows
+	   * \param block_cols number of block columns
+	   */
+	  sparse_block_builder(size_t block_rows, size_t block_cols);
+
+	  /*!
+	   * \brief Set block (i, j) to <tt>scale * op(m)</tt>
+	   *
+	   * \param i block row
+	   * \param j block column
+	   * \param m matrix (referenced, not copied)
+	   * \param scale scaling factor; a null factor gives an empty block
+	   * \param op operation applied to \c m
+	   */
+	  void set(size_t i, size_t j,
+		   const sp_matrix_t& m,
+		   const scalar_t& scale = scalar_t(1),
+		   TRANSPOSE_T op = NO_TRANSPOSE);
+
+	  /*!
+	   * \brief Set block (i, j) to an empty block of the given size
+	   *
+	   * \param i block row
+	   * \param j block column
+	   * \param rows number of rows of the block
+	   * \param cols number of columns of the block
+	   */
+	  void set_zero(size_t i, size_t j, size_t rows, size_t cols);
+
+	  /*!
+	   * \brief Build a new MATLAB sparse matrix
+	   *
+	   * An error is raised if the sizes of the blocks are inconsistent.
+	   *
+	   * \return MATLAB sparse matrix
+	   */
+	  mxArray* to_mxArray() const;
+
+	  /*!
+	   * \brief Build an Eigen sparse matrix
+	   *
+	   * An error is raised if the sizes of the blocks are inconsistent.
+	   *
+	   * \param out compressed sparse matrix (resized)
+	   */
+	  void to_eigen(sp_matrix_t& out) const;
+
+     private:
+	  struct block_t
+	  {
+	       const sp_matrix_t* m; //!< nullptr for empty blocks
+	       scalar_t scale;
+	       TRANSPOSE_T op;
+	       size_t rows;
+	       size_t cols;
+	       bool is_set;
+	  };
+
+	  /*
+	   * Offsets of the block rows/columns and position of the segment of
+	   * each block row in each column of the result.
+	   */
+	  struct layout_t
+	  {
+	       layout_t() : row_off(), col_off(), col_ptr(), seg_off() {}
+
+	       std::vector<size_t> row_off;  //!< First row of each block row
+	       std::vector<size_t> col_off;  //!< First column of each block column
+	       std::vector<size_t> col_ptr;  //!< Column pointers of the result
+	       std::vector<size_t> seg_off;  //!< Offset of block row i in column j (i * N + j)
+	  };
+
+	  void layout_(layout_t& l) const;
+
+	  template <typename index_t, typename store_t>
+	  void fill_(const layout_t& l, index_t* inner, store_t store) const;
+
+	  const block_t& block_(size_t i, size_t j) const
+	       {
+		    return blocks_[i * block_cols_ + j];
+	       }
+
+	  const size_t block_rows_;
+	  const size_t block_cols_;
+	  std::vector<block_t> blocks_;
+     };
+
+     typedef sparse_block_builder<double> real_sp_block_builder_t;
+     typedef sparse_block_builder<dcomplex> cmplx_sp_block_builder_t;
+} // namespace eigen2mat
+
+#endif /* SPARSE_BLOCK_BUILDER_HPP_INCLUDED */
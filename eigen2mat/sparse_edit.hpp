@@ -0,0 +1,86 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef SPARSE_EDIT_HPP_INCLUDED
+#define SPARSE_EDIT_HPP_INCLUDED
+
+#include "eigen2mat/definitions.hpp"
+#include "eigen2mat/utils/include_mex"
+
+namespace eigen2mat {
+     /*
+      * The functions below are used to reproduce the following in MATLAB :
+      *
+      * A(rows,:) = []
+      * A(:,cols) = []
+      *
+      * Indices are 0-based; they may be given in any order and may be
+      * repeated.
+      *
+      * The matrix is compacted in place in a single pass over its CSC
+      * arrays (no new storage is allocated), whatever the number of rows
+      * or columns removed. The matrix is compressed beforehand if needed.
+      *
+      * An error is raised if an index is out of range.
+      */
+     void remove_rows(real_sp_matrix_t& m, const idx_array_t& rows);
+     void remove_rows(cmplx_sp_matrix_t& m, const idx_array_t& rows);
+
+     void remove_cols(real_sp_matrix_t& m, const idx_array_t& cols);
+     void remove_cols(cmplx_sp_matrix_t& m, const idx_array_t& cols);
+
+     /*
+      * Insert the columns of \c cols into m, column k of \c cols becoming
+      * column pos[k] of the result, ie. in MATLAB :
+      *
+      * R = zeros(size(A,1), size(A,2) + size(C,2));
+      * R(:,pos) = C;
+      * R(:,setdiff(1:end,pos)) = A;
+      *
+      * The positions (0-based, in the result) must be strictly increasing.
+      *
+      * The storage of m is grown once and the columns are merged in place,
+      * from the last one to the first. \c cols may be m itself, in which
+      * case it is copied first.
+      *
+      * An error is raised if the number of rows or of positions do not
+      * match, or if the positions are invalid.
+      */
+     void insert_cols(real_sp_matrix_t& m,
+		      const idx_array_t& pos,
+		      const real_sp_matrix_t& cols);
+     void insert_cols(cmplx_sp_matrix_t& m,
+		      const idx_array_t& pos,
+		      const cmplx_sp_matrix_t& cols);
+
+     /*
+      * Same as above, but m is left untouched and the result is written
+      * directly into a new MATLAB sparse matrix. The number of non-zeros of
+      * each column is computed first so that the mxArray is allocated once,
+      * then the columns are copied in parallel.
+      */
+     mxArray* remove_rows_to_mxArray(const real_sp_matrix_t& m,
+				     const idx_array_t& rows);
+     mxArray* remove_rows_to_mxArray(const cmplx_sp_matrix_t& m,
+				     const idx_array_t& rows);
+
+     mxArray* remove_cols_to_mxArray(const real_sp_matrix_t& m,
+				     const idx_array_t& cols);
+     mxArray* remove_cols_to_mxArray(const cmplx_sp_matrix_t& m,
+				     const idx_array_t& cols);
+
+     mxArray* insert_cols_to_mxArray(const real_sp_matrix_t& m,
+				     const idx_array_t& pos,
+				     const real_sp_matrix_t& cols);
+     mxArray* insert_cols_to_mxArray(const cmplx_sp_matrix_t& m,
+				     const idx_array_t& pos,
+				     const cmplx_sp_matrix_t& cols);
+} // namespace eigen2mat
+
+#endif /* SPARSE_EDIT_HPP_INCLUDED */
@@ -13,6 +13,7 @@
 #include "eigen2mat/utils/macros.hpp"
 #include "eigen2mat/comma_initializer.hpp"
 #include "eigen2mat/sparse_slice_op.hpp"
+#include "eigen2mat/details/op_scope.hpp"
 
 #include "eigen2mat/utils/Eigen_Core"
 #include "eigen2mat/utils/Eigen_Sparse"
@@ -43,7 +44,8 @@ namespace eigen2mat {
 	  typedef typename matrix_t::Scalar Scalar;
 
 	  enum {
-	       Options = matrix_t::Options
+	       Options = matrix_t::Options,
+	       IsRowMajor = matrix_t::IsRowMajor
 	  };
 
 	  typedef sparse_slice<matrix_t> self_t;
@@ -525,23 +527,32 @@ namespace eigen2mat {
 
 	  const Index rsize = row_indices_.size();
 	  const Index csize = col_indices_.size();
+	  E2M_OP_SCOPE(SPARSE_SLICE_APPLY, rsize * csize * sizeof(Scalar), 0);
 
 	  /*
-	   * What we want to reproduce if column-major:
-	   *
-	   * for (auto i(0) ; i < other.rows() ; ++i) {
-	   *     for (auto j(0) ; j < other.cols() ; ++i) {
-	   *         ...
-	   *     }
-	   * }
+	   * Traverse the slice in the storage order of the matrix (outer
+	   * loop over the columns if column-major, over the rows if
+	   * row-major) so that coeffRef() searches (and inserts into) one
+	   * inner vector after the other.
 	   */
-
-	  for (Index j(0) ; j < csize ; ++j) {
+	  if (IsRowMajor) {
 	       for (Index i(0) ; i < rsize ; ++i) {
-		    op(
-			 mat_->coeffRef(row_indices_[i], col_indices_[j]),
-			 other.coeff(i, j)
-			 );
+		    for (Index j(0) ; j < csize ; ++j) {
+			 op(
+			      mat_->coeffRef(row_indices_[i], col_indices_[j]),
+			      other.coeff(i, j)
+			      );
+		    }
+	       }
+	  }
+	  else {
+	       for (Index j(0) ; j < csize ; ++j) {
+		    for (Index i(0) ; i < rsize ; ++i) {
+			 op(
+			      mat_->coeffRef(row_indices_[i], col_indices_[j]),
+			      other.coeff(i, j)
+			      );
+		    }
 	       }
 	  }
      }
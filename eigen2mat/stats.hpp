@@ -0,0 +1,151 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef STATS_HPP_INCLUDED
+#define STATS_HPP_INCLUDED
+
+#include "eigen2mat/utils/include_mex"
+
+#include <cstddef>
+#include <vector>
+
+#ifdef EIGEN2MAT_STATS
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#  elif defined(__i386__) || defined(__x86_64__)
+#    include <x86intrin.h>
+#  else
+#    include <chrono>
+#  endif
+#endif /* EIGEN2MAT_STATS */
+
+namespace eigen2mat {
+     namespace stats {
+	  //! \brief Operations tracked by the conversion statistics
+	  enum op_t {
+	       MXARRAY_TO_SCALAR,       //!< mxArray_to_bool/double/int/idx/cmplx
+	       MXARRAY_TO_INT_ARRAY,    //!< mxArray_to_int_array/idx_array
+	       MXARRAY_TO_REAL_DENSE,   //!< mxArray_to_real_* (dense)
+	       MXARRAY_TO_CMPLX_DENSE,  //!< mxArray_to_cmplx_* (dense)
+	       MXARRAY_TO_REAL_SPARSE,  //!< mxArray_to_real_sp_matrix
+	       MXARRAY_TO_CMPLX_SPARSE, //!< mxArray_to_cmplx_sp_matrix
+	       MXARRAY_TO_REAL_TENSOR,  //!< mxArray_to_real_tensor
+	       MXARRAY_TO_CMPLX_TENSOR, //!< mxArray_to_cmplx_tensor
+	       MXARRAY_TO_SP_CELL,      //!< mxArray_to_real/cmplx_sp_cell
+	       TO_MXARRAY_SCALAR,       //!< to_mxArray(scalar)
+	       TO_MXARRAY_INT_ARRAY,    //!< to_mxArray(int_array_t/idx_array_t)
+	       TO_MXARRAY_REAL_DENSE,   //!< to_mxArray(real Eigen matrix/expression)
+	       TO_MXARRAY_CMPLX_DENSE,  //!< to_mxArray(complex Eigen matrix/expression)
+	       TO_MXARRAY_REAL_SPARSE,  //!< to_mxArray(real_sp_matrix_t)
+	       TO_MXARRAY_CMPLX_SPARSE, //!< to_mxArray(cmplx_sp_matrix_t)
+	       TO_MXARRAY_REAL_TENSOR,  //!< to_mxArray(real_tensor_t)
+	       TO_MXARRAY_CMPLX_TENSOR, //!< to_mxArray(cmplx_tensor_t)
+	       TO_MXARRAY_SP_CELL,      //!< to_mxArray(real/cmplx_sp_cell_t)
+	       TO_MXARRAY_SPARSE_XPR,   //!< to_mxArray/prune_to_mxArray(sparse expression)
+	       TO_MXARRAY_DENSE_TO_SPARSE, //!< dense_to_sparse_mxArray
+	       MEX_ARGS,                //!< mex_args (check + conversion of all inputs)
+	       TENSOR_TO_MATRIX,        //!< tensor_to_matrix
+	       TENSOR_SLICE_ASSIGN,     //!< tensor_slice_assign
+	       TENSOR_PERMUTE,          //!< permute
+	       TENSOR_REDUCE,           //!< tensor_sum/mean/max/min/norm
+	       PAGE_MTIMES,             //!< page_mtimes
+	       PAGE_SOLVE,              //!< page_solve
+	       MODE_PRODUCT,            //!< mode_product
+	       SPARSE_SLICE_APPLY,      //!< sparse_slice assignments (=, +=, -=)
+	       SPARSE_ASSEMBLE,         //!< sparse_assembler (merge of the contributions)
+	       DENSE_SLICE,             //!< dense_slice reads & assignments (=, +=, -=)
+	       MASK_VIEW,               //!< mask_view reads & assignments (=, +=, -=)
+	       SPARSE_EDIT,             //!< remove_rows/remove_cols/insert_cols
+	       SPARSE_BLOCK_BUILD,      //!< sparse_block_builder (to_mxArray/to_eigen)
+	       SCATTER_ASSEMBLE,        //!< scatter_assembler (setup & assemble)
+	       ACCUMARRAY,              //!< accumarray, sp_accumarray
+	       N_OPS                    //!< Number of operations (not an operation)
+	  };
+
+	  //! \brief Counters for one operation
+	  struct counters_t
+	  {
+	       counters_t() : calls(0), bytes(0), allocations(0), cycles(0) {}
+
+	       unsigned long long calls;       //!< Number of calls
+	       unsigned long long bytes;       //!< Number of bytes copied
+	       unsigned long long allocations; //!< Number of objects allocated
+	       unsigned long long cycles;      //!< Elapsed time (CPU cycles)
+	  };
+
+	  /*!
+	   * \brief Name of an operation
+	   *
+	   * \param op operation
+	   * \return name of the operation (valid MATLAB identifier)
+	   */
+	  const char* op_name(op_t op);
+
+	  /*!
+	   * \brief Whether the library was compiled with statistics enabled
+	   *        (ie. with \c EIGEN2MAT_STATS defined)
+	   */
+	  bool enabled();
+
+	  /*!
+	   * \brief Add a record to the counters of the calling thread
+	   *
+	   * \param op operation
+	   * \param bytes number of bytes copied
+	   * \param allocations number of objects allocated
+	   * \param cycles elapsed CPU cycles
+	   */
+	  void record(op_t op,
+		      unsigned long long bytes,
+		      unsigned long long allocations,
+		      unsigned long long cycles);
+
+	  /*!
+	   * \brief Aggregate the counters of all threads
+	   *
+	   * \return one set of counters per operation (indexed by op_t)
+	   */
+	  std::vector<counters_t> collect();
+
+	  //! \brief Reset the counters of all threads
+	  void reset();
+
+	  /*!
+	   * \brief Convert the aggregated counters to a MATLAB struct
+	   *
+	   * The struct has the following fields:
+	   * - \c enabled: logical, false if the library was compiled without
+	   *   \c EIGEN2MAT_STATS
+	   * - \c name: cell array with the name of each operation
+	   * - \c calls, \c bytes, \c allocations, \c cycles: column vectors
+	   *   (double) with one element per operation
+	   *
+	   * In MATLAB, \c struct2table(rmfield(s, 'enabled')) gives a nice
+	   * overview.
+	   *
+	   * \return MATLAB struct
+	   */
+	  mxArray* to_mxArray();
+
+#ifdef EIGEN2MAT_STATS
+	  //! \brief Read the CPU time-stamp counter (or a steady clock)
+	  inline unsigned long long read_cycles()
+	  {
+#  if defined(_MSC_VER) || defined(__i386__) || defined(__x86_64__)
+	       return __rdtsc();
+#  else
+	       return static_cast<unsigned long long>(
+		    std::chrono::steady_clock::now().time_since_epoch().count());
+#  endif
+	  }
+#endif /* EIGEN2MAT_STATS */
+     } // namespace stats
+} // namespace eigen2mat
+
+#endif /* STATS_HPP_INCLUDED */
@@ -12,51 +12,68 @@
 
 #include "eigen2mat/utils/macros.hpp"
 #include "eigen2mat/utils/include_mex"
+#include "eigen2mat/utils/parallel.hpp"
 
 #include <vector>
 
 namespace eigen2mat {
      CLANG_IGNORE_WARNINGS_ONE(-Wsign-conversion)
 
+     /*!
+      * \brief Range of consecutive pages of a tensor (or of a cell array of
+      *        sparse matrices)
+      *
+      * The block does not own its pages: it only keeps iterators into the
+      * underlying container, which must outlive it and not be resized.
+      */
      template <typename tensor_t>
      class tensor_block_t
      {
 	  typedef std::size_t size_t;
+
+     public:
 	  typedef typename tensor_t::value_type value_type;
+	  typedef typename tensor_t::reference reference;
+	  typedef typename tensor_t::const_reference const_reference;
 	  typedef typename tensor_t::iterator iterator;
 	  typedef typename tensor_t::const_iterator const_iterator;
-	  typedef typename tensor_t::reverse_iterator reverse_iterator;
-	  typedef typename tensor_t::const_reverse_iterator const_reverse_iterator;
+	  typedef size_t size_type;
 
-     public:
 	  tensor_block_t(tensor_t& t, 
 			 size_t start,
 			 size_t n_mat)
 	       : begin_(t.begin() + start), end_(t.begin() + start + n_mat)
 	       {}
 
-	  value_type& operator[] (size_t k)
+	  reference operator[] (size_t k)
 	       { 
 #ifdef EIGEN2MAT_RANGE_CHECK
-		    if (k > (end_ - begin_) ) {
+		    if (k >= size()) {
 			 mexErrMsgTxt("tensor_block_t::operator[]: index out of range!");
 		    }
 #endif /* EIGEN2MAT_RANGE_CHECK */
 		    return *(begin_ + k);
 	       }
 
-	  value_type operator[] (size_t k) const
+	  const_reference operator[] (size_t k) const
 	       { 
 #ifdef EIGEN2MAT_RANGE_CHECK
-		    if (k > (end_ - begin_) ) {
+		    if (k >= size()) {
 			 mexErrMsgTxt("tensor_block_t::operator[]: index out of range!");
-			 return value_type();
 		    }
 #endif /* EIGEN2MAT_RANGE_CHECK */
 		    return *(begin_ + k);
 	       }
 
+	  iterator begin() {return begin_;}
+	  iterator end() {return end_;}
+	  const_iterator begin() const {return begin_;}
+	  const_iterator end() const {return end_;}
+	  const_iterator cbegin() const {return begin_;}
+	  const_iterator cend() const {return end_;}
+
 	  size_t size() const {return (end_ - begin_);}
+	  bool empty() const {return begin_ == end_;}
 
 	  CLANG_RESTORE_WARNINGS
 
@@ -64,6 +81,42 @@ namespace eigen2mat {
 	  const iterator begin_;
 	  const iterator end_;
      };
+
+     /*!
+      * \brief Call f(page) for each page of a block
+      *
+      * Pages are distributed over the OpenMP threads (dynamic schedule, so
+      * that pages of different costs, eg. sparse matrices, balance well).
+      * Runs serially if OpenMP is disabled.
+      *
+      * \warning \c f must not call any function of the MEX API that may
+      *          fail (mexErrMsgTxt & co are not thread-safe)
+      *
+      * \param block block of pages
+      * \param f function object taking a (const) reference to a page
+      */
+     template <typename tensor_t, typename function_t>
+     void parallel_for_each(tensor_block_t<tensor_t>& block, function_t f)
+     {
+	  const auto first = block.begin();
+	  internal::parallel_for_dynamic(
+	       0, block.size(),
+	       [&](internal::par_index_t k) {
+		    f(*(first + k));
+	       });
+     }
+
+     //! \brief Overload for const blocks
+     template <typename tensor_t, typename function_t>
+     void parallel_for_each(const tensor_block_t<tensor_t>& block, function_t f)
+     {
+	  const auto first = block.cbegin();
+	  internal::parallel_for_dynamic(
+	       0, block.size(),
+	       [&](internal::par_index_t k) {
+		    f(*(first + k));
+	       });
+     }
 } // namespace eigen2mat
 
 #endif /* TENSOR_BLOCK_HPP_INCLUDED */
@@ -0,0 +1,59 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef TENSOR_MODE_PRODUCT_HPP_INCLUDED
+#define TENSOR_MODE_PRODUCT_HPP_INCLUDED
+
+#include "eigen2mat/definitions.hpp"
+#include "eigen2mat/tensor_to_matrix.hpp"
+#include "eigen2mat/utils/include_mex"
+
+namespace eigen2mat {
+     /*
+      * The functions below compute the mode-n product r = t x_n u of a
+      * M x N x P tensor with a matrix u, ie. in MATLAB :
+      *
+      * For dim = X (u is J x M, r is J x N x P)
+      * r(:,:,k) = u * t(:,:,k)
+      *
+      * For dim = Y (u is J x N, r is M x J x P)
+      * r(:,:,k) = t(:,:,k) * u.'
+      *
+      * For dim = Z (u is J x P, r is M x N x J)
+      * r(:,:,j) = sum_k u(j,k) * t(:,:,k)
+      *
+      * X and Y products are one matrix product per page. Z products are
+      * computed by panels of rows of the pages, each panel being one matrix
+      * product with u.', so that the tensor is never unfolded as a whole.
+      * Work is distributed over the OpenMP threads.
+      *
+      * An error is raised if the dimensions of u do not match.
+      */
+     real_tensor_t mode_product(const real_tensor_t& t,
+				const real_matrix_t& u,
+				DIR_T dim);
+
+     cmplx_tensor_t mode_product(const cmplx_tensor_t& t,
+				 const cmplx_matrix_t& u,
+				 DIR_T dim);
+
+     /*
+      * Same as above but writes the result directly into a new MATLAB array,
+      * without going through a temporary tensor.
+      */
+     mxArray* mode_product_to_mxArray(const real_tensor_t& t,
+				      const real_matrix_t& u,
+				      DIR_T dim);
+
+     mxArray* mode_product_to_mxArray(const cmplx_tensor_t& t,
+				      const cmplx_matrix_t& u,
+				      DIR_T dim);
+} // namespace eigen2mat
+
+#endif /* TENSOR_MODE_PRODUCT_HPP_INCLUDED */
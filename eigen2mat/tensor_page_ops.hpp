@@ -0,0 +1,119 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef TENSOR_PAGE_OPS_HPP_INCLUDED
+#define TENSOR_PAGE_OPS_HPP_INCLUDED
+
+#include "eigen2mat/definitions.hpp"
+
+namespace eigen2mat {
+     /*
+      * The functions below are used to reproduce the following in MATLAB :
+      *
+      * pagemtimes(a, ta, b, tb)
+      *
+      * ie. r(:,:,k) = op(a(:,:,k)) * op(b(:,:,k)) for each page k. A matrix
+      * operand (or a tensor with a single page) is used for every page.
+      *
+      * Pages are distributed over the OpenMP threads. Square pages of size
+      * 2, 3 or 4 use kernels specialised at compile time.
+      *
+      * An error is raised if the dimensions of the operands do not match.
+      */
+     real_tensor_t page_mtimes(const real_tensor_t& a,
+			       const real_tensor_t& b,
+			       TRANSPOSE_T ta = NO_TRANSPOSE,
+			       TRANSPOSE_T tb = NO_TRANSPOSE);
+     real_tensor_t page_mtimes(const real_tensor_t& a,
+			       const real_matrix_t& b,
+			       TRANSPOSE_T ta = NO_TRANSPOSE,
+			       TRANSPOSE_T tb = NO_TRANSPOSE);
+     real_tensor_t page_mtimes(const real_matrix_t& a,
+			       const real_tensor_t& b,
+			       TRANSPOSE_T ta = NO_TRANSPOSE,
+			       TRANSPOSE_T tb = NO_TRANSPOSE);
+
+     cmplx_tensor_t page_mtimes(const cmplx_tensor_t& a,
+				const cmplx_tensor_t& b,
+				TRANSPOSE_T ta = NO_TRANSPOSE,
+				TRANSPOSE_T tb = NO_TRANSPOSE);
+     cmplx_tensor_t page_mtimes(const cmplx_tensor_t& a,
+				const cmplx_matrix_t& b,
+				TRANSPOSE_T ta = NO_TRANSPOSE,
+				TRANSPOSE_T tb = NO_TRANSPOSE);
+     cmplx_tensor_t page_mtimes(const cmplx_matrix_t& a,
+				const cmplx_tensor_t& b,
+				TRANSPOSE_T ta = NO_TRANSPOSE,
+				TRANSPOSE_T tb = NO_TRANSPOSE);
+
+     /*
+      * Same as above for tensor blocks; the result is written into the pages
+      * of out (resized if necessary), which must have as many pages as the
+      * operands.
+      */
+     void page_mtimes(const real_tblock_t& a,
+		      const real_tblock_t& b,
+		      real_tblock_t& out,
+		      TRANSPOSE_T ta = NO_TRANSPOSE,
+		      TRANSPOSE_T tb = NO_TRANSPOSE);
+     void page_mtimes(const real_tblock_t& a,
+		      const real_matrix_t& b,
+		      real_tblock_t& out,
+		      TRANSPOSE_T ta = NO_TRANSPOSE,
+		      TRANSPOSE_T tb = NO_TRANSPOSE);
+     void page_mtimes(const real_matrix_t& a,
+		      const real_tblock_t& b,
+		      real_tblock_t& out,
+		      TRANSPOSE_T ta = NO_TRANSPOSE,
+		      TRANSPOSE_T tb = NO_TRANSPOSE);
+
+     void page_mtimes(const cmplx_tblock_t& a,
+		      const cmplx_tblock_t& b,
+		      cmplx_tblock_t& out,
+		      TRANSPOSE_T ta = NO_TRANSPOSE,
+		      TRANSPOSE_T tb = NO_TRANSPOSE);
+     void page_mtimes(const cmplx_tblock_t& a,
+		      const cmplx_matrix_t& b,
+		      cmplx_tblock_t& out,
+		      TRANSPOSE_T ta = NO_TRANSPOSE,
+		      TRANSPOSE_T tb = NO_TRANSPOSE);
+     void page_mtimes(const cmplx_matrix_t& a,
+		      const cmplx_tblock_t& b,
+		      cmplx_tblock_t& out,
+		      TRANSPOSE_T ta = NO_TRANSPOSE,
+		      TRANSPOSE_T tb = NO_TRANSPOSE);
+
+     /*
+      * The functions below are used to reproduce the following in MATLAB :
+      *
+      * pagemldivide(a, b)
+      *
+      * ie. r(:,:,k) = a(:,:,k) \ b(:,:,k) for each page k, using a LU
+      * decomposition with partial pivoting (pages of a must be square and
+      * invertible). When a is a matrix, it is only factorised once.
+      */
+     real_tensor_t page_solve(const real_tensor_t& a, const real_tensor_t& b);
+     real_tensor_t page_solve(const real_tensor_t& a, const real_matrix_t& b);
+     real_tensor_t page_solve(const real_matrix_t& a, const real_tensor_t& b);
+
+     cmplx_tensor_t page_solve(const cmplx_tensor_t& a, const cmplx_tensor_t& b);
+     cmplx_tensor_t page_solve(const cmplx_tensor_t& a, const cmplx_matrix_t& b);
+     cmplx_tensor_t page_solve(const cmplx_matrix_t& a, const cmplx_tensor_t& b);
+
+     //! \brief Same as above for tensor blocks (see page_mtimes())
+     void page_solve(const real_tblock_t& a, const real_tblock_t& b, real_tblock_t& out);
+     void page_solve(const real_tblock_t& a, const real_matrix_t& b, real_tblock_t& out);
+     void page_solve(const real_matrix_t& a, const real_tblock_t& b, real_tblock_t& out);
+
+     void page_solve(const cmplx_tblock_t& a, const cmplx_tblock_t& b, cmplx_tblock_t& out);
+     void page_solve(const cmplx_tblock_t& a, const cmplx_matrix_t& b, cmplx_tblock_t& out);
+     void page_solve(const cmplx_matrix_t& a, const cmplx_tblock_t& b, cmplx_tblock_t& out);
+} // namespace eigen2mat
+
+#endif /* TENSOR_PAGE_OPS_HPP_INCLUDED */
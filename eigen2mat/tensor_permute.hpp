@@ -0,0 +1,50 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef TENSOR_PERMUTE_HPP_INCLUDED
+#define TENSOR_PERMUTE_HPP_INCLUDED
+
+#include "eigen2mat/definitions.hpp"
+#include "eigen2mat/tensor_to_matrix.hpp"
+#include "eigen2mat/utils/include_mex"
+
+#include <array>
+
+namespace eigen2mat {
+     //! \brief Order of the dimensions for permute()
+     typedef std::array<DIR_T, 3> dir_order_t;
+
+     /*
+      * The functions below are used to reproduce the following in MATLAB :
+      *
+      * permute(t, order)
+      *
+      * ie. dimension d of the result is dimension order[d] of t. For example,
+      * {Y, X, Z} transposes every page and {Z, X, Y} makes the pages run along
+      * the first dimension.
+      *
+      * The copy is done by tiles so that both the reads and the writes stay
+      * in cache, tiles being distributed over the OpenMP threads.
+      *
+      * An error is raised if order is not a permutation of {X, Y, Z}.
+      */
+     real_tensor_t permute(const real_tensor_t& t, const dir_order_t& order);
+
+     cmplx_tensor_t permute(const cmplx_tensor_t& t, const dir_order_t& order);
+
+     /*
+      * Same as above but writes the result directly into a new MATLAB array,
+      * without going through a temporary tensor.
+      */
+     mxArray* permute_to_mxArray(const real_tensor_t& t, const dir_order_t& order);
+
+     mxArray* permute_to_mxArray(const cmplx_tensor_t& t, const dir_order_t& order);
+} // namespace eigen2mat
+
+#endif /* TENSOR_PERMUTE_HPP_INCLUDED */
@@ -0,0 +1,80 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef TENSOR_REDUCE_HPP_INCLUDED
+#define TENSOR_REDUCE_HPP_INCLUDED
+
+#include "eigen2mat/definitions.hpp"
+#include "eigen2mat/tensor_to_matrix.hpp"
+
+namespace eigen2mat {
+     //! \brief Order in which the elements are accumulated by the reductions
+     enum REDUCE_ORDER_T {
+	  ANY_ORDER,  //!< Fastest; results may vary in the last bits with the number of threads
+	  FIXED_ORDER //!< Results identical whatever the number of threads
+     };
+
+     /*
+      * The functions below are used to reproduce the following in MATLAB :
+      *
+      * For dim = X (result is N x P)
+      * squeeze(sum(t, 1))
+      *
+      * For dim = Y (result is M x P)
+      * squeeze(sum(t, 2))
+      *
+      * For dim = Z (result is M x N)
+      * sum(t, 3)
+      *
+      * and likewise for mean, max, min and norm (ie. sqrt(sum(abs(t).^2, dim))).
+      * The result is empty if the tensor is empty (third dim == 0). As in
+      * MATLAB, max and min ignore NaN values (the result is NaN only if all
+      * the reduced values are NaN).
+      *
+      * X and Y reductions are done page by page, Z reductions accumulate
+      * whole pages; both are vectorised and parallel if OpenMP is enabled.
+      * Only Z reductions with ANY_ORDER may split the pages between threads
+      * (when a page has too few columns to keep all threads busy), in which
+      * case the partial results are combined at the end.
+      */
+     real_matrix_t tensor_sum(const real_tensor_t& t,
+			      DIR_T dim,
+			      REDUCE_ORDER_T order = ANY_ORDER);
+
+     cmplx_matrix_t tensor_sum(const cmplx_tensor_t& t,
+			       DIR_T dim,
+			       REDUCE_ORDER_T order = ANY_ORDER);
+
+     real_matrix_t tensor_mean(const real_tensor_t& t,
+			       DIR_T dim,
+			       REDUCE_ORDER_T order = ANY_ORDER);
+
+     cmplx_matrix_t tensor_mean(const cmplx_tensor_t& t,
+				DIR_T dim,
+				REDUCE_ORDER_T order = ANY_ORDER);
+
+     // NB: only available for real tensors (complex numbers are not ordered)
+     real_matrix_t tensor_max(const real_tensor_t& t,
+			      DIR_T dim,
+			      REDUCE_ORDER_T order = ANY_ORDER);
+
+     real_matrix_t tensor_min(const real_tensor_t& t,
+			      DIR_T dim,
+			      REDUCE_ORDER_T order = ANY_ORDER);
+
+     real_matrix_t tensor_norm(const real_tensor_t& t,
+			       DIR_T dim,
+			       REDUCE_ORDER_T order = ANY_ORDER);
+
+     real_matrix_t tensor_norm(const cmplx_tensor_t& t,
+			       DIR_T dim,
+			       REDUCE_ORDER_T order = ANY_ORDER);
+} // namespace eigen2mat
+
+#endif /* TENSOR_REDUCE_HPP_INCLUDED */
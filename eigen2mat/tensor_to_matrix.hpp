@@ -11,6 +11,7 @@
 #define TENSOR_TO_MATRIX_HPP_INCLUDED
 
 #include "eigen2mat/definitions.hpp"
+#include "eigen2mat/utils/include_mex"
 
 namespace eigen2mat {
      //! \brief Type of directions available
@@ -20,6 +21,21 @@ namespace eigen2mat {
 	  Z  //!< Slicing along the Z direction (ie. third component)
      };
 
+     /*
+      * The functions below are used to reproduce the following in MATLAB :
+      *
+      * For dim = X (result is N x P)
+      * squeeze(t(idx, :, :))
+      *
+      * For dim = Y (result is M x P)
+      * squeeze(t(:, idx, :))
+      *
+      * For dim = Z (result is M x N)
+      * t(:, :, idx)
+      *
+      * The result is empty if the tensor is empty (third dim == 0).
+      * Pages are processed in parallel if OpenMP is enabled.
+      */
      real_matrix_t tensor_to_matrix(const real_tensor_t& t, 
 				    DIR_T dim, 
 				    size_t idx);
@@ -28,6 +44,33 @@ namespace eigen2mat {
 				     DIR_T dim, 
 				     size_t idx);
 
+     /*
+      * Same as above but writes the result into a preallocated matrix (only
+      * resized if its dimensions do not match) so that a loop over slices
+      * does not allocate.
+      */
+     void tensor_to_matrix(const real_tensor_t& t,
+			   DIR_T dim,
+			   size_t idx,
+			   real_matrix_t& out);
+
+     void tensor_to_matrix(const cmplx_tensor_t& t,
+			   DIR_T dim,
+			   size_t idx,
+			   cmplx_matrix_t& out);
+
+     /*
+      * Same as above but writes the result directly into a new MATLAB array,
+      * without going through a temporary matrix.
+      */
+     mxArray* tensor_to_mxArray(const real_tensor_t& t,
+				DIR_T dim,
+				size_t idx);
+
+     mxArray* tensor_to_mxArray(const cmplx_tensor_t& t,
+				DIR_T dim,
+				size_t idx);
+
      /*
       * The two functions below are used to reproduce the following in MATLAB :
       * WARNING function is NO-OP is tensor is empty (third dim == 0)
@@ -37,6 +80,13 @@ namespace eigen2mat {
       *
       * For dim_lhs = Y & dim_rhs = Y
       * t_lhs(:, idx_lhs, :) = t_rhs(:, idx_rhs, :) 
+      *
+      * Any other combination of directions is supported as well, the slices
+      * being seen as matrices as returned by tensor_to_matrix. For example,
+      * for dim_lhs = X & dim_rhs = Z
+      * t_lhs(idx_lhs, :, :) = t_rhs(:, :, idx_rhs)
+      *
+      * t_lhs and t_rhs may be the same tensor.
       */
      void tensor_slice_assign(real_tensor_t& t_lhs, DIR_T dim_lhs, size_t idx_lhs,
 			      const real_tensor_t& t_rhs, DIR_T dim_rhs, size_t idx_rhs);
@@ -55,7 +105,7 @@ namespace eigen2mat {
       * t_lhs(:, idx_lhs, :) = m_rhs
       *
       * For dim_lhs = Z
-      * t_lhs(:, idx_lhs, :) = m_rhs
+      * t_lhs(:, :, idx_lhs) = m_rhs
       */
      void tensor_slice_assign(real_tensor_t& t_lhs, DIR_T dim_lhs, size_t idx_lhs,
 			      const real_matrix_t& m_rhs);
@@ -0,0 +1,97 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef TRACE_HPP_INCLUDED
+#define TRACE_HPP_INCLUDED
+
+#include "eigen2mat/stats.hpp"
+
+#include <cstddef>
+
+#ifdef EIGEN2MAT_TRACE
+#  include <atomic>
+#  include <chrono>
+#endif /* EIGEN2MAT_TRACE */
+
+namespace eigen2mat {
+     namespace trace {
+	  /*!
+	   * \brief Whether the library was compiled with tracing support
+	   *        (ie. with \c EIGEN2MAT_TRACE defined)
+	   */
+	  bool enabled();
+
+	  /*!
+	   * \brief Start recording spans
+	   *
+	   * Each thread records its spans into its own ring buffer; once a
+	   * buffer is full, the oldest spans get overwritten.
+	   *
+	   * \param capacity number of spans per thread (only applies to
+	   *                 threads that have not recorded anything yet)
+	   */
+	  void start(std::size_t capacity = 65536);
+
+	  //! \brief Stop recording spans (recorded spans are kept until flush())
+	  void stop();
+
+	  /*!
+	   * \brief Write the recorded spans to a file in the Chrome trace event
+	   *        format and clear the buffers
+	   *
+	   * The file can be opened with chrome://tracing or
+	   * https://ui.perfetto.dev. Can be called while tracing is active.
+	   *
+	   * \param filename name of the JSON file to create
+	   * \return number of spans written
+	   */
+	  std::size_t flush(const char* filename);
+
+	  /*!
+	   * \brief Number of spans lost because a ring buffer was full since
+	   *        the last call to start()
+	   */
+	  std::size_t dropped();
+
+#ifdef EIGEN2MAT_TRACE
+	  namespace internal {
+	       extern std::atomic<bool> active;
+	  } // namespace internal
+
+	  //! \brief Whether spans are currently being recorded
+	  inline bool is_active()
+	  {
+	       return internal::active.load(std::memory_order_relaxed);
+	  }
+
+	  //! \brief Current time in nanoseconds (steady clock)
+	  inline unsigned long long now()
+	  {
+	       return static_cast<unsigned long long>(
+		    std::chrono::duration_cast<std::chrono::nanoseconds>(
+			 std::chrono::steady_clock::now().time_since_epoch()).count());
+	  }
+
+	  /*!
+	   * \brief Add a span to the ring buffer of the calling thread
+	   *
+	   * \param op operation
+	   * \param bytes number of bytes copied
+	   * \param begin start time (see now())
+	   * \param end end time (see now())
+	   */
+	  void record(stats::op_t op,
+		      unsigned long long bytes,
+		      unsigned long long begin,
+		      unsigned long long end);
+#endif /* EIGEN2MAT_TRACE */
+     } // namespace trace
+} // namespace eigen2mat
+
+#endif /* TRACE_HPP_INCLUDED */
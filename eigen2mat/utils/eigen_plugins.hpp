@@ -11,5 +11,6 @@
 #define EIGEN_PLUGINS_HPP_INCLUDED
 
 #define EIGEN_SPARSEMATRIX_PLUGIN "eigen2mat/plugins/sparse_matrix_plugin.hpp"
+#define EIGEN_MATRIXBASE_PLUGIN "eigen2mat/plugins/matrix_base_plugin.hpp"
 
 #endif /* EIGEN_PLUGINS_HPP_INCLUDED */
@@ -7,6 +7,9 @@ namespace eigen2mat {
      template<typename matrix_t> 
      class sparse_slice;
 
+     template<typename matrix_t> 
+     class dense_slice;
+
 } // namespace eigen2mat
 
 
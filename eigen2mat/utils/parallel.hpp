@@ -0,0 +1,192 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef PARALLEL_HPP_INCLUDED
+#define PARALLEL_HPP_INCLUDED
+
+#include <cstddef>
+#include <vector>
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif /* _OPENMP */
+
+namespace eigen2mat {
+     namespace internal {
+	  typedef std::ptrdiff_t par_index_t;
+
+	  /*!
+	   * \brief Number of threads available to the parallel helpers
+	   *
+	   * \return 1 if OpenMP is disabled or if we are already running inside
+	   *         a parallel region
+	   */
+	  inline int max_threads()
+	  {
+#ifdef _OPENMP
+	       return omp_in_parallel() ? 1 : omp_get_max_threads();
+#else
+	       return 1;
+#endif /* _OPENMP */
+	  }
+
+	  /*!
+	   * \brief Index of the calling thread inside the current parallel region
+	   */
+	  inline int thread_id()
+	  {
+#ifdef _OPENMP
+	       return omp_get_thread_num();
+#else
+	       return 0;
+#endif /* _OPENMP */
+	  }
+
+	  /*!
+	   * \brief Compute the number of chunks to split a range of \c n items
+	   *
+	   * \param n number of items
+	   * \param min_size minimum number of items per chunk
+	   * \return number of chunks (at least 1)
+	   */
+	  inline par_index_t num_chunks(par_index_t n, par_index_t min_size)
+	  {
+	       const par_index_t T = max_threads();
+	       if (min_size < 1) {
+		    min_size = 1;
+	       }
+	       par_index_t c = n / min_size;
+	       if (c > T) {
+		    c = T;
+	       }
+	       return c < 1 ? 1 : c;
+	  }
+
+	  /*!
+	   * \brief Bounds of chunk \c c when splitting \c n items into
+	   *        \c n_chunks contiguous chunks of (nearly) equal size
+	   */
+	  inline void chunk_range(par_index_t n, par_index_t n_chunks, par_index_t c,
+				  par_index_t& begin, par_index_t& end)
+	  {
+	       const par_index_t q = n / n_chunks;
+	       const par_index_t r = n % n_chunks;
+	       begin = c * q + (c < r ? c : r);
+	       end = begin + q + (c < r ? 1 : 0);
+	  }
+
+	  /*!
+	   * \brief Call f(i) for all i in [begin, end)
+	   *
+	   * Iterations are statically distributed over the OpenMP threads. The
+	   * loop runs serially if OpenMP is disabled, if we are already inside a
+	   * parallel region or if the range has less than \c min_size items.
+	   *
+	   * \warning \c f must not call any function of the MEX API that may
+	   *          fail (mexErrMsgTxt & co are not thread-safe)
+	   */
+	  template <typename function_t>
+	  void parallel_for(par_index_t begin, par_index_t end,
+			    function_t f, par_index_t min_size = 2)
+	  {
+#ifdef _OPENMP
+	       if (end - begin >= min_size && max_threads() > 1) {
+#pragma omp parallel for schedule(static)
+		    for (par_index_t i = begin ; i < end ; ++i) {
+			 f(i);
+		    }
+		    return;
+	       }
+#else
+	       (void) min_size;
+#endif /* _OPENMP */
+	       for (par_index_t i(begin) ; i < end ; ++i) {
+		    f(i);
+	       }
+	  }
+
+	  /*!
+	   * \brief Same as parallel_for() but with dynamic scheduling
+	   *
+	   * Use this one when the cost of each iteration varies a lot (cell
+	   * arrays of sparse matrices for example).
+	   */
+	  template <typename function_t>
+	  void parallel_for_dynamic(par_index_t begin, par_index_t end,
+				    function_t f, par_index_t min_size = 2)
+	  {
+#ifdef _OPENMP
+	       if (end - begin >= min_size && max_threads() > 1) {
+#pragma omp parallel for schedule(dynamic)
+		    for (par_index_t i = begin ; i < end ; ++i) {
+			 f(i);
+		    }
+		    return;
+	       }
+#else
+	       (void) min_size;
+#endif /* _OPENMP */
+	       for (par_index_t i(begin) ; i < end ; ++i) {
+		    f(i);
+	       }
+	  }
+
+	  /*!
+	   * \brief Exclusive prefix sum: out[0] = 0 and
+	   *        out[i+1] = in[0] + ... + in[i] for i in [0, n)
+	   *
+	   * The range is split into chunks; the sum of each chunk is computed in
+	   * parallel, the chunk offsets are accumulated serially and the chunks
+	   * are then scanned in parallel.
+	   *
+	   * \param n number of input items (\c out must hold n+1 items)
+	   * \param in input values
+	   * \param out prefix sums
+	   * \param min_size minimum number of items per chunk
+	   * \return total sum (ie. out[n])
+	   */
+	  template <typename in_t, typename out_t>
+	  out_t parallel_exclusive_scan(par_index_t n, const in_t* in, out_t* out,
+					par_index_t min_size = 16384)
+	  {
+	       const auto n_chunks = num_chunks(n, min_size);
+	       std::vector<out_t> offsets(n_chunks + 1, out_t(0));
+
+	       parallel_for(
+		    0, n_chunks,
+		    [&](par_index_t c) {
+			 par_index_t begin(0), end(0);
+			 chunk_range(n, n_chunks, c, begin, end);
+			 out_t sum(0);
+			 for (auto i(begin) ; i < end ; ++i) {
+			      sum += in[i];
+			 }
+			 offsets[c+1] = sum;
+		    });
+	       for (par_index_t c(0) ; c < n_chunks ; ++c) {
+		    offsets[c+1] += offsets[c];
+	       }
+	       parallel_for(
+		    0, n_chunks,
+		    [&](par_index_t c) {
+			 par_index_t begin(0), end(0);
+			 chunk_range(n, n_chunks, c, begin, end);
+			 auto sum = offsets[c];
+			 for (auto i(begin) ; i < end ; ++i) {
+			      out[i] = sum;
+			      sum += in[i];
+			 }
+		    });
+	       out[n] = offsets[n_chunks];
+	       return out[n];
+	  }
+     } // namespace internal
+} // namespace eigen2mat
+
+#endif /* PARALLEL_HPP_INCLUDED */
@@ -0,0 +1,698 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "eigen2mat/accumarray.hpp"
+#include "eigen2mat/details/mxarray_helpers.hpp"
+#include "eigen2mat/details/nan_ops.hpp"
+#include "eigen2mat/details/op_scope.hpp"
+#include "eigen2mat/utils/macros.hpp"
+#include "eigen2mat/utils/parallel.hpp"
+
+#include "eigen2mat/utils/include_mex"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace e2m = eigen2mat;
+
+MSVC_IGNORE_WARNINGS(4267)
+CLANG_IGNORE_WARNINGS_TWO(-Wshorten-64-to-32,-Wsign-conversion)
+
+namespace {
+     typedef e2m::internal::par_index_t par_index_t;
+
+     using e2m::internal::nan_max;
+     using e2m::internal::nan_min;
+
+     // Minimum number of values per chunk
+     const par_index_t accum_chunk_size = 16384;
+
+     /*
+      * Each bin holds a value and the number of values accumulated into it
+      * (needed by count & mean, and to tell empty bins from the others for
+      * max & min).
+      *
+      * As in MATLAB, max & min ignore NaN values (a bin is NaN only if all
+      * its values are NaN, cf. nan_ops.hpp), so the result does not depend
+      * on the order in which the values are reduced.
+      */
+     struct sum_reducer_t
+     {
+	  static void add(double& v, double x) {v += x;}
+	  static void merge(double& v, e2m::size_t, double v2) {v += v2;}
+	  static double finalize(double v, e2m::size_t) {return v;}
+     };
+
+     struct max_reducer_t
+     {
+	  static void add(double& v, double x) {v = nan_max(v, x);}
+	  static void merge(double& v, e2m::size_t n, double v2)
+	       {
+		    v = n == 0 ? v2 : nan_max(v, v2);
+	       }
+	  static double finalize(double v, e2m::size_t) {return v;}
+     };
+
+     struct min_reducer_t
+     {
+	  static void add(double& v, double x) {v = nan_min(v, x);}
+	  static void merge(double& v, e2m::size_t n, double v2)
+	       {
+		    v = n == 0 ? v2 : nan_min(v, v2);
+	       }
+	  static double finalize(double v, e2m::size_t) {return v;}
+     };
+
+     struct count_reducer_t
+     {
+	  static void add(double&, double) {}
+	  static void merge(double&, e2m::size_t, double) {}
+	  static double finalize(double, e2m::size_t n)
+	       {
+		    return static_cast<double>(n);
+	       }
+     };
+
+     struct mean_reducer_t : sum_reducer_t
+     {
+	  static double finalize(double v, e2m::size_t n)
+	       {
+		    return v / static_cast<double>(n);
+	       }
+     };
+
+     //! Add x to a bin holding n values
+     template <typename reducer_t>
+     inline void add_value(double& v, e2m::size_t& n, double x)
+     {
+	  if (n == 0) {
+	       v = x;
+	  }
+	  else {
+	       reducer_t::add(v, x);
+	  }
+	  ++n;
+     }
+
+     //! Merge bin (v2, n2) into bin (v, n)
+     template <typename reducer_t>
+     inline void merge_bin(double& v, e2m::size_t& n, double v2, e2m::size_t n2)
+     {
+	  if (n2 != 0) {
+	       reducer_t::merge(v, n, v2);
+	       n += n2;
+	  }
+     }
+
+     template <typename reducer_t>
+     inline double final_value(double v, e2m::size_t n)
+     {
+	  return n == 0 ? 0. : reducer_t::finalize(v, n);
+     }
+
+     // =========================================================================
+
+     //! Linear subscripts of a 1D accumarray
+     template <typename index_array_t>
+     struct subs_1d_t
+     {
+	  subs_1d_t(const index_array_t& subs, e2m::size_t n)
+	       : subs_(subs), n_(n) {}
+
+	  e2m::size_t size() const {return subs_.size();}
+	  e2m::size_t n_bins() const {return n_;}
+	  bool valid(e2m::size_t k) const
+	       {
+		    // negative subscripts wrap around to large values
+		    return static_cast<e2m::size_t>(subs_[k]) < n_;
+	       }
+	  e2m::size_t bin(e2m::size_t k) const {return subs_[k];}
+
+	  const index_array_t& subs_;
+	  const e2m::size_t n_;
+     };
+
+     //! Linear (column-major) subscripts of a 2D accumarray
+     template <typename index_array_t>
+     struct subs_2d_t
+     {
+	  subs_2d_t(const index_array_t& rows, const index_array_t& cols,
+		    e2m::size_t M, e2m::size_t N)
+	       : rows_(rows), cols_(cols), M_(M), N_(N)
+	       {
+		    if (rows.size() != cols.size()) {
+			 mexErrMsgIdAndTxt("eigen2mat:invalid_argument",
+					   "accumarray(): %d row subscripts but "
+					   "%d column subscripts",
+					   static_cast<int>(rows.size()),
+					   static_cast<int>(cols.size()));
+		    }
+	       }
+
+	  e2m::size_t size() const {return rows_.size();}
+	  e2m::size_t n_bins() const {return M_ * N_;}
+	  bool valid(e2m::size_t k) const
+	       {
+		    return static_cast<e2m::size_t>(rows_[k]) < M_
+			 && static_cast<e2m::size_t>(cols_[k]) < N_;
+	       }
+	  e2m::size_t bin(e2m::size_t k) const
+	       {
+		    return rows_[k] + cols_[k] * M_;
+	       }
+
+	  const index_array_t& rows_;
+	  const index_array_t& cols_;
+	  const e2m::size_t M_;
+	  const e2m::size_t N_;
+     };
+
+     template <typename subs_t>
+     void check_subs(const subs_t& subs,
+		     const e2m::real_vector_t& vals,
+		     e2m::ACCUM_OP_T op)
+     {
+	  const par_index_t n = subs.size();
+	  if (!(op == e2m::ACCUM_COUNT && vals.size() == 0)
+	      && vals.size() != n) {
+	       mexErrMsgIdAndTxt("eigen2mat:invalid_argument",
+				 "accumarray(): %d subscripts but %d values",
+				 static_cast<int>(n),
+				 static_cast<int>(vals.size()));
+	  }
+
+	  // first invalid subscript of each chunk (checked in parallel, the
+	  // error being raised from the calling thread)
+	  const auto n_chunks = e2m::internal::num_chunks(n, accum_chunk_size);
+	  std::vector<par_index_t> bad(n_chunks, n);
+	  e2m::internal::parallel_for(
+	       0, n_chunks,
+	       [&](par_index_t c) {
+		    par_index_t begin(0), end(0);
+		    e2m::internal::chunk_range(n, n_chunks, c, begin, end);
+		    for (auto k(begin) ; k < end ; ++k) {
+			 if (!subs.valid(k)) {
+			      bad[c] = k;
+			      break;
+			 }
+		    }
+	       });
+	  for (par_index_t c(0) ; c < n_chunks ; ++c) {
+	       if (bad[c] != n) {
+		    mexErrMsgIdAndTxt("eigen2mat:invalid_argument",
+				      "accumarray(): subscript %d is out of range",
+				      static_cast<int>(bad[c]));
+	       }
+	  }
+     }
+
+     // =========================================================================
+
+     /*
+      * Result of the accumulation: either a full histogram (bins() empty)
+      * or the list of the non-empty bins, sorted.
+      */
+     struct accum_result_t
+     {
+	  accum_result_t() : bins(), values(), counts(), dense(false) {}
+
+	  std::vector<e2m::size_t> bins;
+	  std::vector<double> values;
+	  std::vector<e2m::size_t> counts;
+	  bool dense;
+     };
+
+     /*
+      * Privatised histograms: each chunk of values is accumulated into its
+      * own histogram, the histograms are then merged in parallel over the
+      * bins (in chunk order).
+      */
+     template <typename reducer_t, typename subs_t>
+     void accumulate_histograms(const subs_t& subs,
+				const e2m::real_vector_t& vals,
+				accum_result_t& r)
+     {
+	  const par_index_t n = subs.size();
+	  const par_index_t B = subs.n_bins();
+	  const auto n_chunks = e2m::internal::num_chunks(n, accum_chunk_size);
+	  const bool use_vals = vals.size() != 0;
+
+	  std::vector<double> v(n_chunks * B, 0.);
+	  std::vector<e2m::size_t> cnt(n_chunks * B, 0);
+	  e2m::internal::parallel_for(
+	       0, n_chunks,
+	       [&](par_index_t c) {
+		    par_index_t begin(0), end(0);
+		    e2m::internal::chunk_range(n, n_chunks, c, begin, end);
+		    auto* hv = v.data() + c * B;
+		    auto* hn = cnt.data() + c * B;
+		    for (auto k(begin) ; k < end ; ++k) {
+			 const auto b = subs.bin(k);
+			 add_value<reducer_t>(hv[b], hn[b], use_vals ? vals[k] : 0.);
+		    }
+	       });
+	  if (n_chunks > 1) {
+	       e2m::internal::parallel_for(
+		    0, B,
+		    [&](par_index_t b) {
+			 for (par_index_t c(1) ; c < n_chunks ; ++c) {
+			      merge_bin<reducer_t>(v[b], cnt[b],
+						   v[c * B + b], cnt[c * B + b]);
+			 }
+		    }, 4096);
+	       v.resize(B);
+	       cnt.resize(B);
+	  }
+	  r.values.swap(v);
+	  r.counts.swap(cnt);
+	  r.dense = true;
+     }
+
+     /*
+      * Sort-based reduction: each chunk of values is sorted by bin and
+      * reduced into a sorted list of bins; the lists are then merged two by
+      * two (in parallel), the left list always coming first.
+      */
+     template <typename reducer_t, typename subs_t>
+     void accumulate_sorted(const subs_t& subs,
+			    const e2m::real_vector_t& vals,
+			    accum_result_t& r)
+     {
+	  const par_index_t n = subs.size();
+	  const auto n_chunks = e2m::internal::num_chunks(n, accum_chunk_size);
+	  const bool use_vals = vals.size() != 0;
+
+	  std::vector<accum_result_t> lists(n_chunks);
+	  e2m::internal::parallel_for(
+	       0, n_chunks,
+	       [&](par_index_t c) {
+		    par_index_t begin(0), end(0);
+		    e2m::internal::chunk_range(n, n_chunks, c, begin, end);
+		    std::vector<std::pair<e2m::size_t, par_index_t>> order(end - begin);
+		    for (auto k(begin) ; k < end ; ++k) {
+			 order[k - begin] = std::make_pair(subs.bin(k), k);
+		    }
+		    // sorting by (bin, position) keeps the order of the values
+		    std::sort(order.begin(), order.end());
+
+		    auto& l = lists[c];
+		    for (e2m::size_t i(0) ; i < order.size() ; ++i) {
+			 const auto b = order[i].first;
+			 const auto x = use_vals ? vals[order[i].second] : 0.;
+			 if (l.bins.empty() || l.bins.back() != b) {
+			      l.bins.push_back(b);
+			      l.values.push_back(0.);
+			      l.counts.push_back(0);
+			 }
+			 add_value<reducer_t>(l.values.back(), l.counts.back(), x);
+		    }
+	       });
+
+	  for (par_index_t step(1) ; step < n_chunks ; step *= 2) {
+	       e2m::internal::parallel_for(
+		    0, (n_chunks + 2 * step - 1) / (2 * step),
+		    [&](par_index_t p) {
+			 const auto i = 2 * step * p;
+			 const auto j = i + step;
+			 if (j >= n_chunks) {
+			      return;
+			 }
+			 const auto& a = lists[i];
+			 const auto& b = lists[j];
+			 accum_result_t m;
+			 m.bins.reserve(a.bins.size() + b.bins.size());
+			 m.values.reserve(a.bins.size() + b.bins.size());
+			 m.counts.reserve(a.bins.size() + b.bins.size());
+			 e2m::size_t ia(0), ib(0);
+			 while (ia < a.bins.size() || ib < b.bins.size()) {
+			      if (ib == b.bins.size()
+				  || (ia < a.bins.size() && a.bins[ia] < b.bins[ib])) {
+				   m.bins.push_back(a.bins[ia]);
+				   m.values.push_back(a.values[ia]);
+				   m.counts.push_back(a.counts[ia++]);
+			      }
+			      else if (ia == a.bins.size() || b.bins[ib] < a.bins[ia]) {
+				   m.bins.push_back(b.bins[ib]);
+				   m.values.push_back(b.values[ib]);
+				   m.counts.push_back(b.counts[ib++]);
+			      }
+			      else {
+				   auto v = a.values[ia];
+				   auto c = a.counts[ia];
+				   merge_bin<reducer_t>(v, c, b.values[ib], b.counts[ib]);
+				   m.bins.push_back(a.bins[ia]);
+				   m.values.push_back(v);
+				   m.counts.push_back(c);
+				   ++ia;
+				   ++ib;
+			      }
+			 }
+			 lists[i] = std::move(m);
+			 lists[j] = accum_result_t();
+		    });
+	  }
+	  r = std::move(lists[0]);
+	  r.dense = false;
+     }
+
+     /*
+      * Privatised histograms are used when they are cheap to allocate and
+      * merge compared to the number of values (or when running on a single
+      * thread with a dense result, where there is nothing to merge).
+      */
+     template <typename reducer_t, typename subs_t>
+     void accumulate(const subs_t& subs,
+		     const e2m::real_vector_t& vals,
+		     bool dense_output,
+		     accum_result_t& r)
+     {
+	  const par_index_t n = subs.size();
+	  const par_index_t B = subs.n_bins();
+	  const auto n_chunks = e2m::internal::num_chunks(n, accum_chunk_size);
+	  if ((dense_output && n_chunks == 1) || n_chunks * B <= 2 * n) {
+	       accumulate_histograms<reducer_t>(subs, vals, r);
+	  }
+	  else {
+	       accumulate_sorted<reducer_t>(subs, vals, r);
+	  }
+     }
+
+     // =========================================================================
+
+     //! Write the final values of all the bins (empty ones are 0)
+     template <typename reducer_t>
+     void write_dense(const accum_result_t& r, e2m::size_t n_bins, double* out)
+     {
+	  if (r.dense) {
+	       e2m::internal::parallel_for(
+		    0, n_bins,
+		    [&](par_index_t b) {
+			 out[b] = final_value<reducer_t>(r.values[b], r.counts[b]);
+		    }, 65536);
+	  }
+	  else {
+	       std::fill(out, out + n_bins, 0.);
+	       e2m::internal::parallel_for(
+		    0, r.bins.size(),
+		    [&](par_index_t k) {
+			 out[r.bins[k]] = final_value<reducer_t>(r.values[k],
+								 r.counts[k]);
+		    }, 65536);
+	  }
+     }
+
+     /*
+      * Write the non-zero bins into compressed column storage (bins are
+      * column-major linear indices into a M x N matrix). The non-zeros of
+      * each column are counted first, then \c alloc(counts) allocates the
+      * result once and returns its arrays (column pointers already set),
+      * which are filled in place. Both passes run in parallel over the
+      * columns.
+      */
+     template <typename reducer_t, typename index_t, typename alloc_t>
+     void write_sparse(const accum_result_t& r,
+		       e2m::size_t M, e2m::size_t N,
+		       alloc_t alloc)
+     {
+	  // range of the elements of r that belong to column j
+	  const auto column = [&](par_index_t j,
+				  e2m::size_t& begin, e2m::size_t& end) {
+	       if (r.dense) {
+		    begin = j * M;
+		    end = begin + M;
+	       }
+	       else {
+		    const auto first = r.bins.begin();
+		    begin = std::lower_bound(first, r.bins.end(), j * M) - first;
+		    end = std::lower_bound(first + begin, r.bins.end(),
+					   (j + 1) * M) - first;
+	       }
+	  };
+
+	  GCC_IGNORE_WARNINGS_ONE(-Wfloat-equal)
+	  CLANG_IGNORE_WARNINGS_ONE(-Wfloat-equal)
+	  std::vector<index_t> counts(N);
+	  e2m::internal::parallel_for_dynamic(
+	       0, N,
+	       [&](par_index_t j) {
+		    e2m::size_t begin(0), end(0);
+		    column(j, begin, end);
+		    index_t n(0);
+		    for (auto k(begin) ; k < end ; ++k) {
+			 n += final_value<reducer_t>(r.values[k], r.counts[k]) != 0.;
+		    }
+		    counts[j] = n;
+	       }, 256);
+
+	  double* pr(nullptr);
+	  index_t* ir(nullptr);
+	  const index_t* jc(nullptr);
+	  alloc(counts, pr, ir, jc);
+	  e2m::internal::parallel_for_dynamic(
+	       0, N,
+	       [&](par_index_t j) {
+		    e2m::size_t begin(0), end(0);
+		    column(j, begin, end);
+		    auto p = jc[j];
+		    for (auto k(begin) ; k < end ; ++k) {
+			 const auto v = final_value<reducer_t>(r.values[k],
+							       r.counts[k]);
+			 if (v != 0.) {
+			      const auto bin = r.dense ? k : r.bins[k];
+			      ir[p] = static_cast<index_t>(bin - j * M);
+			      pr[p++] = v;
+			 }
+		    }
+	       }, 256);
+	  CLANG_RESTORE_WARNINGS
+	  GCC_RESTORE_WARNINGS
+     }
+
+     // =========================================================================
+
+     template <typename reducer_t, typename subs_t>
+     e2m::real_vector_t accumarray_helper(const subs_t& subs,
+					  const e2m::real_vector_t& vals)
+     {
+	  accum_result_t r;
+	  accumulate<reducer_t>(subs, vals, true, r);
+	  e2m::real_vector_t ret(subs.n_bins());
+	  write_dense<reducer_t>(r, subs.n_bins(), ret.data());
+	  return ret;
+     }
+
+     template <typename reducer_t, typename subs_t>
+     e2m::real_sp_matrix_t sp_accumarray_helper(const subs_t& subs,
+						const e2m::real_vector_t& vals,
+						e2m::size_t M, e2m::size_t N)
+     {
+	  accum_result_t r;
+	  accumulate<reducer_t>(subs, vals, false, r);
+	  e2m::real_sp_matrix_t ret(M, N);
+	  write_sparse<reducer_t, int>(
+	       r, M, N,
+	       [&](const std::vector<int>& counts,
+		   double*& pr, int*& ir, const int*& jc) {
+		    ret.resizeNonZeros(e2m::internal::parallel_exclusive_scan(
+					    N, counts.data(), ret.outerIndexPtr()));
+		    pr = ret.valuePtr();
+		    ir = ret.innerIndexPtr();
+		    jc = ret.outerIndexPtr();
+	       });
+	  return ret;
+     }
+
+     template <typename reducer_t, typename subs_t>
+     mxArray* accumarray_to_mxArray_helper(const subs_t& subs,
+					   const e2m::real_vector_t& vals,
+					   e2m::size_t M, e2m::size_t N,
+					   bool sparse)
+     {
+	  accum_result_t r;
+	  accumulate<reducer_t>(subs, vals, !sparse, r);
+	  mxArray* ret(nullptr);
+	  if (sparse) {
+	       write_sparse<reducer_t, mwIndex>(
+		    r, M, N,
+		    [&](const std::vector<mwIndex>& counts,
+			double*& pr, mwIndex*& ir, const mwIndex*& jc) {
+			 ret = e2m::internal::create_sparse_from_counts(
+			      M, N, counts.data(), false);
+			 pr = mxGetPr(ret);
+			 ir = mxGetIr(ret);
+			 jc = mxGetJc(ret);
+		    });
+	  }
+	  else {
+	       ret = mxCreateDoubleMatrix(M, N, mxREAL);
+	       e2m_assert(ret);
+	       write_dense<reducer_t>(r, M * N, mxGetPr(ret));
+	  }
+	  return ret;
+     }
+
+     // =========================================================================
+
+     template <typename subs_t>
+     e2m::real_vector_t accumarray_dispatch(const subs_t& subs,
+					    const e2m::real_vector_t& vals,
+					    e2m::ACCUM_OP_T op)
+     {
+	  check_subs(subs, vals, op);
+	  E2M_OP_SCOPE(ACCUMARRAY, subs.n_bins() * sizeof(double), 1);
+	  switch (op) {
+	  case e2m::ACCUM_MAX:
+	       return accumarray_helper<max_reducer_t>(subs, vals);
+	  case e2m::ACCUM_MIN:
+	       return accumarray_helper<min_reducer_t>(subs, vals);
+	  case e2m::ACCUM_COUNT:
+	       return accumarray_helper<count_reducer_t>(subs, vals);
+	  case e2m::ACCUM_MEAN:
+	       return accumarray_helper<mean_reducer_t>(subs, vals);
+	  case e2m::ACCUM_SUM:
+	  default:
+	       return accumarray_helper<sum_reducer_t>(subs, vals);
+	  }
+     }
+
+     template <typename subs_t>
+     e2m::real_sp_matrix_t sp_accumarray_dispatch(const subs_t& subs,
+						  const e2m::real_vector_t& vals,
+						  e2m::size_t M, e2m::size_t N,
+						  e2m::ACCUM_OP_T op)
+     {
+	  check_subs(subs, vals, op);
+	  E2M_OP_SCOPE(ACCUMARRAY, subs.size() * sizeof(double), 1);
+	  switch (op) {
+	  case e2m::ACCUM_MAX:
+	       return sp_accumarray_helper<max_reducer_t>(subs, vals, M, N);
+	  case e2m::ACCUM_MIN:
+	       return sp_accumarray_helper<min_reducer_t>(subs, vals, M, N);
+	  case e2m::ACCUM_COUNT:
+	       return sp_accumarray_helper<count_reducer_t>(subs, vals, M, N);
+	  case e2m::ACCUM_MEAN:
+	       return sp_accumarray_helper<mean_reducer_t>(subs, vals, M, N);
+	  case e2m::ACCUM_SUM:
+	  default:
+	       return sp_accumarray_helper<sum_reducer_t>(subs, vals, M, N);
+	  }
+     }
+
+     template <typename subs_t>
+     mxArray* accumarray_to_mxArray_dispatch(const subs_t& subs,
+					     const e2m::real_vector_t& vals,
+					     e2m::size_t M, e2m::size_t N,
+					     e2m::ACCUM_OP_T op,
+					     bool sparse)
+     {
+	  check_subs(subs, vals, op);
+	  E2M_OP_SCOPE(ACCUMARRAY,
+		       (sparse ? subs.size() : subs.n_bins()) * sizeof(double),
+		       1);
+	  switch (op) {
+	  case e2m::ACCUM_MAX:
+	       return accumarray_to_mxArray_helper<max_reducer_t>(subs, vals, M, N, sparse);
+	  case e2m::ACCUM_MIN:
+	       return accumarray_to_mxArray_helper<min_reducer_t>(subs, vals, M, N, sparse);
+	  case e2m::ACCUM_COUNT:
+	       return accumarray_to_mxArray_helper<count_reducer_t>(subs, vals, M, N, sparse);
+	  case e2m::ACCUM_MEAN:
+	       return accumarray_to_mxArray_helper<mean_reducer_t>(subs, vals, M, N, sparse);
+	  case e2m::ACCUM_SUM:
+	  default:
+	       return accumarray_to_mxArray_helper<sum_reducer_t>(subs, vals, M, N, sparse);
+	  }
+     }
+} // namespace
+
+// =============================================================================
+
+e2m::real_vector_t e2m::accumarray(const idx_array_t& subs,
+				   const real_vector_t& vals,
+				   size_t n,
+				   ACCUM_OP_T op)
+{
+     return accumarray_dispatch(subs_1d_t<idx_array_t>(subs, n), vals, op);
+}
+e2m::real_vector_t e2m::accumarray(const int_array_t& subs,
+				   const real_vector_t& vals,
+				   size_t n,
+				   ACCUM_OP_T op)
+{
+     return accumarray_dispatch(subs_1d_t<int_array_t>(subs, n), vals, op);
+}
+
+// =====================================
+
+e2m::real_sp_matrix_t e2m::sp_accumarray(const idx_array_t& rows,
+					 const idx_array_t& cols,
+					 const real_vector_t& vals,
+					 size_t M, size_t N,
+					 ACCUM_OP_T op)
+{
+     return sp_accumarray_dispatch(subs_2d_t<idx_array_t>(rows, cols, M, N),
+				   vals, M, N, op);
+}
+e2m::real_sp_matrix_t e2m::sp_accumarray(const int_array_t& rows,
+					 const int_array_t& cols,
+					 const real_vector_t& vals,
+					 size_t M, size_t N,
+					 ACCUM_OP_T op)
+{
+     return sp_accumarray_dispatch(subs_2d_t<int_array_t>(rows, cols, M, N),
+				   vals, M, N, op);
+}
+
+// =====================================
+
+mxArray* e2m::accumarray_to_mxArray(const idx_array_t& subs,
+				    const real_vector_t& vals,
+				    size_t n,
+				    ACCUM_OP_T op,
+				    bool sparse)
+{
+     return accumarray_to_mxArray_dispatch(subs_1d_t<idx_array_t>(subs, n),
+					   vals, n, 1, op, sparse);
+}
+mxArray* e2m::accumarray_to_mxArray(const int_array_t& subs,
+				    const real_vector_t& vals,
+				    size_t n,
+				    ACCUM_OP_T op,
+				    bool sparse)
+{
+     return accumarray_to_mxArray_dispatch(subs_1d_t<int_array_t>(subs, n),
+					   vals, n, 1, op, sparse);
+}
+
+mxArray* e2m::accumarray_to_mxArray(const idx_array_t& rows,
+				    const idx_array_t& cols,
+				    const real_vector_t& vals,
+				    size_t M, size_t N,
+				    ACCUM_OP_T op,
+				    bool sparse)
+{
+     return accumarray_to_mxArray_dispatch(subs_2d_t<idx_array_t>(rows, cols, M, N),
+					   vals, M, N, op, sparse);
+}
+mxArray* e2m::accumarray_to_mxArray(const int_array_t& rows,
+				    const int_array_t& cols,
+				    const real_vector_t& vals,
+				    size_t M, size_t N,
+				    ACCUM_OP_T op,
+				    bool sparse)
+{
+     return accumarray_to_mxArray_dispatch(subs_2d_t<int_array_t>(rows, cols, M, N),
+					   vals, M, N, op, sparse);
+}
+
+CLANG_RESTORE_WARNINGS
+MSVC_RESTORE_WARNINGS
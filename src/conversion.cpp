@@ -21,6 +21,9 @@ GCC_IGNORE_WARNINGS_ONE(-Wconversion)
 // =============================================================================
 
 #include "eigen2mat/conversion.hpp"
+#include "eigen2mat/details/mxarray_helpers.hpp"
+#include "eigen2mat/details/op_scope.hpp"
+#include "eigen2mat/utils/parallel.hpp"
 
 #include <algorithm>
 #include <type_traits> 
@@ -29,137 +32,207 @@ namespace e2m = eigen2mat;
 
 // =============================================================================
 
-template <typename T>
-T mxArray_to_single_helper(const mxArray* a)
-{
-     const auto M = mxGetM(a);
-     const auto N = mxGetN(a);
+using e2m::internal::mxArray_to_single_helper;
+using e2m::internal::copy_from_mxArray_helper;
+using e2m::internal::csc_to_eigen;
+using e2m::internal::eigen_to_csc;
 
-     if (M != 1 || N != 1) {
-	  mexErrMsgTxt("Input is not a scalar");
-     }
-     else if (M == 0 || N == 0) {
-	  mexErrMsgTxt("Input is empty!");
-     }
+// =============================================================================
 
-     mxClassID id = mxGetClassID(a);
-     T r(0);
-     if (id == mxSINGLE_CLASS) {
-	  r = *reinterpret_cast<float*>(mxGetPr(a));
-     }
-     else if (id == mxDOUBLE_CLASS) {
-	  r = *mxGetPr(a);
-     }
-     else if (id == mxLOGICAL_CLASS) { 
-	  r = *reinterpret_cast<mxLogical*>(mxGetPr(a));
-     }
-     else if (id == mxINT8_CLASS) { 
-	  r = *reinterpret_cast<char*>(mxGetPr(a));
-     }
-     else if (id == mxINT16_CLASS) {
-	  r = *reinterpret_cast<short*>(mxGetPr(a));
-     }
-     else if (id == mxINT32_CLASS) {
-	  r = *reinterpret_cast<int*>(mxGetPr(a));
-     } 
-     else if (id == mxINT64_CLASS) {
-	  r = *reinterpret_cast<long long*>(mxGetPr(a));
-     }
-     else if (id == mxUINT8_CLASS) { 
-	  r = *reinterpret_cast<unsigned char*>(mxGetPr(a));
-     }
-     else if (id == mxUINT16_CLASS) {
-	  r = *reinterpret_cast<unsigned short*>(mxGetPr(a));
+namespace {
+     //! Raw pointers to the CSC arrays of a MATLAB sparse matrix
+     struct csc_arrays_t
+     {
+	  mwSize M;
+	  mwSize N;
+	  double* pr;
+	  double* pi;
+	  mwIndex* ir;
+	  mwIndex* jc;
+     };
+
+     csc_arrays_t get_csc_arrays(const mxArray* m)
+     {
+	  csc_arrays_t ret = {mxGetM(m), mxGetN(m),
+			      mxGetPr(m), mxGetPi(m),
+			      mxGetIr(m), mxGetJc(m)};
+	  e2m_assert(ret.pr);
+	  e2m_assert(ret.ir);
+	  e2m_assert(ret.jc);
+	  return ret;
      }
-     else if (id == mxUINT32_CLASS) {
-	  r = *reinterpret_cast<unsigned int*>(mxGetPr(a));
-     } 
-     else if (id == mxUINT64_CLASS) {
-	  r = *reinterpret_cast<unsigned long long*>(mxGetPr(a));
+
+     void check_real_sp_matrix(const mxArray* m)
+     {
+#ifdef EIGEN2MAT_TYPE_CHECK
+	  if (mxIsComplex(m)) {
+	       mexWarnMsgTxt("mxArray_to_real_sp_matrix(): argument is complex!");
+	  }
+	  if (!mxIsSparse(m)) {
+	       mexErrMsgTxt("mxArray_to_real_sp_matrix(): argument is not sparse!");
+	  }
+	  const auto id = mxGetClassID(m);
+	  if (id != mxDOUBLE_CLASS) {
+	       mexWarnMsgTxt("mxArray_to_real_matrix(): data type of v is not double!");
+	  }
+#else
+	  (void) m;
+#endif /* EIGEN2MAT_TYPE_CHECK */
      }
-     else {
-	  mexErrMsgTxt("mxArray_to_single_helper(): argument is not numeric!");
+
+     void check_cmplx_sp_matrix(const mxArray* m)
+     {
+#ifdef EIGEN2MAT_TYPE_CHECK
+	  if (!mxIsComplex(m)) {
+	       mexWarnMsgTxt("mxArray_to_cmplx_sp_matrix(): argument is real!");
+	  }
+	  if (!mxIsSparse(m)) {
+	       mexErrMsgTxt("mxArray_to_cmplx_sp_matrix(): argument is not sparse!");
+	  }
+	  const auto id = mxGetClassID(m);
+	  if (id != mxDOUBLE_CLASS) {
+	       mexWarnMsgTxt("mxArray_to_cmplx_sp_matrix(): data type of m is not double!");
+	  }
+#else
+	  (void) m;
+#endif /* EIGEN2MAT_TYPE_CHECK */
      }
 
-     return r;
-}
+     /*
+      * Import of a MATLAB sparse matrix as a row-major Eigen matrix: the
+      * CSC arrays are transposed straight into the CSR arrays of the result.
+      */
+     template <typename sp_rm_matrix_t>
+     sp_rm_matrix_t csc_to_eigen_rm(const csc_arrays_t& a)
+     {
+	  typedef typename sp_rm_matrix_t::Scalar Scalar;
+	  const auto nnz = a.jc[a.N];
+	  sp_rm_matrix_t ret(a.M, a.N);
+	  ret.resizeNonZeros(nnz);
+
+	  Scalar* values = ret.valuePtr();
+	  const double* pr = a.pr;
+	  const double* pi = a.pi;
+	  e2m::internal::transpose_compressed(
+	       a.N, a.M, a.jc, static_cast<const mwIndex*>(nullptr), a.ir,
+	       ret.outerIndexPtr(), ret.innerIndexPtr(),
+	       [&](mwIndex k, int p) {
+		    e2m::internal::copy_values(pr + k,
+					       pi == nullptr ? nullptr : pi + k,
+					       1, values + p);
+	       });
+	  return ret;
+     }
 
+     /*
+      * Export of a row-major Eigen matrix (compressed or not) to a MATLAB
+      * sparse matrix: the CSR arrays are transposed straight into the CSC
+      * arrays of the result.
+      */
+     template <typename sp_rm_matrix_t>
+     mxArray* eigen_rm_to_mxArray(const sp_rm_matrix_t& m, mxComplexity complexity)
+     {
+	  auto* ret = mxCreateSparse(m.rows(), m.cols(), m.nonZeros(), complexity);
+	  e2m_assert(ret);
+	  const auto a = get_csc_arrays(ret);
+
+	  const auto* values = m.valuePtr();
+	  e2m::internal::transpose_compressed(
+	       m.outerSize(), m.innerSize(),
+	       m.outerIndexPtr(), m.innerNonZeroPtr(), m.innerIndexPtr(),
+	       a.jc, a.ir,
+	       [&](int k, mwIndex p) {
+		    e2m::internal::split_values(values + k, 1,
+						a.pr + p,
+						a.pi == nullptr ? nullptr : a.pi + p);
+	       });
+	  return ret;
+     }
 
-// Copy SIZE elements from a to dest
-template <typename pointer_t>
-void copy_from_mxArray_helper(const mxArray* a, 
-			      eigen2mat::size_t SIZE, 
-			      pointer_t dest)
-{
-     mxClassID id = mxGetClassID(a);
-     if (id == mxSINGLE_CLASS) {
-	  float* data = reinterpret_cast<float*>(mxGetPr(a));
-	  std::copy(data, data + SIZE, dest);
-     }
-     else if ( id == mxDOUBLE_CLASS) {
-	  double* data = mxGetPr(a);
-	  std::copy(data, data + SIZE, dest);
-     }
-     else if (id == mxINT8_CLASS) {
-	  char* data = reinterpret_cast<char*>(mxGetPr(a));
-	  std::copy(data, data + SIZE, dest);
-     }
-     else if (id == mxINT16_CLASS) {
-	  short* data = reinterpret_cast<short*>(mxGetPr(a));
-	  std::copy(data, data + SIZE, dest);
-     }
-     else if (id == mxINT32_CLASS) {
-	  int* data = reinterpret_cast<int*>(mxGetPr(a));
-	  std::copy(data, data + SIZE, dest);
-     }
-     else if (id == mxINT64_CLASS) {
-	  long long* data = reinterpret_cast<long long*>(mxGetPr(a));
-	  std::copy(data, data + SIZE, dest);
-     }
-     else if (id == mxUINT8_CLASS) {
-	  unsigned char* data = 
-	       reinterpret_cast<unsigned char*>(mxGetPr(a));
-	  std::copy(data, data + SIZE, dest);
-     }
-     else if (id == mxUINT16_CLASS) {
-	  unsigned short* data = 
-	       reinterpret_cast<unsigned short*>(mxGetPr(a));
-	  std::copy(data, data + SIZE, dest);
-     }
-     else if (id == mxUINT32_CLASS) {
-	  unsigned int* data = reinterpret_cast<unsigned int*>(mxGetPr(a));
-	  std::copy(data, data + SIZE, dest);
-     }
-     else if (id == mxUINT64_CLASS) {
-	  unsigned long long* data = 
-	       reinterpret_cast<unsigned long long*>(mxGetPr(a));
-	  std::copy(data, data + SIZE, dest);
+     /*
+      * Conversion of a cell array of sparse matrices in two phases:
+      *   1. check the type of each element and get their CSC arrays
+      *      (calls to the MEX API, which is not thread-safe)
+      *   2. copy the CSC arrays into the Eigen matrices in parallel
+      */
+     template <typename cell_array_t>
+     cell_array_t mxArray_to_sp_cell_helper(const mxArray* c,
+					    void (*check)(const mxArray*))
+     {
+	  const auto numel = mxGetNumberOfElements(c);
+
+	  std::vector<csc_arrays_t> src(numel);
+	  unsigned long long bytes(0);
+	  for (auto i(0UL) ; i < numel ; ++i) {
+	       const auto* const data = mxGetCell(c, i);
+	       e2m_assert(data);
+	       check(data);
+	       src[i] = get_csc_arrays(data);
+	       bytes += src[i].jc[src[i].N]
+		    * (sizeof(typename cell_array_t::value_type::Scalar) + sizeof(int))
+		    + (src[i].N + 1) * sizeof(int);
+	  }
+	  E2M_OP_SCOPE(MXARRAY_TO_SP_CELL, bytes, numel + 1);
+
+	  cell_array_t ret(numel);
+	  e2m::internal::parallel_for_dynamic(
+	       0, numel,
+	       [&](e2m::internal::par_index_t i) {
+		    const auto& a = src[i];
+		    csc_to_eigen(a.M, a.N, a.pr, a.pi, a.ir, a.jc, ret[i]);
+	       });
+	  return ret;
      }
-     else {
-	  mexErrMsgTxt("copy_from_mxArray_helper(): argument is not numeric!");
-     }     
-}
 
-template <typename cell_array_t>
-mxArray* to_1Dcell_array_helper(const cell_array_t& t)
-{
-     const mwSize dims[1] = {t.size()};
-     
-     auto ret = mxCreateCellArray(1, dims);
-     e2m_assert(ret);
+     /*
+      * Export of a cell array of sparse matrices in two phases:
+      *   1. create all the mxArrays with their final size (calls to the MEX
+      *      API, which is not thread-safe)
+      *   2. fill their CSC arrays in parallel
+      */
+     template <typename cell_array_t>
+     mxArray* to_sp_cell_helper(const cell_array_t& t, mxComplexity complexity)
+     {
+	  const mwSize dims[1] = {t.size()};
+
+	  unsigned long long bytes(0);
+	  for (auto i(0UL) ; i < dims[0] ; ++i) {
+	       bytes += t[i].nonZeros()
+		    * (sizeof(typename cell_array_t::value_type::Scalar)
+		       + sizeof(mwIndex))
+		    + (t[i].cols() + 1) * sizeof(mwIndex);
+	  }
+	  E2M_OP_SCOPE(TO_MXARRAY_SP_CELL, bytes, dims[0] + 1);
+
+	  auto ret = mxCreateCellArray(1, dims);
+	  e2m_assert(ret);
+
+	  std::vector<csc_arrays_t> dest(dims[0]);
+	  for (auto i(0UL) ; i < dims[0] ; ++i) {
+	       e2m_assert(t[i].cols() == t[i].outerSize());
+	       auto* m = mxCreateSparse(t[i].rows(), t[i].cols(),
+					t[i].nonZeros(), complexity);
+	       e2m_assert(m);
+	       dest[i] = get_csc_arrays(m);
+	       mxSetCell(ret, i, m);
+	  }
 
-     for (auto i(0UL) ; i < dims[0] ; ++i) {
-	  // mxSetCell(mxArray *pm, mwIndex index, mxArray *value);
-	  mxSetCell(ret, i, eigen2mat::to_mxArray(t[i]));
+	  e2m::internal::parallel_for_dynamic(
+	       0, dims[0],
+	       [&](e2m::internal::par_index_t i) {
+		    const auto& a = dest[i];
+		    eigen_to_csc(t[i], a.pr, a.pi, a.ir, a.jc);
+	       });
+	  return ret;
      }
-     return ret;
-}
+} // namespace
 
 // =============================================================================
 
 bool eigen2mat::mxArray_to_bool(const mxArray* b)
 {
      e2m_assert(b);
+     E2M_OP_SCOPE(MXARRAY_TO_SCALAR, sizeof(bool), 0);
 #ifdef EIGEN2MAT_TYPE_CHECK
      if (mxIsComplex(b)) {
 	  mexWarnMsgTxt("mxArray_to_bool(): argument is complex!");
@@ -180,6 +253,7 @@ bool eigen2mat::mxArray_to_bool(const mxArray* b)
 double eigen2mat::mxArray_to_double(const mxArray* d)
 {
      e2m_assert(d);
+     E2M_OP_SCOPE(MXARRAY_TO_SCALAR, sizeof(double), 0);
 #ifdef EIGEN2MAT_TYPE_CHECK
      if (mxIsComplex(d)) {
 	  mexWarnMsgTxt("mxArray_to_double(): argument is complex!");
@@ -200,6 +274,7 @@ double eigen2mat::mxArray_to_double(const mxArray* d)
 size_t eigen2mat::mxArray_to_idx(const mxArray* d)
 {
      e2m_assert(d);
+     E2M_OP_SCOPE(MXARRAY_TO_SCALAR, sizeof(size_t), 0);
 #ifdef EIGEN2MAT_TYPE_CHECK     
      const auto M = mxGetM(d);
      const auto N = mxGetN(d);
@@ -231,6 +306,7 @@ size_t eigen2mat::mxArray_to_idx(const mxArray* d)
 int eigen2mat::mxArray_to_int(const mxArray* d)
 {
      e2m_assert(d);
+     E2M_OP_SCOPE(MXARRAY_TO_SCALAR, sizeof(int), 0);
 #ifdef EIGEN2MAT_TYPE_CHECK     
      const auto M = mxGetM(d);
      const auto N = mxGetN(d);
@@ -261,6 +337,7 @@ int eigen2mat::mxArray_to_int(const mxArray* d)
 
 eigen2mat::dcomplex eigen2mat::mxArray_to_cmplx(const mxArray* d)
 {
+     E2M_OP_SCOPE(MXARRAY_TO_SCALAR, sizeof(dcomplex), 0);
 #ifdef EIGEN2MAT_TYPE_CHECK
      if (!mxIsComplex(d)) {
 	  mexWarnMsgTxt("mxArray_to_cmplx(): argument is real!");
@@ -281,6 +358,7 @@ eigen2mat::idx_array_t eigen2mat::mxArray_to_idx_array(const mxArray* v)
      e2m_assert(v);
      const auto M = mxGetM(v);
      const auto N = mxGetN(v);
+     E2M_OP_SCOPE(MXARRAY_TO_INT_ARRAY, (M == 1 ? N : M) * sizeof(size_t), 1);
 
 #ifdef EIGEN2MAT_TYPE_CHECK
      if (mxIsComplex(v)) {
@@ -326,6 +404,7 @@ eigen2mat::int_array_t eigen2mat::mxArray_to_int_array(const mxArray* v)
      e2m_assert(v);
      const auto M = mxGetM(v);
      const auto N = mxGetN(v);
+     E2M_OP_SCOPE(MXARRAY_TO_INT_ARRAY, (M == 1 ? N : M) * sizeof(int), 1);
 
 #ifdef EIGEN2MAT_TYPE_CHECK
      if (mxIsComplex(v)) {
@@ -370,6 +449,7 @@ eigen2mat::int_array_t eigen2mat::mxArray_to_int_array(const mxArray* v)
 eigen2mat::real_vector_t eigen2mat::mxArray_to_real_vector(const mxArray* v)
 {
      e2m_assert(v);
+     E2M_OP_SCOPE(MXARRAY_TO_REAL_DENSE, mxGetNumberOfElements(v) * sizeof(double), 1);
 #ifdef EIGEN2MAT_TYPE_CHECK
      if (mxIsComplex(v)) {
 	  mexWarnMsgTxt("mxArray_to_real_vector(): argument is complex!");
@@ -393,6 +473,7 @@ eigen2mat::real_vector_t eigen2mat::mxArray_to_real_vector(const mxArray* v)
 eigen2mat::real_row_vector_t eigen2mat::mxArray_to_real_row_vector(const mxArray* v)
 {
      e2m_assert(v);
+     E2M_OP_SCOPE(MXARRAY_TO_REAL_DENSE, mxGetNumberOfElements(v) * sizeof(double), 1);
 #ifdef EIGEN2MAT_TYPE_CHECK
      if (mxIsComplex(v)) {
 	  mexWarnMsgTxt("mxArray_to_real_row_vector(): argument is complex!");
@@ -422,45 +503,31 @@ eigen2mat::real_matrix_t eigen2mat::mxArray_to_real_matrix(const mxArray* m)
 eigen2mat::real_sp_matrix_t eigen2mat::mxArray_to_real_sp_matrix(const mxArray* m)
 {
      e2m_assert(m);
-     const auto M = mxGetM(m);
-     const auto N = mxGetN(m);
-#ifdef EIGEN2MAT_TYPE_CHECK
-     if (mxIsComplex(m)) {
-	  mexWarnMsgTxt("mxArray_to_real_sp_matrix(): argument is complex!");
-     }
-     if (!mxIsSparse(m)) {
-	  mexErrMsgTxt("mxArray_to_real_sp_matrix(): argument is not sparse!");
-     }
-     const auto id = mxGetClassID(m);
-     if (id != mxDOUBLE_CLASS) {
-	  mexWarnMsgTxt("mxArray_to_real_matrix(): data type of v is not double!");
-     }
-#endif /* EIGEN2MAT_TYPE_CHECK */
-     auto* values = mxGetPr(m);
-     auto* ic = mxGetIr(m);
-     auto* jc = mxGetJc(m);
-     e2m_assert(values);
-     e2m_assert(ic);
-     e2m_assert(jc);
-
-     const auto nzmax = mxGetNzmax(m);
-
-     // not optimal insertion method, but should do for now...
-     typedef Eigen::Triplet<double> t_t;
-     std::vector<t_t> triplet_list;
-     triplet_list.reserve(nzmax);
-     for (auto col(0UL) ; col < N ; ++col) {
-	  for (auto l(jc[col]) ; l < jc[col+1] ; ++l) {
-	       triplet_list.push_back(t_t(ic[l],col,values[l]));
-	  }
-     }
-
-     real_sp_matrix_t ret(M, N);
-     ret.setFromTriplets(triplet_list.begin(), triplet_list.end());
-     ret.makeCompressed();
+     check_real_sp_matrix(m);
+     const auto a = get_csc_arrays(m);
+     E2M_OP_SCOPE(MXARRAY_TO_REAL_SPARSE,
+		  a.jc[a.N] * (sizeof(double) + sizeof(int)) + (a.N + 1) * sizeof(int),
+		  1);
+
+     real_sp_matrix_t ret;
+     csc_to_eigen(a.M, a.N, a.pr, nullptr, a.ir, a.jc, ret);
      return ret;
 }
 
+// =====================================
+
+eigen2mat::real_sp_rm_matrix_t eigen2mat::mxArray_to_real_sp_rm_matrix(const mxArray* m)
+{
+     e2m_assert(m);
+     check_real_sp_matrix(m);
+     const auto a = get_csc_arrays(m);
+     E2M_OP_SCOPE(MXARRAY_TO_REAL_SPARSE,
+		  a.jc[a.N] * (sizeof(double) + sizeof(int)) + (a.M + 1) * sizeof(int),
+		  1);
+
+     return csc_to_eigen_rm<real_sp_rm_matrix_t>(a);
+}
+
 
 // =====================================
 
@@ -468,6 +535,7 @@ eigen2mat::real_tensor_t eigen2mat::mxArray_to_real_tensor(const mxArray* t)
 {
      e2m_assert(t);
      const auto dims = eigen2mat::get_dimensions(t);
+     E2M_OP_SCOPE(MXARRAY_TO_REAL_TENSOR, dims[0] * dims[1] * dims[2] * sizeof(double), dims[2]);
 
 #ifdef EIGEN2MAT_TYPE_CHECK
      if (dims[2] == 0) {
@@ -511,15 +579,7 @@ eigen2mat::real_sp_cell_t eigen2mat::mxArray_to_real_sp_cell(const mxArray* c)
      }
 #endif /* EIGEN2MAT_TYPE_CHECK */
 
-     const auto numel = mxGetNumberOfElements(c);
-     real_sp_cell_t ret(numel);
-
-     for (auto i(0UL) ; i < numel ; ++i) {
-	  const auto* const data = mxGetCell(c, i);
-	  e2m_assert(data);
-	  ret[i] = mxArray_to_real_sp_matrix(data);
-     }
-     return ret;
+     return mxArray_to_sp_cell_helper<real_sp_cell_t>(c, check_real_sp_matrix);
 }
 
 // =============================================================================
@@ -528,6 +588,7 @@ eigen2mat::real_sp_cell_t eigen2mat::mxArray_to_real_sp_cell(const mxArray* c)
 eigen2mat::cmplx_vector_t eigen2mat::mxArray_to_cmplx_vector(const mxArray* v)
 {
      e2m_assert(v);
+     E2M_OP_SCOPE(MXARRAY_TO_CMPLX_DENSE, mxGetNumberOfElements(v) * sizeof(dcomplex), 1);
 #ifdef EIGEN2MAT_TYPE_CHECK
      if (mxGetN(v) != 1) {
 	  mexErrMsgTxt("mxArray_to_real_vector(): argument is not a column vector!");
@@ -559,6 +620,7 @@ eigen2mat::cmplx_vector_t eigen2mat::mxArray_to_cmplx_vector(const mxArray* v)
 eigen2mat::cmplx_row_vector_t eigen2mat::mxArray_to_cmplx_row_vector(const mxArray* v)
 {
      e2m_assert(v);
+     E2M_OP_SCOPE(MXARRAY_TO_CMPLX_DENSE, mxGetNumberOfElements(v) * sizeof(dcomplex), 1);
 #ifdef EIGEN2MAT_TYPE_CHECK
      if (mxGetM(v) != 1) {
 	  mexErrMsgTxt("mxArray_to_real_row_vector(): argument is not a row vector!");
@@ -596,62 +658,38 @@ eigen2mat::cmplx_matrix_t eigen2mat::mxArray_to_cmplx_matrix(const mxArray* m)
 eigen2mat::cmplx_sp_matrix_t eigen2mat::mxArray_to_cmplx_sp_matrix(const mxArray* m)
 {
      e2m_assert(m);
-#ifdef EIGEN2MAT_TYPE_CHECK
-     if (!mxIsComplex(m)) {
-	  mexWarnMsgTxt("mxArray_to_cmplx_sp_matrix(): argument is real!");
-     }
-     if (!mxIsSparse(m)) {
-	  mexErrMsgTxt("mxArray_to_cmplx_sp_matrix(): argument is not sparse!");
-     }
-     const auto id = mxGetClassID(m);
-     if (id != mxDOUBLE_CLASS) {
-	  mexWarnMsgTxt("mxArray_to_cmplx_sp_matrix(): data type of m is not double!");
-     }
-#endif /* EIGEN2MAT_TYPE_CHECK */
-     auto* real = mxGetPr(m);
-     auto* imag = mxGetPi(m);
-     auto* ic = mxGetIr(m);
-     auto* jc = mxGetJc(m);
-
-     const auto M = mxGetM(m);
-     const auto N = mxGetN(m);
-     const auto nzmax = mxGetNzmax(m);
-
-     // not optimal insertion method, but should do for now...
-     typedef Eigen::Triplet<dcomplex> t_t;
-     std::vector<t_t> triplet_list;
-     triplet_list.reserve(nzmax);
-     for (auto col(0UL) ; col < N ; ++col) {
-	  for (auto l(jc[col]) ; l < jc[col+1] ; ++l) {
-	       if (imag == nullptr) {
-		    triplet_list.push_back(t_t(ic[l],
-					       col,
-					       dcomplex(real[l],0.0)
-						)
-			 );
-	       }
-	       else {
-		    triplet_list.push_back(t_t(ic[l],
-					       col,
-					       dcomplex(real[l],imag[l])
-						)
-			 );
-	       }
-	  }
-     }
-
-     cmplx_sp_matrix_t ret(M, N);
-     ret.setFromTriplets(triplet_list.begin(), triplet_list.end());
-     ret.makeCompressed();
+     check_cmplx_sp_matrix(m);
+     const auto a = get_csc_arrays(m);
+     E2M_OP_SCOPE(MXARRAY_TO_CMPLX_SPARSE,
+		  a.jc[a.N] * (sizeof(dcomplex) + sizeof(int)) + (a.N + 1) * sizeof(int),
+		  1);
+
+     cmplx_sp_matrix_t ret;
+     csc_to_eigen(a.M, a.N, a.pr, a.pi, a.ir, a.jc, ret);
      return ret;
 }
 
 // =====================================
 
+eigen2mat::cmplx_sp_rm_matrix_t eigen2mat::mxArray_to_cmplx_sp_rm_matrix(const mxArray* m)
+{
+     e2m_assert(m);
+     check_cmplx_sp_matrix(m);
+     const auto a = get_csc_arrays(m);
+     E2M_OP_SCOPE(MXARRAY_TO_CMPLX_SPARSE,
+		  a.jc[a.N] * (sizeof(dcomplex) + sizeof(int)) + (a.M + 1) * sizeof(int),
+		  1);
+
+     return csc_to_eigen_rm<cmplx_sp_rm_matrix_t>(a);
+}
+
+// =====================================
+
 eigen2mat::cmplx_tensor_t eigen2mat::mxArray_to_cmplx_tensor(const mxArray* t)
 {
      e2m_assert(t);
      const auto dims = eigen2mat::get_dimensions(t);
+     E2M_OP_SCOPE(MXARRAY_TO_CMPLX_TENSOR, dims[0] * dims[1] * dims[2] * sizeof(dcomplex), dims[2]);
 #ifdef EIGEN2MAT_TYPE_CHECK
      const auto id = mxGetClassID(t);
      if (id != mxDOUBLE_CLASS) {
@@ -699,15 +737,7 @@ eigen2mat::cmplx_sp_cell_t eigen2mat::mxArray_to_cmplx_sp_cell(const mxArray* c)
      }
 #endif /* EIGEN2MAT_TYPE_CHECK */
 
-     const auto numel = mxGetNumberOfElements(c);
-     cmplx_sp_cell_t ret(numel);
-
-     for (auto i(0UL) ; i < numel ; ++i) {
-	  const mxArray* data = mxGetCell(c, i);
-	  e2m_assert(data);
-	  ret[i] = mxArray_to_cmplx_sp_matrix(data);
-     }
-     return ret;
+     return mxArray_to_sp_cell_helper<cmplx_sp_cell_t>(c, check_cmplx_sp_matrix);
 }
 
 // #############################################################################
@@ -715,6 +745,7 @@ eigen2mat::cmplx_sp_cell_t eigen2mat::mxArray_to_cmplx_sp_cell(const mxArray* c)
 
 mxArray* eigen2mat::to_mxArray(bool b)
 {
+     E2M_OP_SCOPE(TO_MXARRAY_SCALAR, sizeof(bool), 1);
      auto ret = mxCreateNumericMatrix(1, 1, mxLOGICAL_CLASS, mxREAL);
      e2m_assert(ret);
 
@@ -727,6 +758,7 @@ mxArray* eigen2mat::to_mxArray(bool b)
 
 mxArray* eigen2mat::to_mxArray(double d)
 {
+     E2M_OP_SCOPE(TO_MXARRAY_SCALAR, sizeof(double), 1);
      auto ret = mxCreateDoubleMatrix(1, 1, mxREAL);
      e2m_assert(ret);
 
@@ -738,6 +770,7 @@ mxArray* eigen2mat::to_mxArray(double d)
 
 mxArray* eigen2mat::to_mxArray(int i)
 {
+     E2M_OP_SCOPE(TO_MXARRAY_SCALAR, sizeof(int), 1);
      auto ret = mxCreateNumericMatrix(1, 1, mxINT32_CLASS, mxREAL);
      e2m_assert(ret);
 
@@ -750,6 +783,7 @@ mxArray* eigen2mat::to_mxArray(int i)
 
 mxArray* eigen2mat::to_mxArray(e2m::size_t idx)
 {
+     E2M_OP_SCOPE(TO_MXARRAY_SCALAR, sizeof(unsigned int), 1);
      auto ret = mxCreateNumericMatrix(1, 1, mxUINT32_CLASS, mxREAL);
      e2m_assert(ret);
 
@@ -762,6 +796,7 @@ mxArray* eigen2mat::to_mxArray(e2m::size_t idx)
 
 mxArray* eigen2mat::to_mxArray(const e2m::dcomplex& z)
 {
+     E2M_OP_SCOPE(TO_MXARRAY_SCALAR, sizeof(dcomplex), 1);
      auto ret = mxCreateDoubleMatrix(1, 1, mxCOMPLEX);
      e2m_assert(ret);
 
@@ -774,6 +809,7 @@ mxArray* eigen2mat::to_mxArray(const e2m::dcomplex& z)
 
 mxArray* eigen2mat::to_mxArray(const e2m::idx_array_t& v)
 {
+     E2M_OP_SCOPE(TO_MXARRAY_INT_ARRAY, v.size() * sizeof(unsigned int), 1);
      auto ret = mxCreateNumericMatrix(v.size(), 1, mxUINT32_CLASS, mxREAL);
      e2m_assert(ret);
 
@@ -789,6 +825,7 @@ mxArray* eigen2mat::to_mxArray(const e2m::idx_array_t& v)
 
 mxArray* eigen2mat::to_mxArray(const e2m::int_array_t& v)
 {
+     E2M_OP_SCOPE(TO_MXARRAY_INT_ARRAY, v.size() * sizeof(int), 1);
      auto ret = mxCreateNumericMatrix(v.size(), 1, mxINT32_CLASS, mxREAL);
      e2m_assert(ret);
 
@@ -804,74 +841,33 @@ mxArray* eigen2mat::to_mxArray(const e2m::int_array_t& v)
 // =============================================================================
 
 mxArray* eigen2mat::to_mxArray(const e2m::real_sp_matrix_t& m)
-
 {
      const size_t nzmax = m.nonZeros();
-     mxArray* ret = mxCreateSparse(m.rows(), m.cols(), nzmax, mxREAL);
-
-     if (m.rows() == 0 || m.cols() == 0) {
-	  return ret;
-     }
-
-     auto* values = m.valuePtr();
-     auto* ic = m.innerIndexPtr();
-     auto* jc = m.outerIndexPtr();
-     e2m_assert(values);
-     e2m_assert(ic);
-     e2m_assert(jc);
-
-     auto* other_values = mxGetPr(ret);
-     auto* other_ic = mxGetIr(ret);
-     auto* other_jc = mxGetJc(ret);
-     e2m_assert(other_values);
-     e2m_assert(other_ic);
-     e2m_assert(other_jc);
+     E2M_OP_SCOPE(TO_MXARRAY_REAL_SPARSE,
+		  nzmax * (sizeof(double) + sizeof(mwIndex))
+		  + (m.cols() + 1) * sizeof(mwIndex),
+		  1);
+     auto* ret = mxCreateSparse(m.rows(), m.cols(), nzmax, mxREAL);
+     e2m_assert(ret);
 
      e2m_assert(m.cols() == m.outerSize());
-     if (m.isCompressed()) {
-	  // matrix is compressed => easy !
-	  std::copy(values, values + nzmax, other_values);
-	  std::copy(ic, ic + nzmax, other_ic);
-	  std::copy(jc, jc + m.outerSize()+1, other_jc);
-     }
-     else {
-	  /*
-	   * Matrix not in compressed mode => pain in the #@!%#!
-	   *
-	   * Basically the problem is that the inner index array of the matrix
-	   * 'm' is not contiguous, it has holes:
-	   *    values: 22 7 _ 3 5 14 _ _ 1 _ 17 8	
-	   *    inner:   1 2 _ 0 2  4 _ _ 2 _  1 4
-	   *    outer:   0 3 5 8 10 12
-	   *    innz:    2 2 1 1 2
-	   * where _ are empty elements for fast insertion (cf. Eigen doc)
-	   *
-	   * And then we still need to correct the outer index array...
-	   *
-	   * Explanation of the variables below:
-	   * - i:     index in ret's inner index array
-	   * - o_idx: index in m's outer index array
-	   * - k:     index in m's inner index array
-	   */
-	  auto* inz = m.innerNonZeroPtr();
-	  e2m_assert(inz);
-	  size_t i(0);
-	  other_jc[0] = 0;
-	  for (int o_idx(0); o_idx < m.outerSize() ; ++o_idx) {
-	       const auto pe = jc[o_idx]+inz[o_idx];
-	       for (int k(jc[o_idx]) ; k < pe ; ++k, ++i) {
-		    other_values[i] = values[k];
-		    other_ic[i]     = ic[k];
-	       }
-	       other_jc[o_idx+1] = other_jc[o_idx] + inz[o_idx];
-	  }
-	  e2m_assert(i == nzmax);
-     }
+     eigen_to_csc(m, mxGetPr(ret), nullptr, mxGetIr(ret), mxGetJc(ret));
      return ret;
 }
 
 // =====================================
 
+mxArray* eigen2mat::to_mxArray(const e2m::real_sp_rm_matrix_t& m)
+{
+     E2M_OP_SCOPE(TO_MXARRAY_REAL_SPARSE,
+		  m.nonZeros() * (sizeof(double) + sizeof(mwIndex))
+		  + (m.cols() + 1) * sizeof(mwIndex),
+		  1);
+     return eigen_rm_to_mxArray(m, mxREAL);
+}
+
+// =====================================
+
 mxArray* eigen2mat::to_mxArray(const e2m::real_tensor_t& t)
 {
      dim_array_t dims;
@@ -887,6 +883,7 @@ mxArray* eigen2mat::to_mxArray(const e2m::real_tensor_t& t)
 	  dims[1] = t[0].cols();
      }
      const auto mat_size = dims[0] * dims[1];
+     E2M_OP_SCOPE(TO_MXARRAY_REAL_TENSOR, mat_size * dims[2] * sizeof(double), 1);
 
      auto ret = mxCreateNumericArray(dims.size(),
 				     dims.data(),
@@ -906,7 +903,7 @@ mxArray* eigen2mat::to_mxArray(const e2m::real_tensor_t& t)
 
 mxArray* eigen2mat::to_mxArray(const e2m::real_sp_cell_t& t)
 {
-     return to_1Dcell_array_helper<e2m::real_sp_cell_t>(t);
+     return to_sp_cell_helper(t, mxREAL);
 }
 
 // =============================================================================
@@ -914,78 +911,31 @@ mxArray* eigen2mat::to_mxArray(const e2m::real_sp_cell_t& t)
 mxArray* eigen2mat::to_mxArray(const e2m::cmplx_sp_matrix_t& m)
 {
      const size_t nzmax = m.nonZeros();
+     E2M_OP_SCOPE(TO_MXARRAY_CMPLX_SPARSE,
+		  nzmax * (sizeof(dcomplex) + sizeof(mwIndex))
+		  + (m.cols() + 1) * sizeof(mwIndex),
+		  1);
      auto* ret = mxCreateSparse(m.rows(), m.cols(), nzmax, mxCOMPLEX);
-
-     if (m.rows() == 0 || m.cols() == 0) {
-	  return ret;
-     }
-
-     auto* values = m.valuePtr();
-     auto* ic = m.innerIndexPtr();
-     auto* jc = m.outerIndexPtr();
-     e2m_assert(values);
-     e2m_assert(ic);
-     e2m_assert(jc);
-	  
-     auto* real = mxGetPr(ret);
-     auto* imag = mxGetPi(ret);
-     auto* other_ic = mxGetIr(ret);
-     auto* other_jc = mxGetJc(ret);
-     e2m_assert(real);
-     e2m_assert(imag);
-     e2m_assert(other_ic);
-     e2m_assert(other_jc);
+     e2m_assert(ret);
 
      e2m_assert(m.cols() == m.outerSize());
-     if (m.isCompressed()) {
-	  // matrix is compressed => easy !
-	  for (auto i(0UL) ; i < nzmax ; ++i) {
-	       real[i] = values[i].real();
-	       imag[i] = values[i].imag();
-	  }
-	  std::copy(ic, ic + nzmax, mxGetIr(ret));
-	  std::copy(jc, jc + m.outerSize()+1, mxGetJc(ret));
-     }
-     else {
-	  /*
-	   * Matrix not in compressed mode => pain in the #@!%#!
-	   *
-	   * Basically the problem is that the inner index array of the matrix
-	   * 'm' is not contiguous, it has holes:
-	   *    values: 22 7 _ 3 5 14 _ _ 1 _ 17 8	
-	   *    inner:   1 2 _ 0 2  4 _ _ 2 _  1 4
-	   *    outer:   0 3 5 8 10 12
-	   *    innz:    2 2 1 1 2
-	   * where _ are empty elements for fast insertion (cf. Eigen doc)
-	   *
-	   * And then we still need to correct the outer index array...
-	   *
-	   * Explanation of the variables below:
-	   * - i:     index in ret's inner index array
-	   * - o_idx: index in m's outer index array
-	   * - k:     index in m's inner index array
-	   */
-     	  auto* inz = m.innerNonZeroPtr();
-	  e2m_assert(inz);
-	  size_t i(0);
-	  other_jc[0] = 0;
-	  for (auto o_idx(0); o_idx < m.outerSize() ; ++o_idx) {
-	       const auto pe = jc[o_idx]+inz[o_idx];
-	       for (auto k(jc[o_idx]) ; k < pe ; ++k, ++i) {
-		    real[i] = values[k].real();
-		    imag[i] = values[k].imag();
-		    other_ic[i]     = ic[k];
-	       }
-	       other_jc[o_idx+1] = other_jc[o_idx] + inz[o_idx];
-	  }
-	  e2m_assert(i == nzmax);
-     }
-
+     eigen_to_csc(m, mxGetPr(ret), mxGetPi(ret), mxGetIr(ret), mxGetJc(ret));
      return ret;
 }
 
 // =====================================
 
+mxArray* eigen2mat::to_mxArray(const e2m::cmplx_sp_rm_matrix_t& m)
+{
+     E2M_OP_SCOPE(TO_MXARRAY_CMPLX_SPARSE,
+		  m.nonZeros() * (sizeof(dcomplex) + sizeof(mwIndex))
+		  + (m.cols() + 1) * sizeof(mwIndex),
+		  1);
+     return eigen_rm_to_mxArray(m, mxCOMPLEX);
+}
+
+// =====================================
+
 mxArray* eigen2mat::to_mxArray(const e2m::cmplx_tensor_t& t)
 {
      dim_array_t dims;
@@ -1001,6 +951,7 @@ mxArray* eigen2mat::to_mxArray(const e2m::cmplx_tensor_t& t)
 	  dims[1] = t[0].cols();
      }
      const auto mat_size = dims[0] * dims[1];
+     E2M_OP_SCOPE(TO_MXARRAY_CMPLX_TENSOR, mat_size * dims[2] * sizeof(dcomplex), 1);
 
      auto ret = mxCreateNumericArray(dims.size(),
 				     dims.data(),
@@ -1026,7 +977,7 @@ mxArray* eigen2mat::to_mxArray(const e2m::cmplx_tensor_t& t)
 
 mxArray* eigen2mat::to_mxArray(const e2m::cmplx_sp_cell_t& t)
 {
-     return to_1Dcell_array_helper<e2m::cmplx_sp_cell_t>(t);
+     return to_sp_cell_helper(t, mxCOMPLEX);
 }
 
 // #############################################################################
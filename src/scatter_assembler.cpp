@@ -0,0 +1,221 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "eigen2mat/scatter_assembler.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace e2m = eigen2mat;
+
+MSVC_IGNORE_WARNINGS(4267)
+CLANG_IGNORE_WARNINGS_ONE(-Wsign-conversion)
+
+/*
+ * 1. flatten the dofs of the elements (checking them)
+ * 2. list the elements of each dof (counting sort)
+ * 3. sparsity pattern: the rows of column c are the dofs of the elements
+ *    of dof c; they are counted, then listed and sorted (both in parallel
+ *    over the columns, using one marker array per thread)
+ * 4. position of each coefficient of each element matrix (binary search
+ *    in the columns of the pattern, in parallel over the elements)
+ * 5. greedy colouring: each element gets the smallest colour not used by
+ *    the elements that share a dof with it
+ */
+template <typename scalar_t>
+e2m::scatter_assembler<scalar_t>::scatter_assembler(
+     size_t n_dofs,
+     const std::vector<idx_array_t>& elements)
+     : elem_ptr_(elements.size() + 1, 0), elem_dofs_(),
+       pos_ptr_(elements.size() + 1, 0), positions_(),
+       color_ptr_(), color_elements_(), matrix_()
+{
+     typedef internal::par_index_t index_t;
+     const index_t E = elements.size();
+     const index_t N = n_dofs;
+
+     // 1. element dofs
+     for (index_t e(0) ; e < E ; ++e) {
+	  const auto& dofs = elements[e];
+	  for (size_t i(0) ; i < dofs.size() ; ++i) {
+	       if (dofs[i] >= n_dofs) {
+		    mexErrMsgIdAndTxt("eigen2mat:invalid_argument",
+				      "scatter_assembler: dof %d of element %d "
+				      "out of range [0, %d)",
+				      static_cast<int>(dofs[i]),
+				      static_cast<int>(e),
+				      static_cast<int>(n_dofs));
+	       }
+	  }
+	  elem_ptr_[e+1] = elem_ptr_[e] + dofs.size();
+	  pos_ptr_[e+1] = pos_ptr_[e] + dofs.size() * dofs.size();
+     }
+     elem_dofs_.resize(elem_ptr_[E]);
+     internal::parallel_for(
+	  0, E,
+	  [&](index_t e) {
+	       std::copy(elements[e].begin(), elements[e].end(),
+			 elem_dofs_.begin() + elem_ptr_[e]);
+	  }, 1024);
+
+     // 2. elements of each dof
+     std::vector<size_t> dof_ptr(N + 1, 0);
+     for (size_t k(0) ; k < elem_dofs_.size() ; ++k) {
+	  ++dof_ptr[elem_dofs_[k] + 1];
+     }
+     for (index_t d(0) ; d < N ; ++d) {
+	  dof_ptr[d+1] += dof_ptr[d];
+     }
+     std::vector<size_t> dof_elems(dof_ptr[N]);
+     {
+	  std::vector<size_t> next(dof_ptr.begin(), dof_ptr.end() - 1);
+	  for (index_t e(0) ; e < E ; ++e) {
+	       for (auto k(elem_ptr_[e]) ; k < elem_ptr_[e+1] ; ++k) {
+		    dof_elems[next[elem_dofs_[k]]++] = e;
+	       }
+	  }
+     }
+
+     // 3. sparsity pattern (thread_id() is only meaningful if the loops
+     //    below do run in parallel, ie. if T > 1)
+     const auto T = internal::max_threads();
+     std::vector<std::vector<index_t>> marks(T);
+     const auto for_each_row = [&](index_t c, std::vector<index_t>& mark,
+				   int* rows) {
+	  int n(0);
+	  for (auto k(dof_ptr[c]) ; k < dof_ptr[c+1] ; ++k) {
+	       const auto e = dof_elems[k];
+	       for (auto l(elem_ptr_[e]) ; l < elem_ptr_[e+1] ; ++l) {
+		    const index_t r = elem_dofs_[l];
+		    if (mark[r] != c) {
+			 mark[r] = c;
+			 if (rows != nullptr) {
+			      rows[n] = static_cast<int>(r);
+			 }
+			 ++n;
+		    }
+	       }
+	  }
+	  return n;
+     };
+
+     std::vector<int> col_size(N);
+     internal::parallel_for_dynamic(
+	  0, N,
+	  [&](index_t c) {
+	       auto& mark = marks[T > 1 ? internal::thread_id() : 0];
+	       if (mark.empty()) {
+		    mark.assign(N, -1);
+	       }
+	       col_size[c] = for_each_row(c, mark, nullptr);
+	  }, 256);
+
+     matrix_.resize(N, N);
+     const auto nnz = internal::parallel_exclusive_scan(N, col_size.data(),
+							matrix_.outerIndexPtr());
+     E2M_OP_SCOPE(SCATTER_ASSEMBLE,
+		  nnz * (sizeof(scalar_t) + sizeof(int))
+		  + pos_ptr_[E] * sizeof(int),
+		  2);
+     matrix_.resizeNonZeros(nnz);
+     auto* outer = matrix_.outerIndexPtr();
+     auto* inner = matrix_.innerIndexPtr();
+     for (size_t t(0) ; t < marks.size() ; ++t) {
+	  std::fill(marks[t].begin(), marks[t].end(), -1);
+     }
+     internal::parallel_for_dynamic(
+	  0, N,
+	  [&](index_t c) {
+	       auto& mark = marks[T > 1 ? internal::thread_id() : 0];
+	       if (mark.empty()) {
+		    mark.assign(N, -1);
+	       }
+	       for_each_row(c, mark, inner + outer[c]);
+	       std::sort(inner + outer[c], inner + outer[c+1]);
+	  }, 256);
+     std::vector<std::vector<index_t>>().swap(marks);
+     set_zero();
+
+     // 4. positions
+     positions_.resize(pos_ptr_[E]);
+     internal::parallel_for_dynamic(
+	  0, E,
+	  [&](index_t e) {
+	       const auto* dofs = elem_dofs_.data() + elem_ptr_[e];
+	       const auto n = elem_ptr_[e+1] - elem_ptr_[e];
+	       auto* pos = positions_.data() + pos_ptr_[e];
+	       for (size_t j(0) ; j < n ; ++j) {
+		    const auto* begin = inner + outer[dofs[j]];
+		    const auto* end = inner + outer[dofs[j] + 1];
+		    for (size_t i(0) ; i < n ; ++i) {
+			 const auto r = static_cast<int>(dofs[i]);
+			 *pos++ = static_cast<int>(std::lower_bound(begin, end, r) - inner);
+		    }
+	       }
+	  }, 256);
+
+     // 5. colouring
+     std::vector<int> color(E, -1);
+     std::vector<index_t> forbidden;
+     int n_colors(0);
+     for (index_t e(0) ; e < E ; ++e) {
+	  for (auto k(elem_ptr_[e]) ; k < elem_ptr_[e+1] ; ++k) {
+	       const auto d = elem_dofs_[k];
+	       for (auto l(dof_ptr[d]) ; l < dof_ptr[d+1] ; ++l) {
+		    const auto c = color[dof_elems[l]];
+		    if (c >= 0) {
+			 forbidden[c] = e;
+		    }
+	       }
+	  }
+	  int c(0);
+	  while (c < n_colors && forbidden[c] == e) {
+	       ++c;
+	  }
+	  if (c == n_colors) {
+	       ++n_colors;
+	       forbidden.push_back(-1);
+	  }
+	  color[e] = c;
+     }
+
+     color_ptr_.assign(n_colors + 1, 0);
+     for (index_t e(0) ; e < E ; ++e) {
+	  ++color_ptr_[color[e] + 1];
+     }
+     for (int c(0) ; c < n_colors ; ++c) {
+	  color_ptr_[c+1] += color_ptr_[c];
+     }
+     color_elements_.resize(E);
+     std::vector<size_t> next(color_ptr_.begin(), color_ptr_.end() - 1);
+     for (index_t e(0) ; e < E ; ++e) {
+	  color_elements_[next[color[e]]++] = e;
+     }
+}
+
+// =====================================
+
+template <typename scalar_t>
+void e2m::scatter_assembler<scalar_t>::set_zero()
+{
+     auto* values = matrix_.valuePtr();
+     internal::parallel_for(
+	  0, matrix_.nonZeros(),
+	  [&](internal::par_index_t k) {
+	       values[k] = scalar_t(0);
+	  }, 65536);
+}
+
+// =============================================================================
+
+template class e2m::scatter_assembler<double>;
+template class e2m::scatter_assembler<e2m::dcomplex>;
+
+CLANG_RESTORE_WARNINGS
+MSVC_RESTORE_WARNINGS
@@ -0,0 +1,312 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "eigen2mat/sparse_assembler.hpp"
+#include "eigen2mat/details/complex_traits.hpp"
+#include "eigen2mat/details/mxarray_helpers.hpp"
+#include "eigen2mat/details/op_scope.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace e2m = eigen2mat;
+
+MSVC_IGNORE_WARNINGS(4267)
+CLANG_IGNORE_WARNINGS_ONE(-Wsign-conversion)
+
+namespace {
+     // Columns with more elements are sorted with std::stable_sort
+     const e2m::size_t insertion_sort_threshold = 32;
+
+     /*
+      * Sort the elements of one column by row (stable, so that duplicates
+      * are always summed in the same order) and sum the duplicates.
+      *
+      * \return number of unique elements, stored at the beginning of the
+      *         arrays
+      */
+     template <typename scalar_t>
+     e2m::size_t sort_and_sum_column(int* rows, scalar_t* values, e2m::size_t n)
+     {
+	  if (n == 0) {
+	       return 0;
+	  }
+
+	  if (n <= insertion_sort_threshold) {
+	       for (e2m::size_t i(1) ; i < n ; ++i) {
+		    const auto r = rows[i];
+		    const auto v = values[i];
+		    auto j(i);
+		    for ( ; j > 0 && rows[j-1] > r ; --j) {
+			 rows[j] = rows[j-1];
+			 values[j] = values[j-1];
+		    }
+		    rows[j] = r;
+		    values[j] = v;
+	       }
+	  }
+	  else {
+	       std::vector<std::pair<int, scalar_t>> tmp(n);
+	       for (e2m::size_t i(0) ; i < n ; ++i) {
+		    tmp[i] = std::make_pair(rows[i], values[i]);
+	       }
+	       std::stable_sort(tmp.begin(), tmp.end(),
+				[](const std::pair<int, scalar_t>& a,
+				   const std::pair<int, scalar_t>& b) {
+				     return a.first < b.first;
+				});
+	       for (e2m::size_t i(0) ; i < n ; ++i) {
+		    rows[i] = tmp[i].first;
+		    values[i] = tmp[i].second;
+	       }
+	  }
+
+	  e2m::size_t u(0);
+	  for (e2m::size_t i(1) ; i < n ; ++i) {
+	       if (rows[i] == rows[u]) {
+		    values[u] += values[i];
+	       }
+	       else {
+		    ++u;
+		    rows[u] = rows[i];
+		    values[u] = values[i];
+	       }
+	  }
+	  return u + 1;
+     }
+} // namespace
+
+// =============================================================================
+
+template <typename scalar_t>
+e2m::sparse_assembler<scalar_t>::sparse_assembler(size_t rows, size_t cols)
+     : rows_(rows), cols_(cols),
+       buffers_(internal::max_threads()),
+       merged_(false), start_(), nnz_(), jc_(),
+       merged_rows_(), merged_values_()
+{}
+
+// =====================================
+
+template <typename scalar_t>
+void e2m::sparse_assembler<scalar_t>::reserve(size_t n)
+{
+     for (auto b(0UL) ; b < buffers_.size() ; ++b) {
+	  buffers_[b].rows.reserve(n);
+	  buffers_[b].cols.reserve(n);
+	  buffers_[b].values.reserve(n);
+     }
+}
+
+// =====================================
+
+template <typename scalar_t>
+e2m::size_t e2m::sparse_assembler<scalar_t>::size() const
+{
+     if (merged_) {
+	  return merged_rows_.size();
+     }
+     size_t ret(0);
+     for (auto b(0UL) ; b < buffers_.size() ; ++b) {
+	  ret += buffers_[b].rows.size();
+     }
+     return ret;
+}
+
+// =====================================
+
+template <typename scalar_t>
+void e2m::sparse_assembler<scalar_t>::clear()
+{
+     for (auto b(0UL) ; b < buffers_.size() ; ++b) {
+	  buffers_[b].rows.clear();
+	  buffers_[b].cols.clear();
+	  buffers_[b].values.clear();
+     }
+     merged_ = false;
+     start_.clear();
+     nnz_.clear();
+     jc_.clear();
+     std::vector<int>().swap(merged_rows_);
+     std::vector<scalar_t>().swap(merged_values_);
+}
+
+// =====================================
+
+/*
+ * 1. count the contributions of each group of buffers to each column
+ * 2. turn the counts into offsets: column c of group g starts at
+ *    start_[c] + (sum of the counts of column c in groups 0..g-1)
+ * 3. scatter the contributions of each group, then release its buffers
+ * 4. sort each column by row and sum the duplicates
+ * 5. compute the final column pointers
+ *
+ * Each buffer is its own group, unless the groups x columns table of
+ * counts would be bigger than the contributions (eg. wide matrices): all
+ * the buffers then form a single group, processed serially. Steps 1 & 3
+ * run in parallel over the groups, steps 2 & 4 over the columns. Since
+ * the buffers are scattered in order, the result does not depend on the
+ * scheduling nor on the grouping (for a given distribution of the
+ * contributions over the threads).
+ */
+template <typename scalar_t>
+void e2m::sparse_assembler<scalar_t>::merge_()
+{
+     if (merged_) {
+	  return;
+     }
+
+     typedef internal::par_index_t index_t;
+     const index_t B = buffers_.size();
+     const index_t N = cols_;
+     const auto total = size();
+     const index_t G = static_cast<size_t>(B * N) <= std::max<size_t>(total, N) ? B : 1;
+     E2M_OP_SCOPE(SPARSE_ASSEMBLE,
+		  total * 2 * (sizeof(scalar_t) + sizeof(int))
+		  + G * N * sizeof(unsigned),
+		  2);
+
+     // buffers of group g are [first_buffer(g), first_buffer(g+1))
+     const auto first_buffer = [&](index_t g) {return G == 1 ? (g == 0 ? 0 : B) : g;};
+
+     // 1. per group column counts
+     std::vector<unsigned> offsets(G * N, 0);
+     internal::parallel_for(
+	  0, G,
+	  [&](index_t g) {
+	       auto* count = offsets.data() + g * N;
+	       for (auto b(first_buffer(g)) ; b < first_buffer(g + 1) ; ++b) {
+		    const auto& cols = buffers_[b].cols;
+		    for (auto k(0UL) ; k < cols.size() ; ++k) {
+			 ++count[cols[k]];
+		    }
+	       }
+	  });
+
+     // 2. offsets inside each column, then columns offsets
+     std::vector<size_t> col_size(N);
+     internal::parallel_for(
+	  0, N,
+	  [&](index_t c) {
+	       size_t sum(0);
+	       for (index_t g(0) ; g < G ; ++g) {
+		    const auto n = offsets[g * N + c];
+		    offsets[g * N + c] = static_cast<unsigned>(sum);
+		    sum += n;
+	       }
+	       col_size[c] = sum;
+	  }, 4096);
+     start_.resize(N + 1);
+     internal::parallel_exclusive_scan(N, col_size.data(), start_.data());
+
+     // 3. scatter
+     merged_rows_.resize(total);
+     merged_values_.resize(total);
+     internal::parallel_for(
+	  0, G,
+	  [&](index_t g) {
+	       auto* offset = offsets.data() + g * N;
+	       for (auto b(first_buffer(g)) ; b < first_buffer(g + 1) ; ++b) {
+		    auto& buf = buffers_[b];
+		    for (size_t k(0) ; k < buf.rows.size() ; ++k) {
+			 const auto col = buf.cols[k];
+			 const auto p = start_[col] + offset[col]++;
+			 merged_rows_[p] = buf.rows[k];
+			 merged_values_[p] = buf.values[k];
+		    }
+		    std::vector<int>().swap(buf.rows);
+		    std::vector<int>().swap(buf.cols);
+		    std::vector<scalar_t>().swap(buf.values);
+	       }
+	  });
+     std::vector<unsigned>().swap(offsets);
+
+     // 4. sort & sum duplicates
+     nnz_.resize(N);
+     internal::parallel_for_dynamic(
+	  0, N,
+	  [&](index_t c) {
+	       nnz_[c] = sort_and_sum_column(merged_rows_.data() + start_[c],
+					     merged_values_.data() + start_[c],
+					     col_size[c]);
+	  }, 256);
+
+     // 5. final column pointers
+     jc_.resize(N + 1);
+     internal::parallel_exclusive_scan(N, nnz_.data(), jc_.data());
+     merged_ = true;
+}
+
+// =====================================
+
+template <typename scalar_t>
+mxArray* e2m::sparse_assembler<scalar_t>::to_mxArray()
+{
+     merge_();
+
+     const internal::par_index_t N = cols_;
+     const bool is_cmplx = internal::complex_traits<scalar_t>::is_cmplx;
+     auto* ret = internal::create_sparse(rows_, cols_, jc_.data(), is_cmplx);
+     auto* pr = mxGetPr(ret);
+     auto* pi = mxGetPi(ret);
+     auto* ir = mxGetIr(ret);
+     E2M_OP_SCOPE(SPARSE_ASSEMBLE,
+		  jc_[N] * ((is_cmplx ? 2 : 1) * sizeof(double) + sizeof(mwIndex))
+		  + (N + 1) * sizeof(mwIndex),
+		  1);
+
+     internal::parallel_for_dynamic(
+	  0, N,
+	  [&](internal::par_index_t c) {
+	       const auto* rows = merged_rows_.data() + start_[c];
+	       const auto* values = merged_values_.data() + start_[c];
+	       const auto k = jc_[c];
+	       std::copy(rows, rows + nnz_[c], ir + k);
+	       internal::split_values(values, nnz_[c],
+				      pr + k, pi == nullptr ? nullptr : pi + k);
+	  }, 256);
+     return ret;
+}
+
+// =====================================
+
+template <typename scalar_t>
+void e2m::sparse_assembler<scalar_t>::to_eigen(sp_matrix_t& out)
+{
+     merge_();
+
+     const internal::par_index_t N = cols_;
+     out.resize(rows_, cols_);
+     out.resizeNonZeros(jc_[N]);
+     std::copy(jc_.begin(), jc_.end(), out.outerIndexPtr());
+
+     auto* inner = out.innerIndexPtr();
+     auto* values = out.valuePtr();
+     internal::parallel_for_dynamic(
+	  0, N,
+	  [&](internal::par_index_t c) {
+	       const auto s = start_[c];
+	       const auto k = jc_[c];
+	       std::copy(merged_rows_.data() + s,
+			 merged_rows_.data() + s + nnz_[c],
+			 inner + k);
+	       std::copy(merged_values_.data() + s,
+			 merged_values_.data() + s + nnz_[c],
+			 values + k);
+	  }, 256);
+}
+
+// =============================================================================
+
+template class e2m::sparse_assembler<double>;
+template class e2m::sparse_assembler<e2m::dcomplex>;
+
+CLANG_RESTORE_WARNINGS
+MSVC_RESTORE_WARNINGS
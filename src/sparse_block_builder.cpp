@@ -0,0 +1,343 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "eigen2mat/sparse_block_builder.hpp"
+#include "eigen2mat/details/complex_traits.hpp"
+#include "eigen2mat/details/mxarray_helpers.hpp"
+#include "eigen2mat/details/op_scope.hpp"
+#include "eigen2mat/details/sparse_expressions_conversions.hpp"
+#include "eigen2mat/utils/macros.hpp"
+#include "eigen2mat/utils/parallel.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace e2m = eigen2mat;
+
+MSVC_IGNORE_WARNINGS(4267)
+CLANG_IGNORE_WARNINGS_TWO(-Wshorten-64-to-32,-Wsign-conversion)
+
+namespace {
+     inline double conj_value(double v)
+     {
+	  return v;
+     }
+
+     inline e2m::dcomplex conj_value(const e2m::dcomplex& v)
+     {
+	  return std::conj(v);
+     }
+
+     // Stores element k of the result into an Eigen value array
+     template <typename scalar_t>
+     struct eigen_store_t
+     {
+	  explicit eigen_store_t(scalar_t* values) : values_(values) {}
+
+	  void operator()(e2m::size_t k, const scalar_t& v) const
+	       {
+		    values_[k] = v;
+	       }
+
+	  scalar_t* values_;
+     };
+
+     // Stores element k of the result into the Pr/Pi arrays of an mxArray
+     struct mx_store_t
+     {
+	  mx_store_t(double* pr, double* pi) : pr_(pr), pi_(pi) {}
+
+	  template <typename scalar_t>
+	  void operator()(e2m::size_t k, const scalar_t& v) const
+	       {
+		    e2m::internal::store_value(pr_, pi_, k, v);
+	       }
+
+	  double* pr_;
+	  double* pi_;
+     };
+} // namespace
+
+// =============================================================================
+
+template <typename scalar_t>
+e2m::sparse_block_builder<scalar_t>::sparse_block_builder(size_t block_rows,
+							   size_t block_cols)
+     : block_rows_(block_rows), block_cols_(block_cols),
+       blocks_(block_rows * block_cols,
+	       block_t{nullptr, scalar_t(0), NO_TRANSPOSE, 0, 0, false})
+{}
+
+// =====================================
+
+template <typename scalar_t>
+void e2m::sparse_block_builder<scalar_t>::set(size_t i, size_t j,
+					       const sp_matrix_t& m,
+					       const scalar_t& scale,
+					       TRANSPOSE_T op)
+{
+     e2m_assert(i < block_rows_ && j < block_cols_);
+     const bool transposed = op != NO_TRANSPOSE;
+     auto& b = blocks_[i * block_cols_ + j];
+     // blocks scaled by exactly zero are skipped
+     GCC_IGNORE_WARNINGS_ONE(-Wfloat-equal)
+     CLANG_IGNORE_WARNINGS_ONE(-Wfloat-equal)
+     b.m = scale == scalar_t(0) ? nullptr : &m;
+     CLANG_RESTORE_WARNINGS
+     GCC_RESTORE_WARNINGS
+     b.scale = scale;
+     b.op = op;
+     b.rows = transposed ? m.cols() : m.rows();
+     b.cols = transposed ? m.rows() : m.cols();
+     b.is_set = true;
+}
+
+// =====================================
+
+template <typename scalar_t>
+void e2m::sparse_block_builder<scalar_t>::set_zero(size_t i, size_t j,
+						    size_t rows, size_t cols)
+{
+     e2m_assert(i < block_rows_ && j < block_cols_);
+     blocks_[i * block_cols_ + j] = block_t{nullptr, scalar_t(0), NO_TRANSPOSE,
+					    rows, cols, true};
+}
+
+// =====================================
+
+/*
+ * 1. size of the block rows & columns (checking that they are consistent)
+ * 2. number of non-zeros of each block row in each column of the result
+ * 3. turn the counts into offsets inside each column, then compute the
+ *    column pointers
+ *
+ * Step 2 runs in parallel over the blocks, step 3 over the columns.
+ */
+template <typename scalar_t>
+void e2m::sparse_block_builder<scalar_t>::layout_(layout_t& l) const
+{
+     typedef internal::par_index_t index_t;
+     const index_t BR = block_rows_;
+     const index_t BC = block_cols_;
+
+     // 1. sizes
+     std::vector<size_t> rows(BR, 0), cols(BC, 0);
+     std::vector<char> rows_set(BR, 0), cols_set(BC, 0);
+     for (index_t i(0) ; i < BR ; ++i) {
+	  for (index_t j(0) ; j < BC ; ++j) {
+	       const auto& b = block_(i, j);
+	       if (!b.is_set) {
+		    continue;
+	       }
+	       if (rows_set[i] && rows[i] != b.rows) {
+		    mexErrMsgIdAndTxt("eigen2mat:invalid_argument",
+				      "sparse_block_builder: block (%d,%d) has %d "
+				      "rows, expected %d",
+				      static_cast<int>(i), static_cast<int>(j),
+				      static_cast<int>(b.rows),
+				      static_cast<int>(rows[i]));
+	       }
+	       if (cols_set[j] && cols[j] != b.cols) {
+		    mexErrMsgIdAndTxt("eigen2mat:invalid_argument",
+				      "sparse_block_builder: block (%d,%d) has %d "
+				      "columns, expected %d",
+				      static_cast<int>(i), static_cast<int>(j),
+				      static_cast<int>(b.cols),
+				      static_cast<int>(cols[j]));
+	       }
+	       rows[i] = b.rows;
+	       cols[j] = b.cols;
+	       rows_set[i] = cols_set[j] = 1;
+	  }
+     }
+     l.row_off.assign(BR + 1, 0);
+     l.col_off.assign(BC + 1, 0);
+     for (index_t i(0) ; i < BR ; ++i) {
+	  l.row_off[i+1] = l.row_off[i] + rows[i];
+     }
+     for (index_t j(0) ; j < BC ; ++j) {
+	  l.col_off[j+1] = l.col_off[j] + cols[j];
+     }
+
+     // 2. per block row column counts
+     const index_t N = l.col_off[BC];
+     l.seg_off.assign(BR * N, 0);
+     internal::parallel_for_dynamic(
+	  0, BR * BC,
+	  [&](index_t ij) {
+	       const index_t i = ij / BC;
+	       const index_t j = ij % BC;
+	       const auto& b = block_(i, j);
+	       if (b.m == nullptr) {
+		    return;
+	       }
+	       auto* count = l.seg_off.data() + i * N + l.col_off[j];
+	       if (b.op == NO_TRANSPOSE) {
+		    for (index_t c(0) ; c < b.m->cols() ; ++c) {
+			 int begin(0), end(0);
+			 internal::column_range(*b.m, c, begin, end);
+			 count[c] = end - begin;
+		    }
+	       }
+	       else {
+		    const auto* inner = b.m->innerIndexPtr();
+		    for (index_t c(0) ; c < b.m->cols() ; ++c) {
+			 int begin(0), end(0);
+			 internal::column_range(*b.m, c, begin, end);
+			 for (auto k(begin) ; k < end ; ++k) {
+			      ++count[inner[k]];
+			 }
+		    }
+	       }
+	  }, 1);
+
+     // 3. offsets inside each column, then column pointers
+     std::vector<size_t> col_size(N);
+     internal::parallel_for(
+	  0, N,
+	  [&](index_t c) {
+	       size_t sum(0);
+	       for (index_t i(0) ; i < BR ; ++i) {
+		    const auto n = l.seg_off[i * N + c];
+		    l.seg_off[i * N + c] = sum;
+		    sum += n;
+	       }
+	       col_size[c] = sum;
+	  }, 4096);
+     l.col_ptr.resize(N + 1);
+     internal::parallel_exclusive_scan(N, col_size.data(), l.col_ptr.data());
+}
+
+// =====================================
+
+/*
+ * Non transposed blocks are copied column by column, in parallel over the
+ * columns of the result. Transposed blocks are scattered (in parallel over
+ * the blocks): the columns of the source are visited in order, so that the
+ * row indices end up sorted in each column of the result.
+ */
+template <typename scalar_t>
+template <typename index_t, typename store_t>
+void e2m::sparse_block_builder<scalar_t>::fill_(const layout_t& l,
+						 index_t* inner,
+						 store_t store) const
+{
+     typedef internal::par_index_t par_index_t;
+     const par_index_t BR = block_rows_;
+     const par_index_t BC = block_cols_;
+     const par_index_t N = l.col_off[BC];
+
+     internal::parallel_for(
+	  0, N,
+	  [&](par_index_t col) {
+	       // block column of col
+	       const par_index_t j = std::upper_bound(l.col_off.begin(),
+						      l.col_off.end(),
+						      static_cast<size_t>(col))
+		    - l.col_off.begin() - 1;
+	       const auto c = col - l.col_off[j];
+	       for (par_index_t i(0) ; i < BR ; ++i) {
+		    const auto& b = block_(i, j);
+		    if (b.m == nullptr || b.op != NO_TRANSPOSE) {
+			 continue;
+		    }
+		    int begin(0), end(0);
+		    internal::column_range(*b.m, c, begin, end);
+		    const auto* src_inner = b.m->innerIndexPtr();
+		    const auto* src_values = b.m->valuePtr();
+		    const auto row_off = l.row_off[i];
+		    auto p = l.col_ptr[col] + l.seg_off[i * N + col];
+		    for (auto k(begin) ; k < end ; ++k, ++p) {
+			 inner[p] = static_cast<index_t>(row_off + src_inner[k]);
+			 store(p, b.scale * src_values[k]);
+		    }
+	       }
+	  }, 64);
+
+     internal::parallel_for_dynamic(
+	  0, BR * BC,
+	  [&](par_index_t ij) {
+	       const par_index_t i = ij / BC;
+	       const par_index_t j = ij % BC;
+	       const auto& b = block_(i, j);
+	       if (b.m == nullptr || b.op == NO_TRANSPOSE) {
+		    return;
+	       }
+	       const auto* src_inner = b.m->innerIndexPtr();
+	       const auto* src_values = b.m->valuePtr();
+	       const auto row_off = l.row_off[i];
+	       std::vector<size_t> pos(b.cols);
+	       for (size_t c(0) ; c < b.cols ; ++c) {
+		    const auto col = l.col_off[j] + c;
+		    pos[c] = l.col_ptr[col] + l.seg_off[i * N + col];
+	       }
+	       for (par_index_t c(0) ; c < b.m->cols() ; ++c) {
+		    int begin(0), end(0);
+		    internal::column_range(*b.m, c, begin, end);
+		    for (auto k(begin) ; k < end ; ++k) {
+			 const auto p = pos[src_inner[k]]++;
+			 inner[p] = static_cast<index_t>(row_off + c);
+			 store(p, b.op == CTRANSPOSE
+			       ? b.scale * conj_value(src_values[k])
+			       : b.scale * src_values[k]);
+		    }
+	       }
+	  }, 1);
+}
+
+// =====================================
+
+template <typename scalar_t>
+mxArray* e2m::sparse_block_builder<scalar_t>::to_mxArray() const
+{
+     layout_t l;
+     layout_(l);
+
+     const internal::par_index_t M = l.row_off.back();
+     const internal::par_index_t N = l.col_off.back();
+     const bool is_cmplx = internal::complex_traits<scalar_t>::is_cmplx;
+     E2M_OP_SCOPE(SPARSE_BLOCK_BUILD,
+		  l.col_ptr[N] * ((is_cmplx ? 2 : 1) * sizeof(double)
+				  + sizeof(mwIndex))
+		  + (N + 1) * sizeof(mwIndex),
+		  1);
+     auto* ret = internal::create_sparse(M, N, l.col_ptr.data(), is_cmplx);
+     auto* ir = mxGetIr(ret);
+
+     fill_(l, ir, mx_store_t(mxGetPr(ret), mxGetPi(ret)));
+     return ret;
+}
+
+// =====================================
+
+template <typename scalar_t>
+void e2m::sparse_block_builder<scalar_t>::to_eigen(sp_matrix_t& out) const
+{
+     layout_t l;
+     layout_(l);
+
+     const auto N = l.col_off.back();
+     const auto nnz = l.col_ptr[N];
+     E2M_OP_SCOPE(SPARSE_BLOCK_BUILD,
+		  nnz * (sizeof(scalar_t) + sizeof(int)) + (N + 1) * sizeof(int),
+		  1);
+     out.resize(l.row_off.back(), N);
+     out.resizeNonZeros(nnz);
+     std::copy(l.col_ptr.begin(), l.col_ptr.end(), out.outerIndexPtr());
+
+     fill_(l, out.innerIndexPtr(), eigen_store_t<scalar_t>(out.valuePtr()));
+}
+
+// =============================================================================
+
+template class e2m::sparse_block_builder<double>;
+template class e2m::sparse_block_builder<e2m::dcomplex>;
+
+CLANG_RESTORE_WARNINGS
+MSVC_RESTORE_WARNINGS
@@ -0,0 +1,446 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "eigen2mat/sparse_edit.hpp"
+#include "eigen2mat/details/complex_traits.hpp"
+#include "eigen2mat/details/mxarray_helpers.hpp"
+#include "eigen2mat/details/op_scope.hpp"
+#include "eigen2mat/details/sparse_expressions_conversions.hpp"
+#include "eigen2mat/utils/macros.hpp"
+#include "eigen2mat/utils/parallel.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace e2m = eigen2mat;
+
+MSVC_IGNORE_WARNINGS(4267)
+CLANG_IGNORE_WARNINGS_TWO(-Wshorten-64-to-32,-Wsign-conversion)
+
+namespace {
+     /*
+      * Flags of the elements of [0, n) that are kept once the elements of
+      * idx are removed.
+      */
+     std::vector<char> kept_flags(e2m::size_t n,
+				  const e2m::idx_array_t& idx,
+				  const char* func)
+     {
+	  std::vector<char> ret(n, 1);
+	  for (auto k(0UL) ; k < idx.size() ; ++k) {
+	       if (idx[k] >= n) {
+		    mexErrMsgIdAndTxt("eigen2mat:invalid_argument",
+				      "%s: index %d out of range [0, %d)",
+				      func, static_cast<int>(idx[k]),
+				      static_cast<int>(n));
+	       }
+	       ret[idx[k]] = 0;
+	  }
+	  return ret;
+     }
+
+     /*
+      * New index of each row once the rows of idx are removed (-1 for the
+      * removed rows).
+      */
+     std::vector<int> row_map(e2m::size_t M, const e2m::idx_array_t& idx)
+     {
+	  const auto kept = kept_flags(M, idx, "remove_rows()");
+	  std::vector<int> ret(M);
+	  int r(0);
+	  for (e2m::size_t i(0) ; i < M ; ++i) {
+	       ret[i] = kept[i] ? r++ : -1;
+	  }
+	  return ret;
+     }
+
+     template <typename sp_matrix_t>
+     void check_positions(const sp_matrix_t& m,
+			  const e2m::idx_array_t& pos,
+			  const sp_matrix_t& cols,
+			  const char* func)
+     {
+	  if (cols.rows() != m.rows()) {
+	       mexErrMsgIdAndTxt("eigen2mat:invalid_argument",
+				 "%s: the columns to insert have %d rows, expected %d",
+				 func, static_cast<int>(cols.rows()),
+				 static_cast<int>(m.rows()));
+	  }
+	  if (pos.size() != static_cast<e2m::size_t>(cols.cols())) {
+	       mexErrMsgIdAndTxt("eigen2mat:invalid_argument",
+				 "%s: %d positions given for %d columns",
+				 func, static_cast<int>(pos.size()),
+				 static_cast<int>(cols.cols()));
+	  }
+	  const e2m::size_t N = m.cols() + cols.cols();
+	  for (auto k(0UL) ; k < pos.size() ; ++k) {
+	       if (pos[k] >= N || (k > 0 && pos[k] <= pos[k-1])) {
+		    mexErrMsgIdAndTxt("eigen2mat:invalid_argument",
+				      "%s: positions must be strictly increasing "
+				      "and smaller than %d",
+				      func, static_cast<int>(N));
+	       }
+	  }
+     }
+
+     /*
+      * Replace the outer index array of m (compressed) with new_outer and
+      * change its dimensions to rows x (new_outer.size() - 1), keeping its
+      * inner index and value arrays.
+      */
+     template <typename sp_matrix_t>
+     void reshape_storage(sp_matrix_t& m,
+			  e2m::size_t rows,
+			  const std::vector<int>& new_outer)
+     {
+	  sp_matrix_t ret(rows, new_outer.size() - 1);
+	  ret.data().swap(m.data());
+	  std::copy(new_outer.begin(), new_outer.end(), ret.outerIndexPtr());
+	  ret.resizeNonZeros(new_outer.back());
+	  m.swap(ret);
+     }
+
+     // =========================================================================
+
+     template <typename sp_matrix_t>
+     void remove_rows_helper(sp_matrix_t& m, const e2m::idx_array_t& rows)
+     {
+	  const auto map = row_map(m.rows(), rows);
+	  const auto M = m.rows() - std::count(map.begin(), map.end(), -1);
+	  m.makeCompressed();
+	  E2M_OP_SCOPE(SPARSE_EDIT,
+		       m.nonZeros() * (sizeof(typename sp_matrix_t::Scalar) + sizeof(int)),
+		       0);
+
+	  const e2m::size_t N = m.cols();
+	  const auto* outer = m.outerIndexPtr();
+	  auto* inner = m.innerIndexPtr();
+	  auto* values = m.valuePtr();
+	  std::vector<int> new_outer(N + 1, 0);
+	  int p(0);
+	  for (e2m::size_t j(0) ; j < N ; ++j) {
+	       for (auto k(outer[j]) ; k < outer[j+1] ; ++k) {
+		    const auto r = map[inner[k]];
+		    if (r >= 0) {
+			 inner[p] = r;
+			 values[p++] = values[k];
+		    }
+	       }
+	       new_outer[j+1] = p;
+	  }
+	  reshape_storage(m, M, new_outer);
+     }
+
+     template <typename sp_matrix_t>
+     void remove_cols_helper(sp_matrix_t& m, const e2m::idx_array_t& cols)
+     {
+	  const e2m::size_t N = m.cols();
+	  const auto kept = kept_flags(N, cols, "remove_cols()");
+	  m.makeCompressed();
+
+	  const auto* outer = m.outerIndexPtr();
+	  auto* inner = m.innerIndexPtr();
+	  auto* values = m.valuePtr();
+	  std::vector<int> new_outer(1, 0);
+	  new_outer.reserve(N + 1);
+	  int p(0);
+	  for (e2m::size_t j(0) ; j < N ; ++j) {
+	       if (kept[j]) {
+		    // p <= outer[j]: forward copies are safe
+		    std::copy(inner + outer[j], inner + outer[j+1], inner + p);
+		    std::copy(values + outer[j], values + outer[j+1], values + p);
+		    p += outer[j+1] - outer[j];
+		    new_outer.push_back(p);
+	       }
+	  }
+	  E2M_OP_SCOPE(SPARSE_EDIT,
+		       p * (sizeof(typename sp_matrix_t::Scalar) + sizeof(int)),
+		       0);
+	  reshape_storage(m, m.rows(), new_outer);
+     }
+
+     template <typename sp_matrix_t>
+     void insert_cols_helper(sp_matrix_t& m,
+			     const e2m::idx_array_t& pos,
+			     const sp_matrix_t& cols)
+     {
+	  if (&cols == &m) {
+	       // the storage of m is grown below while cols is read
+	       const sp_matrix_t copy(cols);
+	       insert_cols_helper(m, pos, copy);
+	       return;
+	  }
+	  check_positions(m, pos, cols, "insert_cols()");
+	  m.makeCompressed();
+
+	  // column pointers of the result
+	  const e2m::size_t N = m.cols() + cols.cols();
+	  std::vector<int> new_outer(N + 1, 0);
+	  for (e2m::size_t j(0), c(0), q(0) ; j < N ; ++j) {
+	       int begin(0), end(0);
+	       if (q < pos.size() && pos[q] == j) {
+		    e2m::internal::column_range(cols, q++, begin, end);
+	       }
+	       else {
+		    e2m::internal::column_range(m, c++, begin, end);
+	       }
+	       new_outer[j+1] = new_outer[j] + (end - begin);
+	  }
+	  E2M_OP_SCOPE(SPARSE_EDIT,
+		       new_outer[N] * (sizeof(typename sp_matrix_t::Scalar) + sizeof(int)),
+		       1);
+
+	  /*
+	   * Grow the storage (existing elements are kept), then merge from
+	   * the last column to the first: each column of m moves towards the
+	   * end of the arrays, so it is never overwritten before being moved.
+	   */
+	  m.resizeNonZeros(new_outer[N]);
+	  const auto* outer = m.outerIndexPtr();
+	  auto* inner = m.innerIndexPtr();
+	  auto* values = m.valuePtr();
+	  auto c = static_cast<int>(m.cols());
+	  auto q = static_cast<int>(pos.size());
+	  for (auto j(static_cast<int>(N) - 1) ; j >= 0 ; --j) {
+	       if (q > 0 && pos[q-1] == static_cast<e2m::size_t>(j)) {
+		    --q;
+		    int begin(0), end(0);
+		    e2m::internal::column_range(cols, q, begin, end);
+		    std::copy(cols.innerIndexPtr() + begin,
+			      cols.innerIndexPtr() + end,
+			      inner + new_outer[j]);
+		    std::copy(cols.valuePtr() + begin,
+			      cols.valuePtr() + end,
+			      values + new_outer[j]);
+	       }
+	       else {
+		    --c;
+		    std::copy_backward(inner + outer[c], inner + outer[c+1],
+				       inner + new_outer[j+1]);
+		    std::copy_backward(values + outer[c], values + outer[c+1],
+				       values + new_outer[j+1]);
+	       }
+	  }
+	  reshape_storage(m, m.rows(), new_outer);
+     }
+
+     // =========================================================================
+
+     /*
+      * Copy columns of one or two matrices into a new MATLAB sparse matrix:
+      * column j of the result is column src_col[j] of *src[j], row i
+      * becoming row row_map[i] (dropped if negative) if row_map is not
+      * empty.
+      *
+      * Both the count and the copy run in parallel over the columns.
+      */
+     template <typename sp_matrix_t>
+     mxArray* columns_to_mxArray(e2m::size_t M,
+				 const std::vector<const sp_matrix_t*>& src,
+				 const std::vector<int>& src_col,
+				 const std::vector<int>& row_map)
+     {
+	  typedef e2m::internal::par_index_t index_t;
+	  typedef typename sp_matrix_t::Scalar Scalar;
+	  const bool is_cmplx = e2m::internal::complex_traits<Scalar>::is_cmplx;
+	  const index_t N = src.size();
+	  const bool remap = !row_map.empty();
+
+	  std::vector<mwIndex> counts(N);
+	  e2m::internal::parallel_for_dynamic(
+	       0, N,
+	       [&](index_t j) {
+		    int begin(0), end(0);
+		    e2m::internal::column_range(*src[j], src_col[j], begin, end);
+		    if (remap) {
+			 const auto* inner = src[j]->innerIndexPtr();
+			 mwIndex n(0);
+			 for (auto k(begin) ; k < end ; ++k) {
+			      n += (row_map[inner[k]] >= 0);
+			 }
+			 counts[j] = n;
+		    }
+		    else {
+			 counts[j] = end - begin;
+		    }
+	       }, 256);
+	  auto* ret = e2m::internal::create_sparse_from_counts(M, N, counts.data(),
+							       is_cmplx);
+	  auto* pr = mxGetPr(ret);
+	  auto* pi = mxGetPi(ret);
+	  auto* ir = mxGetIr(ret);
+	  const auto* jc = mxGetJc(ret);
+	  E2M_OP_SCOPE(SPARSE_EDIT,
+		       jc[N] * ((is_cmplx ? 2 : 1) * sizeof(double) + sizeof(mwIndex))
+		       + (N + 1) * sizeof(mwIndex),
+		       1);
+
+	  e2m::internal::parallel_for_dynamic(
+	       0, N,
+	       [&](index_t j) {
+		    int begin(0), end(0);
+		    e2m::internal::column_range(*src[j], src_col[j], begin, end);
+		    const auto* inner = src[j]->innerIndexPtr();
+		    const auto* values = src[j]->valuePtr();
+		    auto p = jc[j];
+		    for (auto k(begin) ; k < end ; ++k) {
+			 const int r = remap ? row_map[inner[k]] : inner[k];
+			 if (r >= 0) {
+			      ir[p] = r;
+			      e2m::internal::store_value(pr, pi, p++, values[k]);
+			 }
+		    }
+	       }, 256);
+	  return ret;
+     }
+
+     template <typename sp_matrix_t>
+     mxArray* remove_rows_to_mxArray_helper(const sp_matrix_t& m,
+					    const e2m::idx_array_t& rows)
+     {
+	  const auto map = row_map(m.rows(), rows);
+	  const e2m::size_t N = m.cols();
+	  std::vector<const sp_matrix_t*> src(N, &m);
+	  std::vector<int> src_col(N);
+	  for (e2m::size_t j(0) ; j < N ; ++j) {
+	       src_col[j] = static_cast<int>(j);
+	  }
+	  return columns_to_mxArray(m.rows() - std::count(map.begin(), map.end(), -1),
+				    src, src_col, map);
+     }
+
+     template <typename sp_matrix_t>
+     mxArray* remove_cols_to_mxArray_helper(const sp_matrix_t& m,
+					    const e2m::idx_array_t& cols)
+     {
+	  const e2m::size_t N = m.cols();
+	  const auto kept = kept_flags(N, cols, "remove_cols_to_mxArray()");
+	  std::vector<const sp_matrix_t*> src;
+	  std::vector<int> src_col;
+	  for (e2m::size_t j(0) ; j < N ; ++j) {
+	       if (kept[j]) {
+		    src.push_back(&m);
+		    src_col.push_back(static_cast<int>(j));
+	       }
+	  }
+	  return columns_to_mxArray(m.rows(), src, src_col, std::vector<int>());
+     }
+
+     template <typename sp_matrix_t>
+     mxArray* insert_cols_to_mxArray_helper(const sp_matrix_t& m,
+					    const e2m::idx_array_t& pos,
+					    const sp_matrix_t& cols)
+     {
+	  check_positions(m, pos, cols, "insert_cols_to_mxArray()");
+	  const e2m::size_t N = m.cols() + cols.cols();
+	  std::vector<const sp_matrix_t*> src(N);
+	  std::vector<int> src_col(N);
+	  for (e2m::size_t j(0), c(0), q(0) ; j < N ; ++j) {
+	       if (q < pos.size() && pos[q] == j) {
+		    src[j] = &cols;
+		    src_col[j] = static_cast<int>(q++);
+	       }
+	       else {
+		    src[j] = &m;
+		    src_col[j] = static_cast<int>(c++);
+	       }
+	  }
+	  return columns_to_mxArray(m.rows(), src, src_col, std::vector<int>());
+     }
+} // namespace
+
+// =============================================================================
+
+void e2m::remove_rows(e2m::real_sp_matrix_t& m, const e2m::idx_array_t& rows)
+{
+     remove_rows_helper(m, rows);
+}
+
+void e2m::remove_rows(e2m::cmplx_sp_matrix_t& m, const e2m::idx_array_t& rows)
+{
+     remove_rows_helper(m, rows);
+}
+
+// =====================================
+
+void e2m::remove_cols(e2m::real_sp_matrix_t& m, const e2m::idx_array_t& cols)
+{
+     remove_cols_helper(m, cols);
+}
+
+void e2m::remove_cols(e2m::cmplx_sp_matrix_t& m, const e2m::idx_array_t& cols)
+{
+     remove_cols_helper(m, cols);
+}
+
+// =====================================
+
+void e2m::insert_cols(e2m::real_sp_matrix_t& m,
+		      const e2m::idx_array_t& pos,
+		      const e2m::real_sp_matrix_t& cols)
+{
+     insert_cols_helper(m, pos, cols);
+}
+
+void e2m::insert_cols(e2m::cmplx_sp_matrix_t& m,
+		      const e2m::idx_array_t& pos,
+		      const e2m::cmplx_sp_matrix_t& cols)
+{
+     insert_cols_helper(m, pos, cols);
+}
+
+// =============================================================================
+
+mxArray* e2m::remove_rows_to_mxArray(const e2m::real_sp_matrix_t& m,
+				     const e2m::idx_array_t& rows)
+{
+     return remove_rows_to_mxArray_helper(m, rows);
+}
+
+mxArray* e2m::remove_rows_to_mxArray(const e2m::cmplx_sp_matrix_t& m,
+				     const e2m::idx_array_t& rows)
+{
+     return remove_rows_to_mxArray_helper(m, rows);
+}
+
+// =====================================
+
+mxArray* e2m::remove_cols_to_mxArray(const e2m::real_sp_matrix_t& m,
+				     const e2m::idx_array_t& cols)
+{
+     return remove_cols_to_mxArray_helper(m, cols);
+}
+
+mxArray* e2m::remove_cols_to_mxArray(const e2m::cmplx_sp_matrix_t& m,
+				     const e2m::idx_array_t& cols)
+{
+     return remove_cols_to_mxArray_helper(m, cols);
+}
+
+// =====================================
+
+mxArray* e2m::insert_cols_to_mxArray(const e2m::real_sp_matrix_t& m,
+				     const e2m::idx_array_t& pos,
+				     const e2m::real_sp_matrix_t& cols)
+{
+     return insert_cols_to_mxArray_helper(m, pos, cols);
+}
+
+mxArray* e2m::insert_cols_to_mxArray(const e2m::cmplx_sp_matrix_t& m,
+				     const e2m::idx_array_t& pos,
+				     const e2m::cmplx_sp_matrix_t& cols)
+{
+     return insert_cols_to_mxArray_helper(m, pos, cols);
+}
+
+// =============================================================================
+
+CLANG_RESTORE_WARNINGS
+MSVC_RESTORE_WARNINGS
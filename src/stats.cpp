@@ -0,0 +1,276 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "eigen2mat/stats.hpp"
+#include "eigen2mat/utils/macros.hpp"
+
+#include "eigen2mat/utils/include_mex"
+
+#include <cassert>
+
+#ifdef EIGEN2MAT_STATS
+#  include <algorithm>
+#  include <atomic>
+#  include <mutex>
+#endif /* EIGEN2MAT_STATS */
+
+MSVC_IGNORE_WARNINGS(4267)
+CLANG_IGNORE_WARNINGS_TWO(-Wexit-time-destructors, -Wglobal-constructors)
+
+namespace st = eigen2mat::stats;
+
+namespace {
+     const char* const op_names[st::N_OPS] = {
+	  "mxArray_to_scalar",
+	  "mxArray_to_int_array",
+	  "mxArray_to_real_dense",
+	  "mxArray_to_cmplx_dense",
+	  "mxArray_to_real_sparse",
+	  "mxArray_to_cmplx_sparse",
+	  "mxArray_to_real_tensor",
+	  "mxArray_to_cmplx_tensor",
+	  "mxArray_to_sp_cell",
+	  "to_mxArray_scalar",
+	  "to_mxArray_int_array",
+	  "to_mxArray_real_dense",
+	  "to_mxArray_cmplx_dense",
+	  "to_mxArray_real_sparse",
+	  "to_mxArray_cmplx_sparse",
+	  "to_mxArray_real_tensor",
+	  "to_mxArray_cmplx_tensor",
+	  "to_mxArray_sp_cell",
+	  "to_mxArray_sparse_xpr",
+	  "to_mxArray_dense_to_sparse",
+	  "mex_args",
+	  "tensor_to_matrix",
+	  "tensor_slice_assign",
+	  "tensor_permute",
+	  "tensor_reduce",
+	  "page_mtimes",
+	  "page_solve",
+	  "mode_product",
+	  "sparse_slice_apply",
+	  "sparse_assemble",
+	  "dense_slice",
+	  "mask_view",
+	  "sparse_edit",
+	  "sparse_block_build",
+	  "scatter_assemble",
+	  "accumarray"
+     };
+
+#ifdef EIGEN2MAT_STATS
+     /*
+      * Each thread owns a table of counters that only it writes to. The
+      * counters are atomics so that collect() can read them at any time
+      * without locking; since there is a single writer, relaxed loads and
+      * stores are enough (no read-modify-write needed).
+      */
+     struct atomic_counters_t
+     {
+	  std::atomic<unsigned long long> calls;
+	  std::atomic<unsigned long long> bytes;
+	  std::atomic<unsigned long long> allocations;
+	  std::atomic<unsigned long long> cycles;
+     };
+
+     struct table_t
+     {
+	  table_t()
+	       {
+		    clear();
+	       }
+
+	  void clear()
+	       {
+		    for (auto i(0) ; i < st::N_OPS ; ++i) {
+			 c[i].calls.store(0, std::memory_order_relaxed);
+			 c[i].bytes.store(0, std::memory_order_relaxed);
+			 c[i].allocations.store(0, std::memory_order_relaxed);
+			 c[i].cycles.store(0, std::memory_order_relaxed);
+		    }
+	       }
+
+	  void add_to(std::vector<st::counters_t>& out) const
+	       {
+		    for (auto i(0) ; i < st::N_OPS ; ++i) {
+			 out[i].calls += c[i].calls.load(std::memory_order_relaxed);
+			 out[i].bytes += c[i].bytes.load(std::memory_order_relaxed);
+			 out[i].allocations += c[i].allocations.load(std::memory_order_relaxed);
+			 out[i].cycles += c[i].cycles.load(std::memory_order_relaxed);
+		    }
+	       }
+
+	  atomic_counters_t c[st::N_OPS];
+     };
+
+     struct registry_t
+     {
+	  registry_t() : mutex(), tables(), retired(st::N_OPS) {}
+
+	  std::mutex mutex;
+	  std::vector<table_t*> tables;          // tables of the running threads
+	  std::vector<st::counters_t> retired;   // counters of terminated threads
+     };
+
+     // Never destroyed on purpose: threads may exit after static destructors
+     registry_t& registry()
+     {
+	  static registry_t* r = new registry_t;
+	  return *r;
+     }
+
+     struct thread_table_t
+     {
+	  thread_table_t()
+	       : table()
+	       {
+		    auto& reg = registry();
+		    std::lock_guard<std::mutex> lock(reg.mutex);
+		    reg.tables.push_back(&table);
+	       }
+	  ~thread_table_t()
+	       {
+		    auto& reg = registry();
+		    std::lock_guard<std::mutex> lock(reg.mutex);
+		    table.add_to(reg.retired);
+		    reg.tables.erase(std::find(reg.tables.begin(),
+					       reg.tables.end(),
+					       &table));
+	       }
+
+	  table_t table;
+     };
+
+     table_t& local_table()
+     {
+	  thread_local thread_table_t t;
+	  return t.table;
+     }
+
+     inline void add_relaxed(std::atomic<unsigned long long>& a,
+			     unsigned long long v)
+     {
+	  a.store(a.load(std::memory_order_relaxed) + v,
+		  std::memory_order_relaxed);
+     }
+#endif /* EIGEN2MAT_STATS */
+} // namespace
+
+// =============================================================================
+
+const char* st::op_name(st::op_t op)
+{
+     return (op >= 0 && op < N_OPS) ? op_names[op] : "unknown";
+}
+
+// =====================================
+
+bool st::enabled()
+{
+#ifdef EIGEN2MAT_STATS
+     return true;
+#else
+     return false;
+#endif /* EIGEN2MAT_STATS */
+}
+
+// =====================================
+
+#ifdef EIGEN2MAT_STATS
+void st::record(st::op_t op,
+		unsigned long long bytes,
+		unsigned long long allocations,
+		unsigned long long cycles)
+{
+     auto& c = local_table().c[op];
+     add_relaxed(c.calls, 1);
+     add_relaxed(c.bytes, bytes);
+     add_relaxed(c.allocations, allocations);
+     add_relaxed(c.cycles, cycles);
+}
+#else
+void st::record(st::op_t,
+		unsigned long long,
+		unsigned long long,
+		unsigned long long)
+{}
+#endif /* EIGEN2MAT_STATS */
+
+// =====================================
+
+std::vector<st::counters_t> st::collect()
+{
+     std::vector<counters_t> ret(N_OPS);
+#ifdef EIGEN2MAT_STATS
+     auto& reg = registry();
+     std::lock_guard<std::mutex> lock(reg.mutex);
+     ret = reg.retired;
+     for (auto i(0UL) ; i < reg.tables.size() ; ++i) {
+	  reg.tables[i]->add_to(ret);
+     }
+#endif /* EIGEN2MAT_STATS */
+     return ret;
+}
+
+// =====================================
+
+void st::reset()
+{
+#ifdef EIGEN2MAT_STATS
+     auto& reg = registry();
+     std::lock_guard<std::mutex> lock(reg.mutex);
+     reg.retired.assign(N_OPS, counters_t());
+     for (auto i(0UL) ; i < reg.tables.size() ; ++i) {
+	  reg.tables[i]->clear();
+     }
+#endif /* EIGEN2MAT_STATS */
+}
+
+// =====================================
+
+mxArray* st::to_mxArray()
+{
+     const char* fields[] = {"enabled", "name", "calls",
+			     "bytes", "allocations", "cycles"};
+     auto ret = mxCreateStructMatrix(1, 1, 6, fields);
+     e2m_assert(ret);
+
+     const auto counters = collect();
+
+     auto enabled_flag = mxCreateLogicalMatrix(1, 1);
+     *mxGetLogicals(enabled_flag) = enabled();
+
+     auto names = mxCreateCellMatrix(N_OPS, 1);
+     auto calls = mxCreateDoubleMatrix(N_OPS, 1, mxREAL);
+     auto bytes = mxCreateDoubleMatrix(N_OPS, 1, mxREAL);
+     auto allocations = mxCreateDoubleMatrix(N_OPS, 1, mxREAL);
+     auto cycles = mxCreateDoubleMatrix(N_OPS, 1, mxREAL);
+
+     for (auto i(0) ; i < N_OPS ; ++i) {
+	  mxSetCell(names, i, mxCreateString(op_names[i]));
+	  mxGetPr(calls)[i] = static_cast<double>(counters[i].calls);
+	  mxGetPr(bytes)[i] = static_cast<double>(counters[i].bytes);
+	  mxGetPr(allocations)[i] = static_cast<double>(counters[i].allocations);
+	  mxGetPr(cycles)[i] = static_cast<double>(counters[i].cycles);
+     }
+
+     mxSetField(ret, 0, "enabled", enabled_flag);
+     mxSetField(ret, 0, "name", names);
+     mxSetField(ret, 0, "calls", calls);
+     mxSetField(ret, 0, "bytes", bytes);
+     mxSetField(ret, 0, "allocations", allocations);
+     mxSetField(ret, 0, "cycles", cycles);
+     return ret;
+}
+
+// =============================================================================
+
+CLANG_RESTORE_WARNINGS
+MSVC_RESTORE_WARNINGS
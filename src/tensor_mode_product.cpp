@@ -0,0 +1,281 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "eigen2mat/tensor_mode_product.hpp"
+#include "eigen2mat/details/op_scope.hpp"
+#include "eigen2mat/utils/macros.hpp"
+#include "eigen2mat/utils/parallel.hpp"
+
+#include "eigen2mat/utils/include_mex"
+
+#include <algorithm>
+#include <cassert>
+
+namespace e2m = eigen2mat;
+
+CLANG_IGNORE_WARNINGS_ONE(-Wsign-conversion)
+
+namespace {
+     // Products with fewer flops are computed serially
+     const e2m::size_t mode_product_parallel_threshold = 65536;
+
+     // Number of elements of the panels used for Z products (~256KB)
+     const e2m::size_t mode_product_panel_size = 32768;
+
+     // Writes pages (or panels of rows of all pages) of the result into a tensor
+     template <typename matrix_t>
+     struct tensor_sink_t
+     {
+	  typedef typename matrix_t::Scalar Scalar;
+
+	  tensor_sink_t(std::vector<matrix_t>& t, e2m::size_t rows, e2m::size_t cols)
+	       : t_(t)
+	       {
+		    for (auto k(0UL) ; k < t_.size() ; ++k) {
+			 t_[k].resize(rows, cols);
+		    }
+	       }
+
+	  template <typename xpr_t>
+	  void page(e2m::size_t k, const xpr_t& xpr) const
+	       {
+		    t_[k].noalias() = xpr;
+	       }
+
+	  // panel(:, j) holds elements [row, row + panel.rows()) of page j
+	  template <typename panel_t>
+	  void panel(e2m::size_t row, const panel_t& panel) const
+	       {
+		    for (auto j(0L) ; j < panel.cols() ; ++j) {
+			 Eigen::Map<Eigen::Matrix<Scalar, Eigen::Dynamic, 1> >(
+			      t_[j].data() + row, panel.rows()) = panel.col(j);
+		    }
+	       }
+
+	  std::vector<matrix_t>& t_;
+     };
+
+     // Writes pages (or panels of rows of all pages) of the result into a real mxArray
+     struct mx_real_sink_t
+     {
+	  mx_real_sink_t(double* pr, e2m::size_t rows, e2m::size_t cols)
+	       : pr_(pr), rows_(rows), cols_(cols) {}
+
+	  template <typename xpr_t>
+	  void page(e2m::size_t k, const xpr_t& xpr) const
+	       {
+		    e2m::real_map_mat_t(pr_ + k * rows_ * cols_, rows_, cols_).noalias() = xpr;
+	       }
+
+	  template <typename panel_t>
+	  void panel(e2m::size_t row, const panel_t& panel) const
+	       {
+		    for (auto j(0L) ; j < panel.cols() ; ++j) {
+			 e2m::real_map_vec_t(pr_ + j * rows_ * cols_ + row,
+					     panel.rows()) = panel.col(j);
+		    }
+	       }
+
+	  double* pr_;
+	  e2m::size_t rows_;
+	  e2m::size_t cols_;
+     };
+
+     // Writes pages (or panels of rows of all pages) of the result into a complex mxArray
+     struct mx_cmplx_sink_t
+     {
+	  mx_cmplx_sink_t(double* pr, double* pi, e2m::size_t rows, e2m::size_t cols)
+	       : pr_(pr), pi_(pi), rows_(rows), cols_(cols) {}
+
+	  template <typename xpr_t>
+	  void page(e2m::size_t k, const xpr_t& xpr) const
+	       {
+		    const e2m::cmplx_matrix_t tmp = xpr;
+		    const auto offset = k * rows_ * cols_;
+		    e2m::real_map_mat_t(pr_ + offset, rows_, cols_) = tmp.real();
+		    e2m::real_map_mat_t(pi_ + offset, rows_, cols_) = tmp.imag();
+	       }
+
+	  template <typename panel_t>
+	  void panel(e2m::size_t row, const panel_t& panel) const
+	       {
+		    for (auto j(0L) ; j < panel.cols() ; ++j) {
+			 const auto offset = j * rows_ * cols_ + row;
+			 e2m::real_map_vec_t(pr_ + offset, panel.rows()) = panel.col(j).real();
+			 e2m::real_map_vec_t(pi_ + offset, panel.rows()) = panel.col(j).imag();
+		    }
+	       }
+
+	  double* pr_;
+	  double* pi_;
+	  e2m::size_t rows_;
+	  e2m::size_t cols_;
+     };
+
+     template <typename matrix_t>
+     e2m::dim_array_t mode_product_dimensions(const std::vector<matrix_t>& t,
+					      const matrix_t& u,
+					      e2m::DIR_T dim)
+     {
+	  const e2m::size_t P = t.size();
+	  e2m::dim_array_t dims = {{P == 0 ? 0 : e2m::size_t(t[0].rows()),
+				    P == 0 ? 0 : e2m::size_t(t[0].cols()),
+				    P}};
+	  const auto n = dim == e2m::X ? 0 : dim == e2m::Y ? 1 : 2;
+	  if (P > 0 && e2m::size_t(u.cols()) != dims[n]) {
+	       mexErrMsgIdAndTxt("eigen2mat:invalid_argument",
+				 "mode_product: u has %d columns but dimension %d "
+				 "of the tensor is %d",
+				 int(u.cols()), n + 1, int(dims[n]));
+	  }
+	  if (P > 0) {
+	       dims[n] = u.rows();
+	  }
+	  return dims;
+     }
+
+     template <typename matrix_t, typename sink_t>
+     void mode_product_helper(const std::vector<matrix_t>& t,
+			      const matrix_t& u,
+			      e2m::DIR_T dim,
+			      const sink_t& sink)
+     {
+	  typedef e2m::internal::par_index_t par_index_t;
+
+	  const e2m::size_t P = t.size();
+
+	  if (P == 0) {
+	       return;
+	  }
+
+	  const e2m::size_t M = t[0].rows();
+	  const e2m::size_t N = t[0].cols();
+	  const e2m::size_t J = u.rows();
+	  const bool serial = M * N * P * J < mode_product_parallel_threshold;
+
+	  if (dim == e2m::X || dim == e2m::Y) {
+	       e2m::internal::parallel_for(
+		    0, P,
+		    [&](par_index_t k) {
+			 if (dim == e2m::X) {
+			      sink.page(k, u * t[k]);
+			 }
+			 else {
+			      sink.page(k, t[k] * u.transpose());
+			 }
+		    },
+		    serial ? P + 1 : 2);
+	       return;
+	  }
+
+	  // Z: result(:, j) = sum_k u(j, k) t(:, k) on the vectorised pages,
+	  // ie. one product (rows of the pages) x P by P x J per panel of rows
+	  const e2m::size_t S = M * N;
+	  const e2m::size_t len = std::max<e2m::size_t>(
+	       16, mode_product_panel_size / (P + J));
+	  const e2m::size_t n_panels = (S + len - 1) / len;
+	  const auto n_chunks = serial ? 1 : e2m::internal::num_chunks(n_panels, 1);
+
+	  e2m::internal::parallel_for(
+	       0, n_chunks,
+	       [&](par_index_t c) {
+		    par_index_t first(0), last(0);
+		    e2m::internal::chunk_range(n_panels, n_chunks, c, first, last);
+		    matrix_t in(len, P), out(len, J);
+		    for (auto p(first) ; p < last ; ++p) {
+			 const e2m::size_t row = p * len;
+			 const e2m::size_t n = std::min(len, S - row);
+			 for (auto k(0UL) ; k < P ; ++k) {
+			      in.col(k).head(n) = Eigen::Map<const Eigen::Matrix<
+				   typename matrix_t::Scalar, Eigen::Dynamic, 1> >(
+					t[k].data() + row, n);
+			 }
+			 out.topRows(n).noalias() = in.topRows(n) * u.transpose();
+			 sink.panel(row, out.topRows(n));
+		    }
+	       });
+     }
+
+     template <typename matrix_t>
+     std::vector<matrix_t> mode_product_tensor_helper(const std::vector<matrix_t>& t,
+						      const matrix_t& u,
+						      e2m::DIR_T dim)
+     {
+	  const auto dims = mode_product_dimensions(t, u, dim);
+	  E2M_OP_SCOPE(MODE_PRODUCT,
+		       dims[0] * dims[1] * dims[2] * sizeof(typename matrix_t::Scalar),
+		       dims[2]);
+
+	  std::vector<matrix_t> ret(dims[2]);
+	  mode_product_helper(t, u, dim,
+			      tensor_sink_t<matrix_t>(ret, dims[0], dims[1]));
+	  return ret;
+     }
+} // namespace
+
+// =============================================================================
+
+e2m::real_tensor_t e2m::mode_product(const e2m::real_tensor_t& t,
+				     const e2m::real_matrix_t& u,
+				     e2m::DIR_T dim)
+{
+     return mode_product_tensor_helper(t, u, dim);
+}
+
+// =====================================
+
+e2m::cmplx_tensor_t e2m::mode_product(const e2m::cmplx_tensor_t& t,
+				      const e2m::cmplx_matrix_t& u,
+				      e2m::DIR_T dim)
+{
+     return mode_product_tensor_helper(t, u, dim);
+}
+
+// =====================================
+
+mxArray* e2m::mode_product_to_mxArray(const e2m::real_tensor_t& t,
+				      const e2m::real_matrix_t& u,
+				      e2m::DIR_T dim)
+{
+     const auto dims = mode_product_dimensions(t, u, dim);
+     E2M_OP_SCOPE(MODE_PRODUCT, dims[0] * dims[1] * dims[2] * sizeof(double), 1);
+
+     auto ret = mxCreateNumericArray(dims.size(),
+				     dims.data(),
+				     mxDOUBLE_CLASS,
+				     mxREAL);
+     e2m_assert(ret);
+
+     mode_product_helper(t, u, dim, mx_real_sink_t(mxGetPr(ret), dims[0], dims[1]));
+     return ret;
+}
+
+// =====================================
+
+mxArray* e2m::mode_product_to_mxArray(const e2m::cmplx_tensor_t& t,
+				      const e2m::cmplx_matrix_t& u,
+				      e2m::DIR_T dim)
+{
+     const auto dims = mode_product_dimensions(t, u, dim);
+     E2M_OP_SCOPE(MODE_PRODUCT, dims[0] * dims[1] * dims[2] * sizeof(dcomplex), 1);
+
+     auto ret = mxCreateNumericArray(dims.size(),
+				     dims.data(),
+				     mxDOUBLE_CLASS,
+				     mxCOMPLEX);
+     e2m_assert(ret);
+
+     mode_product_helper(t, u, dim,
+			 mx_cmplx_sink_t(mxGetPr(ret), mxGetPi(ret), dims[0], dims[1]));
+     return ret;
+}
+
+// =============================================================================
+
+CLANG_RESTORE_WARNINGS
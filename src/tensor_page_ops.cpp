@@ -0,0 +1,566 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "eigen2mat/tensor_page_ops.hpp"
+#include "eigen2mat/details/op_scope.hpp"
+#include "eigen2mat/utils/macros.hpp"
+#include "eigen2mat/utils/parallel.hpp"
+
+#include "eigen2mat/utils/include_mex"
+#include "eigen2mat/utils/Eigen_LU"
+
+#include <cassert>
+
+namespace e2m = eigen2mat;
+
+CLANG_IGNORE_WARNINGS_ONE(-Wsign-conversion)
+
+namespace {
+     // Batches with fewer flops are processed serially
+     const e2m::size_t page_ops_parallel_threshold = 65536;
+
+     /*
+      * Operand of a page-wise operation: either a range of pages or a single
+      * matrix (n == 1) used for every page.
+      */
+     template <typename matrix_t>
+     struct operand_t
+     {
+	  operand_t(const matrix_t* first, e2m::size_t n) : pages(first), size(n) {}
+
+	  const matrix_t& operator[](e2m::size_t k) const
+	       {
+		    return pages[size == 1 ? 0 : k];
+	       }
+	  e2m::size_t rows() const {return pages[0].rows();}
+	  e2m::size_t cols() const {return pages[0].cols();}
+
+	  const matrix_t* pages;
+	  e2m::size_t size;
+     };
+
+     template <typename matrix_t>
+     operand_t<matrix_t> make_operand(const std::vector<matrix_t>& t)
+     {
+	  return operand_t<matrix_t>(t.data(), t.size());
+     }
+     template <typename tensor_t>
+     operand_t<typename tensor_t::value_type>
+     make_operand(const e2m::tensor_block_t<tensor_t>& b)
+     {
+	  return operand_t<typename tensor_t::value_type>(
+	       b.empty() ? nullptr : &*b.begin(), b.size());
+     }
+     template <typename matrix_t>
+     operand_t<matrix_t> make_operand(const matrix_t& m)
+     {
+	  return operand_t<matrix_t>(&m, 1);
+     }
+
+     // Number of pages of the result; raises an error if they do not match
+     template <typename matrix_t>
+     e2m::size_t result_pages(const operand_t<matrix_t>& a,
+			      const operand_t<matrix_t>& b,
+			      const char* fname)
+     {
+	  if (a.size != b.size && a.size != 1 && b.size != 1) {
+	       mexErrMsgIdAndTxt("eigen2mat:invalid_argument",
+				 "%s: number of pages do not match (%d vs %d)",
+				 fname, int(a.size), int(b.size));
+	  }
+	  return (a.size == 0 || b.size == 0) ? 0 : std::max(a.size, b.size);
+     }
+
+     // True if a page of the result is also a page of one of the operands
+     template <typename matrix_t>
+     bool aliases(const matrix_t& out, const matrix_t& a, const matrix_t& b)
+     {
+	  return &out == &a || &out == &b;
+     }
+
+     // =====================================
+
+     template <typename dst_t, typename lhs_t, typename rhs_t>
+     void product(const lhs_t& a, const rhs_t& b, e2m::TRANSPOSE_T tb, dst_t&& dst)
+     {
+	  if (tb == e2m::TRANSPOSE) {
+	       dst.noalias() = a * b.transpose();
+	  }
+	  else if (tb == e2m::CTRANSPOSE) {
+	       dst.noalias() = a * b.adjoint();
+	  }
+	  else {
+	       dst.noalias() = a * b;
+	  }
+     }
+
+     template <typename dst_t, typename lhs_t, typename rhs_t>
+     void product(const lhs_t& a, e2m::TRANSPOSE_T ta,
+		  const rhs_t& b, e2m::TRANSPOSE_T tb,
+		  dst_t&& dst)
+     {
+	  if (ta == e2m::TRANSPOSE) {
+	       product(a.transpose(), b, tb, dst);
+	  }
+	  else if (ta == e2m::CTRANSPOSE) {
+	       product(a.adjoint(), b, tb, dst);
+	  }
+	  else {
+	       product(a, b, tb, dst);
+	  }
+     }
+
+     // Product of square pages of size S, with all sizes known at compile-time
+     template <int S, typename matrix_t>
+     void fixed_mtimes(const operand_t<matrix_t>& a, e2m::TRANSPOSE_T ta,
+		       const operand_t<matrix_t>& b, e2m::TRANSPOSE_T tb,
+		       matrix_t* out, e2m::internal::par_index_t P,
+		       e2m::internal::par_index_t min_size)
+     {
+	  typedef Eigen::Matrix<typename matrix_t::Scalar, S, S> fixed_t;
+	  e2m::internal::parallel_for(
+	       0, P,
+	       [&](e2m::internal::par_index_t k) {
+		    // the result is small enough to always go through a copy
+		    fixed_t tmp;
+		    product(Eigen::Map<const fixed_t>(a[k].data()), ta,
+			    Eigen::Map<const fixed_t>(b[k].data()), tb,
+			    tmp);
+		    out[k].resize(S, S);
+		    Eigen::Map<fixed_t>(out[k].data()) = tmp;
+	       },
+	       min_size);
+     }
+
+     template <typename matrix_t>
+     void page_mtimes_helper(const operand_t<matrix_t>& a, e2m::TRANSPOSE_T ta,
+			     const operand_t<matrix_t>& b, e2m::TRANSPOSE_T tb,
+			     matrix_t* out, e2m::size_t P)
+     {
+	  if (P == 0) {
+	       return;
+	  }
+
+	  const e2m::size_t M = ta == e2m::NO_TRANSPOSE ? a.rows() : a.cols();
+	  const e2m::size_t K = ta == e2m::NO_TRANSPOSE ? a.cols() : a.rows();
+	  const e2m::size_t K_b = tb == e2m::NO_TRANSPOSE ? b.rows() : b.cols();
+	  const e2m::size_t N = tb == e2m::NO_TRANSPOSE ? b.cols() : b.rows();
+	  if (K != K_b) {
+	       mexErrMsgIdAndTxt("eigen2mat:invalid_argument",
+				 "page_mtimes: inner dimensions do not match (%d vs %d)",
+				 int(K), int(K_b));
+	  }
+	  E2M_OP_SCOPE(PAGE_MTIMES, M * N * P * sizeof(typename matrix_t::Scalar), P);
+
+	  const e2m::internal::par_index_t min_size =
+	       M * N * K * P < page_ops_parallel_threshold ? P + 1 : 2;
+
+	  if (M == K && K == N && M >= 2 && M <= 4) {
+	       switch (M) {
+	       case 2: fixed_mtimes<2>(a, ta, b, tb, out, P, min_size); return;
+	       case 3: fixed_mtimes<3>(a, ta, b, tb, out, P, min_size); return;
+	       case 4: fixed_mtimes<4>(a, ta, b, tb, out, P, min_size); return;
+	       }
+	  }
+
+	  e2m::internal::parallel_for(
+	       0, P,
+	       [&](e2m::internal::par_index_t k) {
+		    if (aliases(out[k], a[k], b[k])) {
+			 matrix_t tmp(M, N);
+			 product(a[k], ta, b[k], tb, tmp);
+			 out[k].swap(tmp);
+		    }
+		    else {
+			 out[k].resize(M, N);
+			 product(a[k], ta, b[k], tb, out[k]);
+		    }
+	       },
+	       min_size);
+     }
+
+     // =====================================
+
+     // Solve with square pages of size S, with all sizes known at compile-time
+     template <int S, typename matrix_t>
+     void fixed_solve(const operand_t<matrix_t>& a,
+		      const operand_t<matrix_t>& b,
+		      matrix_t* out, e2m::internal::par_index_t P,
+		      e2m::internal::par_index_t min_size)
+     {
+	  typedef Eigen::Matrix<typename matrix_t::Scalar, S, S> fixed_t;
+	  typedef Eigen::Matrix<typename matrix_t::Scalar, S, Eigen::Dynamic> rhs_t;
+	  const auto N = b.cols();
+	  e2m::internal::parallel_for(
+	       0, P,
+	       [&](e2m::internal::par_index_t k) {
+		    const Eigen::PartialPivLU<fixed_t> lu(
+			 fixed_t(Eigen::Map<const fixed_t>(a[k].data())));
+		    if (aliases(out[k], a[k], b[k])) {
+			 matrix_t tmp = lu.solve(b[k]);
+			 out[k].swap(tmp);
+		    }
+		    else {
+			 out[k].resize(S, N);
+			 Eigen::Map<rhs_t>(out[k].data(), S, N) =
+			      lu.solve(Eigen::Map<const rhs_t>(b[k].data(), S, N));
+		    }
+	       },
+	       min_size);
+     }
+
+     template <typename matrix_t>
+     void page_solve_helper(const operand_t<matrix_t>& a,
+			    const operand_t<matrix_t>& b,
+			    matrix_t* out, e2m::size_t P)
+     {
+	  if (P == 0) {
+	       return;
+	  }
+
+	  const e2m::size_t M = a.rows();
+	  const e2m::size_t N = b.cols();
+	  if (a.cols() != M || b.rows() != M) {
+	       mexErrMsgIdAndTxt("eigen2mat:invalid_argument",
+				 "page_solve: pages of a must be square and have "
+				 "as many rows as pages of b (%dx%d vs %dx%d)",
+				 int(a.rows()), int(a.cols()),
+				 int(b.rows()), int(b.cols()));
+	  }
+	  E2M_OP_SCOPE(PAGE_SOLVE, M * N * P * sizeof(typename matrix_t::Scalar), P);
+
+	  const e2m::internal::par_index_t min_size =
+	       M * M * (M + N) * P < page_ops_parallel_threshold ? P + 1 : 2;
+
+	  if (a.size == 1) {
+	       // same matrix for every page: factorise it once
+	       const Eigen::PartialPivLU<matrix_t> lu(a[0]);
+	       e2m::internal::parallel_for(
+		    0, P,
+		    [&](e2m::internal::par_index_t k) {
+			 if (aliases(out[k], a[0], b[k])) {
+			      matrix_t tmp = lu.solve(b[k]);
+			      out[k].swap(tmp);
+			 }
+			 else {
+			      out[k] = lu.solve(b[k]);
+			 }
+		    },
+		    min_size);
+	       return;
+	  }
+
+	  switch (M) {
+	  case 2: fixed_solve<2>(a, b, out, P, min_size); return;
+	  case 3: fixed_solve<3>(a, b, out, P, min_size); return;
+	  case 4: fixed_solve<4>(a, b, out, P, min_size); return;
+	  }
+
+	  e2m::internal::parallel_for(
+	       0, P,
+	       [&](e2m::internal::par_index_t k) {
+		    if (aliases(out[k], a[k], b[k])) {
+			 matrix_t tmp = a[k].partialPivLu().solve(b[k]);
+			 out[k].swap(tmp);
+		    }
+		    else {
+			 out[k] = a[k].partialPivLu().solve(b[k]);
+		    }
+	       },
+	       min_size);
+     }
+
+     // =====================================
+
+     template <typename matrix_t, typename lhs_t, typename rhs_t>
+     std::vector<matrix_t> page_mtimes_tensor(const lhs_t& a, const rhs_t& b,
+					      e2m::TRANSPOSE_T ta,
+					      e2m::TRANSPOSE_T tb)
+     {
+	  const auto op_a = make_operand(a);
+	  const auto op_b = make_operand(b);
+	  std::vector<matrix_t> ret(result_pages(op_a, op_b, "page_mtimes"));
+	  page_mtimes_helper(op_a, ta, op_b, tb, ret.data(), ret.size());
+	  return ret;
+     }
+
+     template <typename tensor_t, typename lhs_t, typename rhs_t>
+     void page_mtimes_block(const lhs_t& a, const rhs_t& b,
+			    e2m::tensor_block_t<tensor_t>& out,
+			    e2m::TRANSPOSE_T ta,
+			    e2m::TRANSPOSE_T tb)
+     {
+	  const auto op_a = make_operand(a);
+	  const auto op_b = make_operand(b);
+	  const auto P = result_pages(op_a, op_b, "page_mtimes");
+	  if (out.size() != P) {
+	       mexErrMsgIdAndTxt("eigen2mat:invalid_argument",
+				 "page_mtimes: output has %d pages instead of %d",
+				 int(out.size()), int(P));
+	  }
+	  page_mtimes_helper(op_a, ta, op_b, tb, P == 0 ? nullptr : &*out.begin(), P);
+     }
+
+     template <typename matrix_t, typename lhs_t, typename rhs_t>
+     std::vector<matrix_t> page_solve_tensor(const lhs_t& a, const rhs_t& b)
+     {
+	  const auto op_a = make_operand(a);
+	  const auto op_b = make_operand(b);
+	  std::vector<matrix_t> ret(result_pages(op_a, op_b, "page_solve"));
+	  page_solve_helper(op_a, op_b, ret.data(), ret.size());
+	  return ret;
+     }
+
+     template <typename tensor_t, typename lhs_t, typename rhs_t>
+     void page_solve_block(const lhs_t& a, const rhs_t& b,
+			   e2m::tensor_block_t<tensor_t>& out)
+     {
+	  const auto op_a = make_operand(a);
+	  const auto op_b = make_operand(b);
+	  const auto P = result_pages(op_a, op_b, "page_solve");
+	  if (out.size() != P) {
+	       mexErrMsgIdAndTxt("eigen2mat:invalid_argument",
+				 "page_solve: output has %d pages instead of %d",
+				 int(out.size()), int(P));
+	  }
+	  page_solve_helper(op_a, op_b, P == 0 ? nullptr : &*out.begin(), P);
+     }
+} // namespace
+
+// =============================================================================
+
+e2m::real_tensor_t e2m::page_mtimes(const e2m::real_tensor_t& a,
+				    const e2m::real_tensor_t& b,
+				    e2m::TRANSPOSE_T ta,
+				    e2m::TRANSPOSE_T tb)
+{
+     return page_mtimes_tensor<real_matrix_t>(a, b, ta, tb);
+}
+
+// =====================================
+
+e2m::real_tensor_t e2m::page_mtimes(const e2m::real_tensor_t& a,
+				    const e2m::real_matrix_t& b,
+				    e2m::TRANSPOSE_T ta,
+				    e2m::TRANSPOSE_T tb)
+{
+     return page_mtimes_tensor<real_matrix_t>(a, b, ta, tb);
+}
+
+// =====================================
+
+e2m::real_tensor_t e2m::page_mtimes(const e2m::real_matrix_t& a,
+				    const e2m::real_tensor_t& b,
+				    e2m::TRANSPOSE_T ta,
+				    e2m::TRANSPOSE_T tb)
+{
+     return page_mtimes_tensor<real_matrix_t>(a, b, ta, tb);
+}
+
+// =====================================
+
+e2m::cmplx_tensor_t e2m::page_mtimes(const e2m::cmplx_tensor_t& a,
+				     const e2m::cmplx_tensor_t& b,
+				     e2m::TRANSPOSE_T ta,
+				     e2m::TRANSPOSE_T tb)
+{
+     return page_mtimes_tensor<cmplx_matrix_t>(a, b, ta, tb);
+}
+
+// =====================================
+
+e2m::cmplx_tensor_t e2m::page_mtimes(const e2m::cmplx_tensor_t& a,
+				     const e2m::cmplx_matrix_t& b,
+				     e2m::TRANSPOSE_T ta,
+				     e2m::TRANSPOSE_T tb)
+{
+     return page_mtimes_tensor<cmplx_matrix_t>(a, b, ta, tb);
+}
+
+// =====================================
+
+e2m::cmplx_tensor_t e2m::page_mtimes(const e2m::cmplx_matrix_t& a,
+				     const e2m::cmplx_tensor_t& b,
+				     e2m::TRANSPOSE_T ta,
+				     e2m::TRANSPOSE_T tb)
+{
+     return page_mtimes_tensor<cmplx_matrix_t>(a, b, ta, tb);
+}
+
+// =====================================
+
+void e2m::page_mtimes(const e2m::real_tblock_t& a,
+		      const e2m::real_tblock_t& b,
+		      e2m::real_tblock_t& out,
+		      e2m::TRANSPOSE_T ta,
+		      e2m::TRANSPOSE_T tb)
+{
+     page_mtimes_block(a, b, out, ta, tb);
+}
+
+// =====================================
+
+void e2m::page_mtimes(const e2m::real_tblock_t& a,
+		      const e2m::real_matrix_t& b,
+		      e2m::real_tblock_t& out,
+		      e2m::TRANSPOSE_T ta,
+		      e2m::TRANSPOSE_T tb)
+{
+     page_mtimes_block(a, b, out, ta, tb);
+}
+
+// =====================================
+
+void e2m::page_mtimes(const e2m::real_matrix_t& a,
+		      const e2m::real_tblock_t& b,
+		      e2m::real_tblock_t& out,
+		      e2m::TRANSPOSE_T ta,
+		      e2m::TRANSPOSE_T tb)
+{
+     page_mtimes_block(a, b, out, ta, tb);
+}
+
+// =====================================
+
+void e2m::page_mtimes(const e2m::cmplx_tblock_t& a,
+		      const e2m::cmplx_tblock_t& b,
+		      e2m::cmplx_tblock_t& out,
+		      e2m::TRANSPOSE_T ta,
+		      e2m::TRANSPOSE_T tb)
+{
+     page_mtimes_block(a, b, out, ta, tb);
+}
+
+// =====================================
+
+void e2m::page_mtimes(const e2m::cmplx_tblock_t& a,
+		      const e2m::cmplx_matrix_t& b,
+		      e2m::cmplx_tblock_t& out,
+		      e2m::TRANSPOSE_T ta,
+		      e2m::TRANSPOSE_T tb)
+{
+     page_mtimes_block(a, b, out, ta, tb);
+}
+
+// =====================================
+
+void e2m::page_mtimes(const e2m::cmplx_matrix_t& a,
+		      const e2m::cmplx_tblock_t& b,
+		      e2m::cmplx_tblock_t& out,
+		      e2m::TRANSPOSE_T ta,
+		      e2m::TRANSPOSE_T tb)
+{
+     page_mtimes_block(a, b, out, ta, tb);
+}
+
+// =============================================================================
+
+e2m::real_tensor_t e2m::page_solve(const e2m::real_tensor_t& a,
+				   const e2m::real_tensor_t& b)
+{
+     return page_solve_tensor<real_matrix_t>(a, b);
+}
+
+// =====================================
+
+e2m::real_tensor_t e2m::page_solve(const e2m::real_tensor_t& a,
+				   const e2m::real_matrix_t& b)
+{
+     return page_solve_tensor<real_matrix_t>(a, b);
+}
+
+// =====================================
+
+e2m::real_tensor_t e2m::page_solve(const e2m::real_matrix_t& a,
+				   const e2m::real_tensor_t& b)
+{
+     return page_solve_tensor<real_matrix_t>(a, b);
+}
+
+// =====================================
+
+e2m::cmplx_tensor_t e2m::page_solve(const e2m::cmplx_tensor_t& a,
+				    const e2m::cmplx_tensor_t& b)
+{
+     return page_solve_tensor<cmplx_matrix_t>(a, b);
+}
+
+// =====================================
+
+e2m::cmplx_tensor_t e2m::page_solve(const e2m::cmplx_tensor_t& a,
+				    const e2m::cmplx_matrix_t& b)
+{
+     return page_solve_tensor<cmplx_matrix_t>(a, b);
+}
+
+// =====================================
+
+e2m::cmplx_tensor_t e2m::page_solve(const e2m::cmplx_matrix_t& a,
+				    const e2m::cmplx_tensor_t& b)
+{
+     return page_solve_tensor<cmplx_matrix_t>(a, b);
+}
+
+// =====================================
+
+void e2m::page_solve(const e2m::real_tblock_t& a,
+		     const e2m::real_tblock_t& b,
+		     e2m::real_tblock_t& out)
+{
+     page_solve_block(a, b, out);
+}
+
+// =====================================
+
+void e2m::page_solve(const e2m::real_tblock_t& a,
+		     const e2m::real_matrix_t& b,
+		     e2m::real_tblock_t& out)
+{
+     page_solve_block(a, b, out);
+}
+
+// =====================================
+
+void e2m::page_solve(const e2m::real_matrix_t& a,
+		     const e2m::real_tblock_t& b,
+		     e2m::real_tblock_t& out)
+{
+     page_solve_block(a, b, out);
+}
+
+// =====================================
+
+void e2m::page_solve(const e2m::cmplx_tblock_t& a,
+		     const e2m::cmplx_tblock_t& b,
+		     e2m::cmplx_tblock_t& out)
+{
+     page_solve_block(a, b, out);
+}
+
+// =====================================
+
+void e2m::page_solve(const e2m::cmplx_tblock_t& a,
+		     const e2m::cmplx_matrix_t& b,
+		     e2m::cmplx_tblock_t& out)
+{
+     page_solve_block(a, b, out);
+}
+
+// =====================================
+
+void e2m::page_solve(const e2m::cmplx_matrix_t& a,
+		     const e2m::cmplx_tblock_t& b,
+		     e2m::cmplx_tblock_t& out)
+{
+     page_solve_block(a, b, out);
+}
+
+// =============================================================================
+
+CLANG_RESTORE_WARNINGS
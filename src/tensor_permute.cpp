@@ -0,0 +1,252 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "eigen2mat/tensor_permute.hpp"
+#include "eigen2mat/details/op_scope.hpp"
+#include "eigen2mat/utils/macros.hpp"
+#include "eigen2mat/utils/parallel.hpp"
+
+#include "eigen2mat/utils/include_mex"
+
+#include <algorithm>
+#include <cassert>
+
+namespace e2m = eigen2mat;
+
+CLANG_IGNORE_WARNINGS_ONE(-Wsign-conversion)
+
+namespace {
+     // Edge of the (cubic) tiles
+     const e2m::size_t permute_tile_size = 16;
+
+     // Stores element (i, j) of page q of the result into a tensor
+     template <typename matrix_t>
+     struct permute_tensor_sink_t
+     {
+	  explicit permute_tensor_sink_t(std::vector<matrix_t>& t) : t_(t) {}
+
+	  void set(e2m::size_t q, e2m::size_t i, e2m::size_t j,
+		   const typename matrix_t::Scalar& v) const
+	       {
+		    t_[q](i, j) = v;
+	       }
+
+	  std::vector<matrix_t>& t_;
+     };
+
+     // Stores element (i, j) of page q of the result into a real mxArray
+     struct permute_mx_real_sink_t
+     {
+	  permute_mx_real_sink_t(double* pr, e2m::size_t rows, e2m::size_t cols)
+	       : pr_(pr), rows_(rows), page_size_(rows * cols) {}
+
+	  void set(e2m::size_t q, e2m::size_t i, e2m::size_t j, double v) const
+	       {
+		    pr_[q * page_size_ + j * rows_ + i] = v;
+	       }
+
+	  double* pr_;
+	  e2m::size_t rows_;
+	  e2m::size_t page_size_;
+     };
+
+     // Stores element (i, j) of page q of the result into a complex mxArray
+     struct permute_mx_cmplx_sink_t
+     {
+	  permute_mx_cmplx_sink_t(double* pr, double* pi,
+				  e2m::size_t rows, e2m::size_t cols)
+	       : pr_(pr), pi_(pi), rows_(rows), page_size_(rows * cols) {}
+
+	  void set(e2m::size_t q, e2m::size_t i, e2m::size_t j,
+		   const e2m::dcomplex& v) const
+	       {
+		    const auto k = q * page_size_ + j * rows_ + i;
+		    pr_[k] = v.real();
+		    pi_[k] = v.imag();
+	       }
+
+	  double* pr_;
+	  double* pi_;
+	  e2m::size_t rows_;
+	  e2m::size_t page_size_;
+     };
+
+     void check_order(const e2m::dir_order_t& order)
+     {
+	  bool seen[3] = {false, false, false};
+	  for (auto d(0UL) ; d < order.size() ; ++d) {
+	       if (order[d] < e2m::X || order[d] > e2m::Z || seen[order[d]]) {
+		    mexErrMsgIdAndTxt("eigen2mat:invalid_argument",
+				      "permute(): order is not a permutation of {X, Y, Z}");
+	       }
+	       seen[order[d]] = true;
+	  }
+     }
+
+     template <typename matrix_t>
+     e2m::dim_array_t permuted_dimensions(const std::vector<matrix_t>& t,
+					  const e2m::dir_order_t& order)
+     {
+	  const e2m::size_t P = t.size();
+	  const e2m::dim_array_t in_dims = {{P == 0 ? 0 : e2m::size_t(t[0].rows()),
+					     P == 0 ? 0 : e2m::size_t(t[0].cols()),
+					     P}};
+	  e2m::dim_array_t out_dims;
+	  for (auto d(0UL) ; d < out_dims.size() ; ++d) {
+	       out_dims[d] = in_dims[order[d]];
+	  }
+	  return out_dims;
+     }
+
+     /*
+      * Dimension d of the result is dimension O<d> of the input.
+      *
+      * The input is traversed by cubic tiles, in its storage order inside each
+      * tile, so that the (scattered) writes of a tile stay in cache. Threads
+      * work on distinct ranges of pages of the result.
+      */
+     template <int O0, int O1, int O2, typename matrix_t, typename sink_t>
+     void permute_kernel(const std::vector<matrix_t>& t, const sink_t& sink)
+     {
+	  const e2m::size_t B = permute_tile_size;
+	  const e2m::size_t M = t[0].rows();
+	  const e2m::size_t in_dims[3] = {M, e2m::size_t(t[0].cols()), t.size()};
+	  const e2m::size_t n_tiles = (in_dims[O2] + B - 1) / B;
+
+	  e2m::internal::parallel_for(
+	       0, n_tiles,
+	       [&](e2m::internal::par_index_t tile) {
+		    // tile bounds, indexed by input dimension
+		    e2m::size_t lo[3], hi[3];
+		    lo[O2] = tile * B;
+		    hi[O2] = std::min(lo[O2] + B, in_dims[O2]);
+
+		    for (lo[O1] = 0 ; lo[O1] < in_dims[O1] ; lo[O1] += B) {
+			 hi[O1] = std::min(lo[O1] + B, in_dims[O1]);
+			 for (lo[O0] = 0 ; lo[O0] < in_dims[O0] ; lo[O0] += B) {
+			      hi[O0] = std::min(lo[O0] + B, in_dims[O0]);
+
+			      for (auto z(lo[2]) ; z < hi[2] ; ++z) {
+				   const auto* data = t[z].data();
+				   for (auto y(lo[1]) ; y < hi[1] ; ++y) {
+					const auto* col = data + y * M;
+					for (auto x(lo[0]) ; x < hi[0] ; ++x) {
+					     const e2m::size_t c[3] = {x, y, z};
+					     sink.set(c[O2], c[O0], c[O1], col[x]);
+					}
+				   }
+			      }
+			 }
+		    }
+	       });
+     }
+
+     template <typename matrix_t, typename sink_t>
+     void permute_helper(const std::vector<matrix_t>& t,
+			 const e2m::dir_order_t& order,
+			 const sink_t& sink)
+     {
+	  if (t.empty()) {
+	       return;
+	  }
+
+	  const int o = 100 * order[0] + 10 * order[1] + order[2];
+	  switch (o) {
+	  case 12:  permute_kernel<0, 1, 2>(t, sink); break;
+	  case 21:  permute_kernel<0, 2, 1>(t, sink); break;
+	  case 102: permute_kernel<1, 0, 2>(t, sink); break;
+	  case 120: permute_kernel<1, 2, 0>(t, sink); break;
+	  case 201: permute_kernel<2, 0, 1>(t, sink); break;
+	  case 210: permute_kernel<2, 1, 0>(t, sink); break;
+	  default:
+	       e2m_assert(false && "invalid order");
+	  }
+     }
+
+     template <typename matrix_t>
+     std::vector<matrix_t> permute_tensor_helper(const std::vector<matrix_t>& t,
+						 const e2m::dir_order_t& order)
+     {
+	  check_order(order);
+	  const auto dims = permuted_dimensions(t, order);
+	  E2M_OP_SCOPE(TENSOR_PERMUTE,
+		       dims[0] * dims[1] * dims[2] * sizeof(typename matrix_t::Scalar),
+		       dims[2]);
+
+	  if (order[0] == e2m::X && order[1] == e2m::Y) {
+	       // pages are unchanged
+	       return t;
+	  }
+
+	  std::vector<matrix_t> ret(dims[2], matrix_t(dims[0], dims[1]));
+	  permute_helper(t, order, permute_tensor_sink_t<matrix_t>(ret));
+	  return ret;
+     }
+} // namespace
+
+// =============================================================================
+
+e2m::real_tensor_t e2m::permute(const e2m::real_tensor_t& t,
+				const e2m::dir_order_t& order)
+{
+     return permute_tensor_helper(t, order);
+}
+
+// =====================================
+
+e2m::cmplx_tensor_t e2m::permute(const e2m::cmplx_tensor_t& t,
+				 const e2m::dir_order_t& order)
+{
+     return permute_tensor_helper(t, order);
+}
+
+// =====================================
+
+mxArray* e2m::permute_to_mxArray(const e2m::real_tensor_t& t,
+				 const e2m::dir_order_t& order)
+{
+     check_order(order);
+     const auto dims = permuted_dimensions(t, order);
+     E2M_OP_SCOPE(TENSOR_PERMUTE, dims[0] * dims[1] * dims[2] * sizeof(double), 1);
+
+     auto ret = mxCreateNumericArray(dims.size(),
+				     dims.data(),
+				     mxDOUBLE_CLASS,
+				     mxREAL);
+     e2m_assert(ret);
+
+     permute_helper(t, order,
+		    permute_mx_real_sink_t(mxGetPr(ret), dims[0], dims[1]));
+     return ret;
+}
+
+// =====================================
+
+mxArray* e2m::permute_to_mxArray(const e2m::cmplx_tensor_t& t,
+				 const e2m::dir_order_t& order)
+{
+     check_order(order);
+     const auto dims = permuted_dimensions(t, order);
+     E2M_OP_SCOPE(TENSOR_PERMUTE, dims[0] * dims[1] * dims[2] * sizeof(dcomplex), 1);
+
+     auto ret = mxCreateNumericArray(dims.size(),
+				     dims.data(),
+				     mxDOUBLE_CLASS,
+				     mxCOMPLEX);
+     e2m_assert(ret);
+
+     permute_helper(t, order,
+		    permute_mx_cmplx_sink_t(mxGetPr(ret), mxGetPi(ret),
+					    dims[0], dims[1]));
+     return ret;
+}
+
+// =============================================================================
+
+CLANG_RESTORE_WARNINGS
@@ -0,0 +1,324 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "eigen2mat/tensor_reduce.hpp"
+#include "eigen2mat/details/nan_ops.hpp"
+#include "eigen2mat/details/op_scope.hpp"
+#include "eigen2mat/utils/macros.hpp"
+#include "eigen2mat/utils/parallel.hpp"
+
+#include "eigen2mat/utils/include_mex"
+
+#include <cassert>
+
+namespace e2m = eigen2mat;
+
+CLANG_IGNORE_WARNINGS_ONE(-Wsign-conversion)
+
+namespace {
+     // Tensors with fewer elements are reduced serially
+     const e2m::size_t reduce_parallel_threshold = 32768;
+
+     /*
+      * Reducers: along_x/along_y reduce one page into one column of the
+      * result, init/accumulate fold pages into the result of a Z reduction,
+      * combine merges two partial results and finalize is applied once all
+      * the pages of a Z reduction have been folded.
+      *
+      * max & min ignore NaN values like MATLAB (and unlike Eigen's maxCoeff,
+      * whose result would depend on the position of the NaN values).
+      */
+     struct sum_reducer_t
+     {
+	  template <typename page_t, typename dst_t>
+	  static void along_x(const page_t& p, dst_t&& dst)
+	       {
+		    dst = p.colwise().sum().transpose();
+	       }
+	  template <typename page_t, typename dst_t>
+	  static void along_y(const page_t& p, dst_t&& dst)
+	       {
+		    dst = p.rowwise().sum();
+	       }
+	  template <typename page_t, typename dst_t>
+	  static void init(const page_t& p, dst_t&& dst)
+	       {
+		    dst = p;
+	       }
+	  template <typename page_t, typename dst_t>
+	  static void accumulate(const page_t& p, dst_t&& dst)
+	       {
+		    dst += p;
+	       }
+	  template <typename dst_t>
+	  static void combine(const dst_t& other, dst_t& dst)
+	       {
+		    dst += other;
+	       }
+	  template <typename dst_t>
+	  static void finalize(dst_t&, e2m::size_t)
+	       {}
+     };
+
+     struct mean_reducer_t : sum_reducer_t
+     {
+	  template <typename page_t, typename dst_t>
+	  static void along_x(const page_t& p, dst_t&& dst)
+	       {
+		    dst = p.colwise().mean().transpose();
+	       }
+	  template <typename page_t, typename dst_t>
+	  static void along_y(const page_t& p, dst_t&& dst)
+	       {
+		    dst = p.rowwise().mean();
+	       }
+	  template <typename dst_t>
+	  static void finalize(dst_t& dst, e2m::size_t n)
+	       {
+		    dst /= typename dst_t::Scalar(static_cast<double>(n));
+	       }
+     };
+
+     struct max_reducer_t : sum_reducer_t
+     {
+	  typedef e2m::internal::nan_max_op op_t;
+
+	  template <typename page_t, typename dst_t>
+	  static void along_x(const page_t& p, dst_t&& dst)
+	       {
+		    dst = p.colwise().redux(op_t()).transpose();
+	       }
+	  template <typename page_t, typename dst_t>
+	  static void along_y(const page_t& p, dst_t&& dst)
+	       {
+		    dst = p.rowwise().redux(op_t());
+	       }
+	  template <typename page_t, typename dst_t>
+	  static void accumulate(const page_t& p, dst_t&& dst)
+	       {
+		    dst = dst.binaryExpr(p, op_t());
+	       }
+	  template <typename dst_t>
+	  static void combine(const dst_t& other, dst_t& dst)
+	       {
+		    dst = dst.binaryExpr(other, op_t());
+	       }
+     };
+
+     struct min_reducer_t : sum_reducer_t
+     {
+	  typedef e2m::internal::nan_min_op op_t;
+
+	  template <typename page_t, typename dst_t>
+	  static void along_x(const page_t& p, dst_t&& dst)
+	       {
+		    dst = p.colwise().redux(op_t()).transpose();
+	       }
+	  template <typename page_t, typename dst_t>
+	  static void along_y(const page_t& p, dst_t&& dst)
+	       {
+		    dst = p.rowwise().redux(op_t());
+	       }
+	  template <typename page_t, typename dst_t>
+	  static void accumulate(const page_t& p, dst_t&& dst)
+	       {
+		    dst = dst.binaryExpr(p, op_t());
+	       }
+	  template <typename dst_t>
+	  static void combine(const dst_t& other, dst_t& dst)
+	       {
+		    dst = dst.binaryExpr(other, op_t());
+	       }
+     };
+
+     struct norm_reducer_t : sum_reducer_t
+     {
+	  template <typename page_t, typename dst_t>
+	  static void along_x(const page_t& p, dst_t&& dst)
+	       {
+		    dst = p.colwise().norm().transpose();
+	       }
+	  template <typename page_t, typename dst_t>
+	  static void along_y(const page_t& p, dst_t&& dst)
+	       {
+		    dst = p.rowwise().norm();
+	       }
+	  template <typename page_t, typename dst_t>
+	  static void init(const page_t& p, dst_t&& dst)
+	       {
+		    dst = p.cwiseAbs2();
+	       }
+	  template <typename page_t, typename dst_t>
+	  static void accumulate(const page_t& p, dst_t&& dst)
+	       {
+		    dst += p.cwiseAbs2();
+	       }
+	  template <typename dst_t>
+	  static void finalize(dst_t& dst, e2m::size_t)
+	       {
+		    dst = dst.cwiseSqrt();
+	       }
+     };
+
+     template <typename reducer_t, typename result_t, typename matrix_t>
+     result_t tensor_reduce_helper(const std::vector<matrix_t>& t,
+				   e2m::DIR_T dim,
+				   e2m::REDUCE_ORDER_T order)
+     {
+	  typedef e2m::internal::par_index_t par_index_t;
+
+	  const e2m::size_t P = t.size();
+
+	  if (P == 0) {
+	       return result_t();
+	  }
+
+	  const e2m::size_t M = t[0].rows();
+	  const e2m::size_t N = t[0].cols();
+	  E2M_OP_SCOPE(TENSOR_REDUCE,
+		       M * N * P * sizeof(typename matrix_t::Scalar),
+		       1);
+
+	  const bool serial = M * N * P < reduce_parallel_threshold;
+
+	  if (dim == e2m::X || dim == e2m::Y) {
+	       result_t r(dim == e2m::X ? N : M, P);
+	       e2m::internal::parallel_for(
+		    0, P,
+		    [&](par_index_t k) {
+			 if (dim == e2m::X) {
+			      reducer_t::along_x(t[k], r.col(k));
+			 }
+			 else {
+			      reducer_t::along_y(t[k], r.col(k));
+			 }
+		    },
+		    serial ? P + 1 : 2);
+	       return r;
+	  }
+
+	  result_t r(M, N);
+	  const par_index_t T = serial ? 1 : e2m::internal::max_threads();
+
+	  if (order == e2m::ANY_ORDER && T > 1 && N < 4 * e2m::size_t(T)) {
+	       // too few columns to keep every thread busy: split the pages
+	       const auto n_chunks = e2m::internal::num_chunks(P, 1);
+	       std::vector<result_t> partial(n_chunks);
+	       e2m::internal::parallel_for(
+		    0, n_chunks,
+		    [&](par_index_t c) {
+			 par_index_t begin(0), end(0);
+			 e2m::internal::chunk_range(P, n_chunks, c, begin, end);
+			 reducer_t::init(t[begin], partial[c]);
+			 for (auto k(begin + 1) ; k < end ; ++k) {
+			      reducer_t::accumulate(t[k], partial[c]);
+			 }
+		    });
+	       r = partial[0];
+	       for (auto c(1) ; c < n_chunks ; ++c) {
+		    reducer_t::combine(partial[c], r);
+	       }
+	  }
+	  else {
+	       // split the columns: each element is folded in page order
+	       const auto n_chunks = T == 1 ? 1 : e2m::internal::num_chunks(N, 1);
+	       e2m::internal::parallel_for(
+		    0, n_chunks,
+		    [&](par_index_t c) {
+			 par_index_t begin(0), end(0);
+			 e2m::internal::chunk_range(N, n_chunks, c, begin, end);
+			 auto dst = r.middleCols(begin, end - begin);
+			 reducer_t::init(t[0].middleCols(begin, end - begin), dst);
+			 for (auto k(1UL) ; k < P ; ++k) {
+			      reducer_t::accumulate(t[k].middleCols(begin, end - begin),
+						    dst);
+			 }
+		    });
+	  }
+
+	  reducer_t::finalize(r, P);
+	  return r;
+     }
+} // namespace
+
+// =============================================================================
+
+e2m::real_matrix_t e2m::tensor_sum(const e2m::real_tensor_t& t,
+				   e2m::DIR_T dim,
+				   e2m::REDUCE_ORDER_T order)
+{
+     return tensor_reduce_helper<sum_reducer_t, real_matrix_t>(t, dim, order);
+}
+
+// =====================================
+
+e2m::cmplx_matrix_t e2m::tensor_sum(const e2m::cmplx_tensor_t& t,
+				    e2m::DIR_T dim,
+				    e2m::REDUCE_ORDER_T order)
+{
+     return tensor_reduce_helper<sum_reducer_t, cmplx_matrix_t>(t, dim, order);
+}
+
+// =====================================
+
+e2m::real_matrix_t e2m::tensor_mean(const e2m::real_tensor_t& t,
+				    e2m::DIR_T dim,
+				    e2m::REDUCE_ORDER_T order)
+{
+     return tensor_reduce_helper<mean_reducer_t, real_matrix_t>(t, dim, order);
+}
+
+// =====================================
+
+e2m::cmplx_matrix_t e2m::tensor_mean(const e2m::cmplx_tensor_t& t,
+				     e2m::DIR_T dim,
+				     e2m::REDUCE_ORDER_T order)
+{
+     return tensor_reduce_helper<mean_reducer_t, cmplx_matrix_t>(t, dim, order);
+}
+
+// =====================================
+
+e2m::real_matrix_t e2m::tensor_max(const e2m::real_tensor_t& t,
+				   e2m::DIR_T dim,
+				   e2m::REDUCE_ORDER_T order)
+{
+     return tensor_reduce_helper<max_reducer_t, real_matrix_t>(t, dim, order);
+}
+
+// =====================================
+
+e2m::real_matrix_t e2m::tensor_min(const e2m::real_tensor_t& t,
+				   e2m::DIR_T dim,
+				   e2m::REDUCE_ORDER_T order)
+{
+     return tensor_reduce_helper<min_reducer_t, real_matrix_t>(t, dim, order);
+}
+
+// =====================================
+
+e2m::real_matrix_t e2m::tensor_norm(const e2m::real_tensor_t& t,
+				    e2m::DIR_T dim,
+				    e2m::REDUCE_ORDER_T order)
+{
+     return tensor_reduce_helper<norm_reducer_t, real_matrix_t>(t, dim, order);
+}
+
+// =====================================
+
+e2m::real_matrix_t e2m::tensor_norm(const e2m::cmplx_tensor_t& t,
+				    e2m::DIR_T dim,
+				    e2m::REDUCE_ORDER_T order)
+{
+     return tensor_reduce_helper<norm_reducer_t, real_matrix_t>(t, dim, order);
+}
+
+// =============================================================================
+
+CLANG_RESTORE_WARNINGS
@@ -8,52 +8,214 @@
 // with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
 #include "eigen2mat/tensor_to_matrix.hpp"
+#include "eigen2mat/details/op_scope.hpp"
 #include "eigen2mat/utils/macros.hpp"
+#include "eigen2mat/utils/parallel.hpp"
 
 #include "eigen2mat/utils/include_mex"
 
+#include <cassert>
+
 namespace e2m = eigen2mat;
 
 CLANG_IGNORE_WARNINGS_ONE(-Wsign-conversion)
 
-template <typename matrix_t>
-matrix_t tensor_to_matrix_helper(const std::vector<matrix_t>& t,
-				 e2m::DIR_T dim,
-				 size_t idx)
-{
-     const auto P = t.size();
+namespace {
+     // Slices with fewer elements are extracted serially
+     const e2m::size_t tensor_parallel_threshold = 32768;
 
-     if (P == 0) {
-	  return matrix_t();
-     }
+     // Writes the k-th column of a slice into an Eigen matrix
+     template <typename matrix_t>
+     struct matrix_sink_t
+     {
+	  explicit matrix_sink_t(matrix_t& m) : m_(m) {}
+
+	  template <typename xpr_t>
+	  void column(e2m::size_t k, const xpr_t& xpr) const
+	       {
+		    m_.col(k) = xpr;
+	       }
+
+	  matrix_t& m_;
+     };
+
+     // Writes the k-th column of a slice into a real mxArray
+     struct mx_real_sink_t
+     {
+	  mx_real_sink_t(double* pr, e2m::size_t rows) : pr_(pr), rows_(rows) {}
 
-     const auto M = t[0].rows();
-     const auto N = t[0].cols();
-     if (dim == eigen2mat::X) {
-	  matrix_t r(N, P);
-	  for (auto j(0); j < N; ++j) {
-	       for (auto k(0UL); k < P; ++k) {
-		    r(j,k) = t[k](idx,j);
+	  template <typename xpr_t>
+	  void column(e2m::size_t k, const xpr_t& xpr) const
+	       {
+		    e2m::real_map_vec_t(pr_ + k * rows_, rows_) = xpr;
 	       }
+
+	  double* pr_;
+	  e2m::size_t rows_;
+     };
+
+     // Writes the k-th column of a slice into a complex mxArray
+     struct mx_cmplx_sink_t
+     {
+	  mx_cmplx_sink_t(double* pr, double* pi, e2m::size_t rows)
+	       : pr_(pr), pi_(pi), rows_(rows) {}
+
+	  template <typename xpr_t>
+	  void column(e2m::size_t k, const xpr_t& xpr) const
+	       {
+		    e2m::real_map_vec_t(pr_ + k * rows_, rows_) = xpr.real();
+		    e2m::real_map_vec_t(pi_ + k * rows_, rows_) = xpr.imag();
+	       }
+
+	  double* pr_;
+	  double* pi_;
+	  e2m::size_t rows_;
+     };
+
+     // Writes the k-th column of a slice into a slice of another tensor
+     template <typename matrix_t>
+     struct tensor_sink_t
+     {
+	  tensor_sink_t(std::vector<matrix_t>& t, e2m::DIR_T dim, e2m::size_t idx)
+	       : t_(t), dim_(dim), idx_(idx) {}
+
+	  template <typename xpr_t>
+	  void column(e2m::size_t k, const xpr_t& xpr) const
+	       {
+		    if (dim_ == e2m::X) {
+			 t_[k].row(idx_) = xpr.transpose();
+		    }
+		    else if (dim_ == e2m::Y) {
+			 t_[k].col(idx_) = xpr;
+		    }
+		    else {
+			 t_[idx_].col(k) = xpr;
+		    }
+	       }
+
+	  std::vector<matrix_t>& t_;
+	  e2m::DIR_T dim_;
+	  e2m::size_t idx_;
+     };
+
+     template <typename matrix_t>
+     void slice_dimensions(const std::vector<matrix_t>& t,
+			   e2m::DIR_T dim,
+			   e2m::size_t& rows,
+			   e2m::size_t& cols)
+     {
+	  const e2m::size_t P = t.size();
+	  const e2m::size_t M = P == 0 ? 0 : t[0].rows();
+	  const e2m::size_t N = P == 0 ? 0 : t[0].cols();
+
+	  if (P == 0) {
+	       rows = cols = 0;
+	  }
+	  else if (dim == e2m::X) {
+	       rows = N;
+	       cols = P;
+	  }
+	  else if (dim == e2m::Y) {
+	       rows = M;
+	       cols = P;
+	  }
+	  else {
+	       rows = M;
+	       cols = N;
 	  }
-	  return r;
      }
-     else if (dim == eigen2mat::Y) {
-	  matrix_t r(M, P);
-	  for (auto i(0); i < N; ++i) {
-	       for (auto k(0UL); k < P; ++k) {
-		    r(i,k) = t[k](i,idx);
-	       }
+
+     // min_size argument of parallel_for() over the columns of a slice:
+     // small slices are processed serially
+     inline e2m::internal::par_index_t parallel_min_size(e2m::size_t rows,
+							   e2m::size_t cols)
+     {
+	  return rows * cols < tensor_parallel_threshold ? cols + 1 : 2;
+     }
+
+     /*
+      * Feeds each column of a tensor slice (as returned by tensor_to_matrix)
+      * to a sink. Each page is only read once and contiguously in the
+      * output: X slices are a strided gather of one row of each page, Y
+      * slices a plain copy of one column of each page. Pages are processed
+      * in parallel.
+      */
+     template <typename matrix_t, typename sink_t>
+     void extract_slice(const std::vector<matrix_t>& t,
+			e2m::DIR_T dim,
+			e2m::size_t idx,
+			const sink_t& sink)
+     {
+	  const e2m::size_t P = t.size();
+
+	  if (P == 0) {
+	       return;
+	  }
+
+	  const e2m::size_t M = t[0].rows();
+	  const e2m::size_t N = t[0].cols();
+	  e2m::size_t rows(0), cols(0);
+	  slice_dimensions(t, dim, rows, cols);
+
+	  const auto min_size = parallel_min_size(rows, cols);
+
+	  if (dim == e2m::X) {
+	       e2m_assert(idx < M);
+	       e2m::internal::parallel_for(
+		    0, P,
+		    [&](e2m::internal::par_index_t k) {
+			 sink.column(k, t[k].row(idx).transpose());
+		    },
+		    min_size);
+	  }
+	  else if (dim == e2m::Y) {
+	       e2m_assert(idx < N);
+	       e2m::internal::parallel_for(
+		    0, P,
+		    [&](e2m::internal::par_index_t k) {
+			 sink.column(k, t[k].col(idx));
+		    },
+		    min_size);
+	  }
+	  else if (dim == e2m::Z) {
+	       e2m_assert(idx < P);
+	       const auto& page = t[idx];
+	       e2m::internal::parallel_for(
+		    0, N,
+		    [&](e2m::internal::par_index_t j) {
+			 sink.column(j, page.col(j));
+		    },
+		    min_size);
 	  }
-	  return r;
      }
-     else if (dim == eigen2mat::Z) {
-	  return t[idx];
+
+     template <typename matrix_t>
+     void tensor_to_matrix_helper(const std::vector<matrix_t>& t,
+				  e2m::DIR_T dim,
+				  e2m::size_t idx,
+				  matrix_t& out)
+     {
+	  e2m::size_t rows(0), cols(0);
+	  slice_dimensions(t, dim, rows, cols);
+	  E2M_OP_SCOPE(TENSOR_TO_MATRIX,
+		       rows * cols * sizeof(typename matrix_t::Scalar),
+		       1);
+	  out.resize(rows, cols);
+	  extract_slice(t, dim, idx, matrix_sink_t<matrix_t>(out));
      }
-     else {
-	  return matrix_t();
+
+     // Feeds each column of a matrix to a sink
+     template <typename matrix_t, typename sink_t>
+     void extract_columns(const matrix_t& m, const sink_t& sink)
+     {
+	  e2m::internal::parallel_for(
+	       0, m.cols(),
+	       [&](e2m::internal::par_index_t j) {
+		    sink.column(j, m.col(j));
+	       },
+	       parallel_min_size(m.rows(), m.cols()));
      }
-}
+} // namespace
 
 // =====================================
 
@@ -61,7 +223,9 @@ eigen2mat::real_matrix_t eigen2mat::tensor_to_matrix(const e2m::real_tensor_t& t
 						     e2m::DIR_T dim, 
 						     e2m::size_t idx)
 {
-     return tensor_to_matrix_helper<e2m::real_matrix_t>(t, dim, idx);
+     real_matrix_t r;
+     tensor_to_matrix_helper(t, dim, idx, r);
+     return r;
 }
 
 // =====================================
@@ -70,11 +234,74 @@ eigen2mat::cmplx_matrix_t eigen2mat::tensor_to_matrix(const e2m::cmplx_tensor_t&
 						      e2m::DIR_T dim, 
 						      e2m::size_t idx)
 {
-     return tensor_to_matrix_helper<e2m::cmplx_matrix_t>(t, dim, idx);
+     cmplx_matrix_t r;
+     tensor_to_matrix_helper(t, dim, idx, r);
+     return r;
+}
+
+// =====================================
+
+void eigen2mat::tensor_to_matrix(const e2m::real_tensor_t& t,
+				 e2m::DIR_T dim,
+				 e2m::size_t idx,
+				 e2m::real_matrix_t& out)
+{
+     tensor_to_matrix_helper(t, dim, idx, out);
+}
+
+// =====================================
+
+void eigen2mat::tensor_to_matrix(const e2m::cmplx_tensor_t& t,
+				 e2m::DIR_T dim,
+				 e2m::size_t idx,
+				 e2m::cmplx_matrix_t& out)
+{
+     tensor_to_matrix_helper(t, dim, idx, out);
+}
+
+// =====================================
+
+mxArray* eigen2mat::tensor_to_mxArray(const e2m::real_tensor_t& t,
+				      e2m::DIR_T dim,
+				      e2m::size_t idx)
+{
+     e2m::size_t rows(0), cols(0);
+     slice_dimensions(t, dim, rows, cols);
+
+     E2M_OP_SCOPE(TENSOR_TO_MATRIX, rows * cols * sizeof(double), 1);
+
+     auto ret = mxCreateDoubleMatrix(rows, cols, mxREAL);
+     e2m_assert(ret);
+     extract_slice(t, dim, idx, mx_real_sink_t(mxGetPr(ret), rows));
+     return ret;
+}
+
+// =====================================
+
+mxArray* eigen2mat::tensor_to_mxArray(const e2m::cmplx_tensor_t& t,
+				      e2m::DIR_T dim,
+				      e2m::size_t idx)
+{
+     e2m::size_t rows(0), cols(0);
+     slice_dimensions(t, dim, rows, cols);
+
+     E2M_OP_SCOPE(TENSOR_TO_MATRIX, rows * cols * sizeof(dcomplex), 1);
+
+     auto ret = mxCreateDoubleMatrix(rows, cols, mxCOMPLEX);
+     e2m_assert(ret);
+     extract_slice(t, dim, idx,
+		   mx_cmplx_sink_t(mxGetPr(ret), mxGetPi(ret), rows));
+     return ret;
 }
 
 // =============================================================================
 
+/*
+ * Every combination of directions is handled by the same engine: the slice of
+ * the RHS is fed column by column (see tensor_to_matrix) to a sink writing
+ * into the corresponding column of the slice of the LHS. Per page, that is
+ * always either a contiguous column or a single (strided) row.
+ */
 template <typename matrix_t>
 void tensor_slice_assign_helper(std::vector<matrix_t>& t_lhs,
 				e2m::DIR_T dim_lhs,
@@ -91,100 +318,38 @@ void tensor_slice_assign_helper(std::vector<matrix_t>& t_lhs,
 	  return;
      }
 
-     const e2m::size_t M_lhs = t_lhs[0].rows();
-     const e2m::size_t N_lhs = t_lhs[0].cols();
+     e2m::size_t rows_lhs(0), cols_lhs(0);
+     slice_dimensions(t_lhs, dim_lhs, rows_lhs, cols_lhs);
+     E2M_OP_SCOPE(TENSOR_SLICE_ASSIGN,
+		  rows_lhs * cols_lhs * sizeof(typename matrix_t::Scalar),
+		  0);
 
 #ifndef NDEBUG
-     const e2m::size_t M_rhs = t_rhs[0].rows();
-     const e2m::size_t N_rhs = t_rhs[0].cols();     
+     e2m::size_t rows_rhs(0), cols_rhs(0);
+     slice_dimensions(t_rhs, dim_rhs, rows_rhs, cols_rhs);
+     assert(rows_lhs == rows_rhs && cols_lhs == cols_rhs);
+     assert(idx_lhs < (dim_lhs == e2m::X ? t_lhs[0].rows() :
+		       dim_lhs == e2m::Y ? t_lhs[0].cols() : P_lhs));
 #endif /* NDEBUG */
 
-     if (dim_lhs == e2m::Z && dim_rhs == e2m::Z) {
-	  assert(M_lhs == M_rhs && N_lhs == N_rhs);
-	  t_lhs[idx_lhs] = t_rhs[idx_rhs];
-     }
-     else if (dim_lhs == e2m::X && dim_rhs == e2m::X) {
-	  // t_lhs(i1, :, :) = t_rhs(i2, :, :);
-	  assert(N_lhs == N_rhs && P_lhs == P_rhs);
-	  for (auto j(0UL); j < N_lhs; ++j) {
-	       for (auto k(0UL); k < P_lhs; ++k) {
-		    t_lhs[k](idx_lhs, j) = t_rhs[k](idx_rhs, j);
+     if (&t_lhs == &t_rhs) {
+	  if (dim_lhs == dim_rhs) {
+	       // slices are either disjoint or identical
+	       if (idx_lhs == idx_rhs) {
+		    return;
 	       }
 	  }
-     }
-     else if (dim_lhs == e2m::Y && dim_rhs == e2m::Y) {
-	  // t_lhs(:, i1, :) = t_rhs(:, i2, :);
-	  assert(M_lhs == M_rhs && P_lhs == P_rhs);
-	  for (auto i(0UL); i < M_lhs; ++i) {
-	       for (auto k(0UL); k < P_lhs; ++k) {
-		    t_lhs[k](i, idx_lhs) = t_rhs[k](i, idx_rhs);
-	       }
+	  else {
+	       // slices along different directions overlap: go through a copy
+	       matrix_t tmp;
+	       tensor_to_matrix_helper(t_rhs, dim_rhs, idx_rhs, tmp);
+	       extract_columns(tmp, tensor_sink_t<matrix_t>(t_lhs, dim_lhs, idx_lhs));
+	       return;
 	  }
      }
-     else {
-	  mexErrMsgTxt("tensor_slice_assign_helper(): unsupported operation");
-     }
-
 
-     // else if (dim_lhs == e2m::X && dim_rhs == e2m::Z) {
-     //		  // t_lhs(i1, :, :) = t_rhs(:,:,i2);
-     //		  assert(N_lhs == M_rhs && P_lhs == N_rhs);
-     //		  auto& mat = t_rhs[idx_rhs];
-     //		  for (auto j(0UL); j < N_lhs; ++j) {
-     //		       for (auto k(0UL); k < P_lhs; ++k) {
-     //			    t_lhs[k](idx_lhs, j) = mat(j, k);
-     //		       }
-     //		  }
-     // }
-     // else if (dim_lhs == e2m::Y && dim_rhs == e2m::Z) {
-     //		  // t_lhs(:, i1, :) = t_rhs(:,:,i2);
-     //		  assert(M_lhs == M_rhs && P_lhs == N_rhs);
-     //		  auto& mat = t_rhs[idx_rhs];
-     //		  for (auto i(0UL); i < N_lhs; ++i) {
-     //		       for (auto k(0UL); k < P_lhs; ++k) {
-     //			    t_lhs[k](i, idx_lhs) = mat(i, k);
-     //		       }
-     //		  }
-     // }
-     // else if (dim_lhs == e2m::Z && dim_rhs == e2m::X) {
-     //		  // t_lhs(:, :, i1) = t_rhs(i1, :, :);
-     //		  assert(M_lhs == N_rhs && N_lhs == P_rhs);
-     //		  auto& mat = t_lhs[idx_lhs];
-     //		  for (auto i(0UL); i < M_lhs; ++i) {
-     //		       for (auto j(0UL); j < N_lhs; ++j) {
-     //			    mat(i, j) = t_rhs[j](idx_rhs, i);
-     //		       }
-     //		  }
-     // }
-     // else if (dim_lhs ==  e2m::Z && dim_rhs == e2m::Y) {
-     //		  // t_lhs(:, :, i1) = t_rhs(:, i1, :);
-     //		  assert(M_lhs == M_rhs && N_lhs == P_rhs);
-     //		  auto& mat = t_lhs[idx_lhs];
-     //		  for (auto i(0UL); i < M_lhs; ++i) {
-     //		       for (auto j(0UL); j < N_lhs; ++j) {
-     //			    mat(i, j) = t_rhs[j](i, idx_rhs);
-     //		       }
-     //		  }
-     // }
-     // else if (dim_lhs == e2m::X && dim_rhs == e2m::Y) {
-     //		  // t_lhs(i1, :, :) = t_rhs(:, i2, :);
-     //		  assert(N_lhs == M_rhs && P_lhs == P_rhs);
-     //		  for (auto j(0UL); j < N_lhs; ++j) {
-     //		       for (auto k(0UL); k < P_lhs; ++k) {
-     //			    t_lhs[k](idx_lhs, j) = t_rhs[k](j, idx_rhs);
-     //		       }
-     //		  }
-     // }
-     // else {
-     //		  // dim_lhs == e2m::Y && dim_rhs == e2m::X
-     //		  // t_lhs(:, i1, :) = t_rhs(i2, :, :);
-     //		  assert(M_lhs == N_rhs && P_lhs == P_rhs);
-     //		  for (auto j(0UL); j < M_lhs; ++j) {
-     //		       for (auto k(0UL); k < P_lhs; ++k) {
-     //			    t_lhs[k](j, idx_lhs) = t_rhs[k](idx_rhs, j);
-     //		       }
-     //		  }
-     // }
+     extract_slice(t_rhs, dim_rhs, idx_rhs,
+		   tensor_sink_t<matrix_t>(t_lhs, dim_lhs, idx_lhs));
 }
 
 // =====================================
@@ -220,41 +385,20 @@ void tensor_slice_assign_helper(std::vector<matrix_t>& t_lhs,
 	  return;
      }
 
-     const size_t M_lhs = t_lhs[0].rows();
-     const size_t N_lhs = t_lhs[0].cols();
+     e2m::size_t rows_lhs(0), cols_lhs(0);
+     slice_dimensions(t_lhs, dim_lhs, rows_lhs, cols_lhs);
+     E2M_OP_SCOPE(TENSOR_SLICE_ASSIGN,
+		  rows_lhs * cols_lhs * sizeof(typename matrix_t::Scalar),
+		  0);
 
-#ifndef NDEBUG
-     const size_t M_rhs = m_rhs.rows();
-     const size_t N_rhs = m_rhs.cols();     
-#endif /* NDEBUG */
-     
-     if (dim_lhs == e2m::Z) {
-	  // t_lhs(:, :, i1) = m_rhs(:, :);
-	  assert(M_lhs == M_rhs && N_lhs == N_rhs);
-	  t_lhs[idx_lhs] = m_rhs;
-     }
-     else if (dim_lhs == e2m::X) {
-	  // t_lhs(i1, :, :) = m_rhs(:, :);
-	  assert(N_lhs == N_rhs && P_lhs == M_rhs);
-	  for (auto j(0UL); j < N_lhs; ++j) {
-	       for (auto k(0UL); k < P_lhs; ++k) {
-		    t_lhs[k](idx_lhs, j) = m_rhs(j, k);
-	       }
-	  }
-     }
-     else if (dim_lhs == e2m::Y) {
-	  // t_lhs(:, i1, :) = m_rhs(:, :);
-	  assert(M_lhs == M_rhs && P_lhs == M_rhs);
-	  for (auto i(0UL); i < M_lhs; ++i) {
-	       for (auto k(0UL); k < P_lhs; ++k) {
-		    t_lhs[k](i, idx_lhs) = m_rhs(i, k);
-	       }
-	  }
-     }
-     else {
-	  mexErrMsgTxt("tensor_slice_assign_helper(matrix version): unsupported operation");
-     }
+     assert(rows_lhs == static_cast<size_t>(m_rhs.rows()) &&
+	    cols_lhs == static_cast<size_t>(m_rhs.cols()));
+     assert(idx_lhs < (dim_lhs == e2m::X ? t_lhs[0].rows() :
+		       dim_lhs == e2m::Y ? t_lhs[0].cols() : P_lhs));
+
+     extract_columns(m_rhs, tensor_sink_t<matrix_t>(t_lhs, dim_lhs, idx_lhs));
 }
+
 // =====================================
 
 void e2m::tensor_slice_assign(e2m::real_tensor_t& t_lhs, e2m::DIR_T dim_lhs, e2m::size_t idx_lhs,
@@ -0,0 +1,296 @@
+// This file is part of eigen2mat, a simple C++ library to use
+// Eigen with MATLAB's MEX files
+//
+// Copyright (C) 2013 Nguyen Damien <damien.nguyen@a3.epfl.ch>
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "eigen2mat/trace.hpp"
+#include "eigen2mat/utils/macros.hpp"
+
+#include "eigen2mat/utils/include_mex"
+
+#include <cassert>
+#include <cstdio>
+
+#ifdef EIGEN2MAT_TRACE
+#  include <mutex>
+#  include <vector>
+#endif /* EIGEN2MAT_TRACE */
+
+MSVC_IGNORE_WARNINGS(4267 4996)
+CLANG_IGNORE_WARNINGS_TWO(-Wexit-time-destructors, -Wglobal-constructors)
+
+namespace tr = eigen2mat::trace;
+
+#ifdef EIGEN2MAT_TRACE
+std::atomic<bool> tr::internal::active(false);
+
+namespace {
+     struct event_t
+     {
+	  unsigned long long begin;
+	  unsigned long long end;
+	  unsigned long long bytes;
+	  eigen2mat::stats::op_t op;
+     };
+
+     /*
+      * Single producer ring buffer: only the owning thread writes events and
+      * advances head (release); flush() reads events up to head (acquire)
+      * under the registry mutex. Events overwritten by the producer while
+      * flush() was copying them are detected by re-reading head afterwards
+      * and discarded.
+      */
+     struct ring_t
+     {
+	  ring_t(std::size_t capacity, unsigned id)
+	       : events(capacity), head(0), tail(0), tid(id), alive(true)
+	       {}
+
+	  void push(const event_t& e)
+	       {
+		    const auto h = head.load(std::memory_order_relaxed);
+		    events[h % events.size()] = e;
+		    head.store(h + 1, std::memory_order_release);
+	       }
+
+	  std::vector<event_t> events;
+	  std::atomic<unsigned long long> head; // number of events pushed
+	  unsigned long long tail;              // first event not flushed yet
+	  const unsigned tid;
+	  std::atomic<bool> alive;
+     };
+
+     struct registry_t
+     {
+	  registry_t() : mutex(), rings(), capacity(65536), next_tid(1), dropped(0) {}
+
+	  std::mutex mutex;
+	  std::vector<ring_t*> rings;
+	  std::size_t capacity;
+	  unsigned next_tid;
+	  unsigned long long dropped;
+     };
+
+     // Never destroyed on purpose: threads may exit after static destructors
+     registry_t& registry()
+     {
+	  static registry_t* r = new registry_t;
+	  return *r;
+     }
+
+     // Rings of terminated threads are released by the next flush()
+     struct thread_ring_t
+     {
+	  thread_ring_t()
+	       : ring(nullptr)
+	       {
+		    auto& reg = registry();
+		    std::lock_guard<std::mutex> lock(reg.mutex);
+		    ring = new ring_t(reg.capacity, reg.next_tid++);
+		    reg.rings.push_back(ring);
+	       }
+	  ~thread_ring_t()
+	       {
+		    ring->alive.store(false, std::memory_order_release);
+	       }
+	  thread_ring_t(const thread_ring_t&) = delete;
+	  thread_ring_t& operator=(const thread_ring_t&) = delete;
+
+	  ring_t* ring;
+     };
+
+     ring_t& local_ring()
+     {
+	  thread_local thread_ring_t r;
+	  return *r.ring;
+     }
+} // namespace
+
+#endif /* EIGEN2MAT_TRACE */
+
+// =============================================================================
+
+bool tr::enabled()
+{
+#ifdef EIGEN2MAT_TRACE
+     return true;
+#else
+     return false;
+#endif /* EIGEN2MAT_TRACE */
+}
+
+// =====================================
+
+#ifdef EIGEN2MAT_TRACE
+void tr::start(std::size_t capacity)
+{
+     {
+	  auto& reg = registry();
+	  std::lock_guard<std::mutex> lock(reg.mutex);
+	  reg.capacity = capacity > 0 ? capacity : 1;
+	  reg.dropped = 0;
+     }
+     internal::active.store(true, std::memory_order_relaxed);
+}
+#else
+void tr::start(std::size_t)
+{}
+#endif /* EIGEN2MAT_TRACE */
+
+// =====================================
+
+void tr::stop()
+{
+#ifdef EIGEN2MAT_TRACE
+     internal::active.store(false, std::memory_order_relaxed);
+#endif /* EIGEN2MAT_TRACE */
+}
+
+// =====================================
+
+#ifdef EIGEN2MAT_TRACE
+void tr::record(eigen2mat::stats::op_t op,
+		unsigned long long bytes,
+		unsigned long long begin,
+		unsigned long long end)
+{
+     event_t e;
+     e.begin = begin;
+     e.end = end;
+     e.bytes = bytes;
+     e.op = op;
+     local_ring().push(e);
+}
+#endif /* EIGEN2MAT_TRACE */
+
+// =====================================
+
+#ifdef EIGEN2MAT_TRACE
+std::size_t tr::flush(const char* filename)
+{
+     e2m_assert(filename);
+
+     auto* f = std::fopen(filename, "w");
+     if (f == nullptr) {
+	  mexErrMsgIdAndTxt("eigen2mat:io_error",
+			    "trace::flush(): unable to open %s for writing",
+			    filename);
+	  return 0;
+     }
+
+     auto& reg = registry();
+     std::lock_guard<std::mutex> lock(reg.mutex);
+
+     std::fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+     std::size_t n_written(0);
+     std::vector<event_t> buf;
+
+     for (auto r(0UL) ; r < reg.rings.size() ; ) {
+	  auto* ring = reg.rings[r];
+	  const auto capacity = ring->events.size();
+
+	  // the thread may be gone, but its last events are still to be written
+	  const bool alive = ring->alive.load(std::memory_order_acquire);
+	  const auto head = ring->head.load(std::memory_order_acquire);
+	  auto first = ring->tail;
+	  if (head - first > capacity) {
+	       reg.dropped += head - capacity - first;
+	       first = head - capacity;
+	  }
+
+	  buf.clear();
+	  for (auto i(first) ; i < head ; ++i) {
+	       buf.push_back(ring->events[i % capacity]);
+	  }
+
+	  // discard the events the producer may have overwritten meanwhile,
+	  // including the one it may be writing (slot head_after % capacity,
+	  // ie. event head_after - capacity, not published yet)
+	  const auto head_after = ring->head.load(std::memory_order_acquire);
+	  auto skip = 0ULL;
+	  if (head_after + 1 - first > capacity) {
+	       skip = head_after + 1 - capacity - first;
+	       if (skip > buf.size()) {
+		    skip = buf.size();
+	       }
+	       reg.dropped += skip;
+	  }
+
+	  for (auto i(skip) ; i < buf.size() ; ++i) {
+	       const auto& e = buf[i];
+	       std::fprintf(f,
+			    "%s\n{\"name\":\"%s\",\"cat\":\"eigen2mat\",\"ph\":\"X\","
+			    "\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u,"
+			    "\"args\":{\"bytes\":%llu}}",
+			    n_written == 0 ? "" : ",",
+			    stats::op_name(e.op),
+			    static_cast<double>(e.begin) * 1e-3,
+			    static_cast<double>(e.end - e.begin) * 1e-3,
+			    ring->tid,
+			    e.bytes);
+	       ++n_written;
+	  }
+	  ring->tail = head;
+
+	  if (!alive) {
+	       delete ring;
+	       reg.rings.erase(reg.rings.begin() + r);
+	  }
+	  else {
+	       ++r;
+	  }
+     }
+
+     std::fprintf(f, "\n]}\n");
+     std::fclose(f);
+     return n_written;
+}
+#else
+std::size_t tr::flush(const char* filename)
+{
+     e2m_assert(filename);
+
+     // still produce a valid (empty) trace file
+     auto* f = std::fopen(filename, "w");
+     if (f == nullptr) {
+	  mexErrMsgIdAndTxt("eigen2mat:io_error",
+			    "trace::flush(): unable to open %s for writing",
+			    filename);
+	  return 0;
+     }
+     std::fprintf(f, "{\"traceEvents\":[]}\n");
+     std::fclose(f);
+     return 0;
+}
+#endif /* EIGEN2MAT_TRACE */
+
+// =====================================
+
+std::size_t tr::dropped()
+{
+#ifdef EIGEN2MAT_TRACE
+     auto& reg = registry();
+     std::lock_guard<std::mutex> lock(reg.mutex);
+     auto ret = reg.dropped;
+     for (auto r(0UL) ; r < reg.rings.size() ; ++r) {
+	  const auto head = reg.rings[r]->head.load(std::memory_order_acquire);
+	  const auto pending = head - reg.rings[r]->tail;
+	  const auto capacity = reg.rings[r]->events.size();
+	  if (pending > capacity) {
+	       ret += pending - capacity;
+	  }
+     }
+     return ret;
+#else
+     return 0;
+#endif /* EIGEN2MAT_TRACE */
+}
+
+// =============================================================================
+
+CLANG_RESTORE_WARNINGS
+MSVC_RESTORE_WARNINGS
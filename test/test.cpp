@@ -7,9 +7,32 @@
 #include "eigen2mat/utils/Eigen_Sparse"
 #include "eigen2mat/utils/include_mex"
 
+#include "eigen2mat/accumarray.hpp"
 #include "eigen2mat/conversion.hpp"
+#include "eigen2mat/mask_view.hpp"
+#include "eigen2mat/mex_args.hpp"
 #include "eigen2mat/print.hpp"
+#include "eigen2mat/scatter_assembler.hpp"
+#include "eigen2mat/sparse_assembler.hpp"
+#include "eigen2mat/sparse_block_builder.hpp"
+#include "eigen2mat/sparse_edit.hpp"
 #include "eigen2mat/sparse_slice.hpp"
+#include "eigen2mat/stats.hpp"
+#include "eigen2mat/tensor_mode_product.hpp"
+#include "eigen2mat/tensor_page_ops.hpp"
+#include "eigen2mat/tensor_permute.hpp"
+#include "eigen2mat/tensor_reduce.hpp"
+#include "eigen2mat/tensor_to_matrix.hpp"
+#include "eigen2mat/trace.hpp"
+#include "eigen2mat/utils/macros.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
 
 //#define EIGEN2MAT_NO_MATLAB
 
@@ -33,6 +56,998 @@ void print(const Eigen::SparseMatrix<eigen2mat::dcomplex, 1>& m)
 }
 }
 
+// =============================================================================
+// Behaviour checks against naive references
+
+// exact comparisons are intended in the checks below
+GCC_IGNORE_WARNINGS_ONE(-Wfloat-equal)
+CLANG_IGNORE_WARNINGS_ONE(-Wfloat-equal)
+
+namespace {
+     namespace e2m = eigen2mat;
+
+     int n_failed(0);
+
+     void check(bool ok, const char* what)
+     {
+	  if (!ok) {
+	       PRINTF("FAILED: %s\n", what);
+	       ++n_failed;
+	  }
+     }
+
+     template <typename lhs_t, typename rhs_t>
+     bool is_close(const lhs_t& a, const rhs_t& b, double tol = 1e-12)
+     {
+	  return a.rows() == b.rows() && a.cols() == b.cols()
+	       && (a - b).norm() <= tol * (1. + b.norm());
+     }
+
+     // =========================================================================
+
+     void check_mex_args()
+     {
+	  const e2m::real_matrix_t A = e2m::real_matrix_t::Random(4, 3);
+	  mxArray* in[3];
+	  in[0] = mxCreateDoubleScalar(3.);
+	  in[1] = mxCreateNumericMatrix(1, 3, mxINT32_CLASS, mxREAL);
+	  auto* pi = static_cast<int*>(mxGetData(in[1]));
+	  pi[0] = 1; pi[1] = -5; pi[2] = 2;
+	  in[2] = e2m::to_mxArray(A);
+
+	  const mxArray** prhs = const_cast<const mxArray**>(in);
+	  e2m::mex_args<int,
+			e2m::int_array_t,
+			e2m::const_view<e2m::real_matrix_t>> args(3, prhs, "check_mex_args");
+	  check(args.get<0>() == 3, "mex_args: int scalar");
+	  const e2m::int_array_t ref = {1, -5, 2};
+	  check(args.get<1>() == ref, "mex_args: int_array_t");
+	  check(is_close(args.get<2>(), A, 0.), "mex_args: const_view<real_matrix_t>");
+
+	  for (auto* a : in) {
+	       mxDestroyArray(a);
+	  }
+
+	  // integer scalars are range-checked in their own type
+	  using e2m::internal::is_integer_scalar_;
+	  mxArray* s = mxCreateDoubleScalar(2.5);
+	  check(!is_integer_scalar_<int>(s), "mex_args: non-integer scalar");
+	  mxGetPr(s)[0] = -1.;
+	  check(is_integer_scalar_<int>(s) && !is_integer_scalar_<e2m::size_t>(s),
+		"mex_args: negative scalar");
+	  mxGetPr(s)[0] = std::numeric_limits<double>::quiet_NaN();
+	  check(!is_integer_scalar_<int>(s), "mex_args: NaN scalar");
+	  mxDestroyArray(s);
+	  mxArray* l = mxCreateNumericMatrix(1, 1, mxINT64_CLASS, mxREAL);
+	  // 2^53 + 1 is not representable as a double
+	  *static_cast<long long*>(mxGetData(l)) = (1LL << 53) + 1;
+	  check(is_integer_scalar_<e2m::size_t>(l) && !is_integer_scalar_<int>(l),
+		"mex_args: int64 scalar");
+	  mxDestroyArray(l);
+	  mxArray* u = mxCreateNumericMatrix(1, 1, mxUINT64_CLASS, mxREAL);
+	  // 2^64 - 1 would be rounded to 2^64 as a double
+	  *static_cast<unsigned long long*>(mxGetData(u)) = ~0ULL;
+	  check(is_integer_scalar_<e2m::size_t>(u) && !is_integer_scalar_<int>(u),
+		"mex_args: uint64 scalar");
+	  mxDestroyArray(u);
+     }
+
+     void check_stats()
+     {
+	  const e2m::real_matrix_t A = e2m::real_matrix_t::Random(16, 8);
+	  e2m::stats::reset();
+	  mxArray* a = e2m::to_mxArray(A);
+	  const e2m::real_matrix_t B = e2m::mxArray_to_real_matrix(a);
+	  mxDestroyArray(a);
+
+	  check(is_close(B, A, 0.), "stats: round trip");
+	  const auto c = e2m::stats::collect();
+	  check(c.size() == e2m::stats::N_OPS, "stats: one counter per operation");
+	  const auto& rd = c[e2m::stats::MXARRAY_TO_REAL_DENSE];
+	  if (e2m::stats::enabled()) {
+	       check(rd.calls == 1 && rd.bytes >= A.size() * sizeof(double),
+		     "stats: mxArray_to_real_matrix recorded");
+	  }
+	  else {
+	       check(rd.calls == 0, "stats: nothing recorded when disabled");
+	  }
+	  check(std::string(e2m::stats::op_name(e2m::stats::MEX_ARGS)) == "mex_args",
+		"stats: op_name");
+     }
+
+     void check_trace()
+     {
+	  const e2m::real_matrix_t A = e2m::real_matrix_t::Random(16, 8);
+	  e2m::trace::start(16);
+	  mxArray* a = e2m::to_mxArray(A);
+	  const e2m::real_matrix_t B = e2m::mxArray_to_real_matrix(a);
+	  mxDestroyArray(a);
+	  e2m::trace::stop();
+	  check(is_close(B, A, 0.), "trace: round trip");
+
+	  // a valid (possibly empty) trace file is written in any case
+	  const char* fname = "mytest_trace.json";
+	  const auto n = e2m::trace::flush(fname);
+	  if (e2m::trace::enabled()) {
+	       check(n >= 2, "trace: spans recorded");
+	  }
+	  else {
+	       check(n == 0, "trace: nothing recorded when disabled");
+	  }
+	  std::FILE* f = std::fopen(fname, "r");
+	  check(f != nullptr && std::fgetc(f) == '{', "trace: file written");
+	  if (f != nullptr) {
+	       std::fclose(f);
+	  }
+	  std::remove(fname);
+     }
+
+     e2m::real_tensor_t random_tensor(e2m::size_t M, e2m::size_t N, e2m::size_t P)
+     {
+	  e2m::real_tensor_t t(P);
+	  for (e2m::size_t k(0) ; k < P ; ++k) {
+	       t[k] = e2m::real_matrix_t::Random(M, N);
+	  }
+	  return t;
+     }
+
+     void check_tensor_to_matrix()
+     {
+	  const e2m::size_t M(4), N(5), P(3);
+	  const auto t = random_tensor(M, N, P);
+
+	  const auto x = e2m::tensor_to_matrix(t, e2m::X, 2);
+	  const auto y = e2m::tensor_to_matrix(t, e2m::Y, 1);
+	  const auto z = e2m::tensor_to_matrix(t, e2m::Z, 2);
+	  e2m::real_matrix_t rx(N, P), ry(M, P);
+	  for (e2m::size_t k(0) ; k < P ; ++k) {
+	       rx.col(k) = t[k].row(2).transpose();
+	       ry.col(k) = t[k].col(1);
+	  }
+	  check(is_close(x, rx, 0.), "tensor_to_matrix: X");
+	  check(is_close(y, ry, 0.), "tensor_to_matrix: Y");
+	  check(is_close(z, t[2], 0.), "tensor_to_matrix: Z");
+
+	  // slices big enough to be extracted in parallel
+	  const auto b = random_tensor(3, 200, 200);
+	  e2m::real_matrix_t bx(200, 200), by(3, 200);
+	  for (e2m::size_t k(0) ; k < 200 ; ++k) {
+	       bx.col(k) = b[k].row(1).transpose();
+	       by.col(k) = b[k].col(7);
+	  }
+	  e2m::real_matrix_t out(200, 200);
+	  e2m::tensor_to_matrix(b, e2m::X, 1, out);
+	  check(is_close(out, bx, 0.), "tensor_to_matrix: preallocated output");
+	  mxArray* m = e2m::tensor_to_mxArray(b, e2m::Y, 7);
+	  check(is_close(e2m::mxArray_to_real_matrix(m), by, 0.), "tensor_to_mxArray: Y");
+	  mxDestroyArray(m);
+     }
+
+     bool tensors_close(const e2m::real_tensor_t& a, const e2m::real_tensor_t& b)
+     {
+	  if (a.size() != b.size()) {
+	       return false;
+	  }
+	  for (e2m::size_t k(0) ; k < a.size() ; ++k) {
+	       if (!is_close(a[k], b[k])) {
+		    return false;
+	       }
+	  }
+	  return true;
+     }
+
+     //! Reference for tensor_slice_assign (m laid out as by tensor_to_matrix)
+     void set_slice(e2m::real_tensor_t& t, e2m::DIR_T dim, e2m::size_t idx,
+		    const e2m::real_matrix_t& m)
+     {
+	  for (e2m::size_t k(0) ; k < t.size() ; ++k) {
+	       if (dim == e2m::X) {
+		    t[k].row(idx) = m.col(k).transpose();
+	       }
+	       else if (dim == e2m::Y) {
+		    t[k].col(idx) = m.col(k);
+	       }
+	       else if (k == idx) {
+		    t[k] = m;
+	       }
+	  }
+     }
+
+     void check_tensor_slice_assign()
+     {
+	  const e2m::DIR_T dirs[] = {e2m::X, e2m::Y, e2m::Z};
+	  const e2m::size_t N(5);
+	  const auto c = random_tensor(N, N, N);
+	  bool ok(true);
+	  for (auto dl : dirs) {
+	       for (auto dr : dirs) {
+		    auto u = random_tensor(N, N, N);
+		    auto ref = u;
+		    set_slice(ref, dl, 1, e2m::tensor_to_matrix(c, dr, 3));
+		    e2m::tensor_slice_assign(u, dl, 1, c, dr, 3);
+		    ok &= tensors_close(u, ref);
+	       }
+	  }
+	  check(ok, "tensor_slice_assign: all direction pairs");
+
+	  // same tensor on both sides
+	  auto u = c;
+	  auto ref = c;
+	  set_slice(ref, e2m::Z, 0, e2m::tensor_to_matrix(c, e2m::X, 4));
+	  e2m::tensor_slice_assign(u, e2m::Z, 0, u, e2m::X, 4);
+	  check(tensors_close(u, ref), "tensor_slice_assign: aliasing");
+
+	  const e2m::real_matrix_t m = e2m::real_matrix_t::Random(N, N);
+	  set_slice(ref, e2m::Y, 2, m);
+	  e2m::tensor_slice_assign(u, e2m::Y, 2, m);
+	  check(tensors_close(u, ref), "tensor_slice_assign: matrix");
+     }
+
+     void check_tensor_permute()
+     {
+	  const e2m::size_t dims[] = {37, 3, 45};
+	  const auto t = random_tensor(dims[0], dims[1], dims[2]);
+	  const e2m::dir_order_t orders[] = {
+	       {{e2m::X, e2m::Y, e2m::Z}}, {{e2m::X, e2m::Z, e2m::Y}},
+	       {{e2m::Y, e2m::X, e2m::Z}}, {{e2m::Y, e2m::Z, e2m::X}},
+	       {{e2m::Z, e2m::X, e2m::Y}}, {{e2m::Z, e2m::Y, e2m::X}}
+	  };
+	  bool ok(true), ok_mx(true);
+	  for (const auto& order : orders) {
+	       // r(i[order[0]], i[order[1]], i[order[2]]) = t(i[0], i[1], i[2])
+	       e2m::real_tensor_t ref(dims[order[2]],
+				      e2m::real_matrix_t(dims[order[0]], dims[order[1]]));
+	       e2m::size_t i[3];
+	       for (i[2] = 0 ; i[2] < dims[2] ; ++i[2]) {
+		    for (i[1] = 0 ; i[1] < dims[1] ; ++i[1]) {
+			 for (i[0] = 0 ; i[0] < dims[0] ; ++i[0]) {
+			      ref[i[order[2]]](i[order[0]], i[order[1]]) = t[i[2]](i[0], i[1]);
+			 }
+		    }
+	       }
+	       ok &= tensors_close(e2m::permute(t, order), ref);
+	       mxArray* m = e2m::permute_to_mxArray(t, order);
+	       ok_mx &= tensors_close(e2m::mxArray_to_real_tensor(m), ref);
+	       mxDestroyArray(m);
+	  }
+	  check(ok, "permute: all orders");
+	  check(ok_mx, "permute_to_mxArray: all orders");
+     }
+
+     void check_tensor_block()
+     {
+	  auto t = random_tensor(3, 3, 5);
+	  const auto ref = t;
+	  e2m::real_tblock_t b(t, 1, 3);
+	  check(b.size() == 3 && !b.empty() && &b[0] == &t[1],
+		"tensor_block_t: size & operator[]");
+	  e2m::parallel_for_each(b, [](e2m::real_matrix_t& page) {page *= 2.;});
+	  bool ok(true);
+	  for (e2m::size_t k(0) ; k < t.size() ; ++k) {
+	       const double s = (k >= 1 && k < 4) ? 2. : 1.;
+	       ok &= is_close(t[k], s * ref[k], 0.);
+	  }
+	  check(ok, "parallel_for_each: tensor block");
+
+	  // const block: read-only access through const references
+	  const e2m::real_tblock_t& cb = b;
+	  double sum(0.);
+	  for (const auto& page : cb) {
+	       sum += page.sum();
+	  }
+	  check(std::abs(sum - 2. * (ref[1].sum() + ref[2].sum() + ref[3].sum())) < 1e-12,
+		"tensor_block_t: const iteration");
+     }
+
+     //! Exact comparison where NaN compares equal to NaN
+     bool same_values(const e2m::real_matrix_t& a, const e2m::real_matrix_t& b)
+     {
+	  if (a.rows() != b.rows() || a.cols() != b.cols()) {
+	       return false;
+	  }
+	  for (int k(0) ; k < a.size() ; ++k) {
+	       if (!(a(k) == b(k) || (std::isnan(a(k)) && std::isnan(b(k))))) {
+		    return false;
+	       }
+	  }
+	  return true;
+     }
+
+     void check_tensor_reduce()
+     {
+	  const e2m::size_t M(6), N(4), P(5);
+	  const auto t = random_tensor(M, N, P);
+
+	  e2m::real_matrix_t sx(N, P), sy(M, P), mx(N, P), my(M, P), nx(N, P);
+	  e2m::real_matrix_t sz = e2m::real_matrix_t::Zero(M, N);
+	  e2m::real_matrix_t mz = t[0], nz = e2m::real_matrix_t::Zero(M, N);
+	  for (e2m::size_t k(0) ; k < P ; ++k) {
+	       sx.col(k) = t[k].colwise().sum().transpose();
+	       sy.col(k) = t[k].rowwise().sum();
+	       mx.col(k) = t[k].colwise().maxCoeff().transpose();
+	       my.col(k) = t[k].rowwise().minCoeff();
+	       nx.col(k) = t[k].colwise().norm().transpose();
+	       sz += t[k];
+	       mz = mz.cwiseMax(t[k]);
+	       nz += t[k].cwiseAbs2();
+	  }
+	  nz = nz.cwiseSqrt();
+
+	  const e2m::REDUCE_ORDER_T orders[] = {e2m::ANY_ORDER, e2m::FIXED_ORDER};
+	  for (auto o : orders) {
+	       check(is_close(e2m::tensor_sum(t, e2m::X, o), sx), "tensor_sum: X");
+	       check(is_close(e2m::tensor_sum(t, e2m::Y, o), sy), "tensor_sum: Y");
+	       check(is_close(e2m::tensor_sum(t, e2m::Z, o), sz), "tensor_sum: Z");
+	       check(is_close(e2m::tensor_mean(t, e2m::Z, o), sz / static_cast<double>(P)), "tensor_mean: Z");
+	       check(is_close(e2m::tensor_max(t, e2m::X, o), mx, 0.), "tensor_max: X");
+	       check(is_close(e2m::tensor_min(t, e2m::Y, o), my, 0.), "tensor_min: Y");
+	       check(is_close(e2m::tensor_max(t, e2m::Z, o), mz, 0.), "tensor_max: Z");
+	       check(is_close(e2m::tensor_norm(t, e2m::X, o), nx), "tensor_norm: X");
+	       check(is_close(e2m::tensor_norm(t, e2m::Z, o), nz), "tensor_norm: Z");
+	  }
+
+	  // NaN values are ignored by max & min, wherever they are; big enough
+	  // to be reduced in parallel, with few columns so that ANY_ORDER
+	  // splits the pages
+	  const double nan = std::numeric_limits<double>::quiet_NaN();
+	  const e2m::size_t Mn(200), Nn(2), Pn(100);
+	  auto u = random_tensor(Mn, Nn, Pn);
+	  for (e2m::size_t k(0) ; k < Pn ; ++k) {
+	       u[k](0, 0) = nan;                  // all NaN
+	       u[k](1, 0) = k == 0 ? nan : 1.;    // NaN first
+	       u[k](2, 0) = k + 1 == Pn ? nan : -1.; // NaN last
+	  }
+	  u[0].row(3).setConstant(nan);
+	  u[Pn-1].col(1).tail(5).setConstant(nan);
+	  e2m::real_matrix_t ux(Nn, Pn), uy(Mn, Pn), uz(Mn, Nn);
+	  for (e2m::size_t k(0) ; k < Pn ; ++k) {
+	       for (e2m::size_t j(0) ; j < Nn ; ++j) {
+		    double v(nan);
+		    for (e2m::size_t i(0) ; i < Mn ; ++i) {
+			 if (!std::isnan(u[k](i, j)) && !(u[k](i, j) <= v)) {
+			      v = u[k](i, j);
+			 }
+		    }
+		    ux(j, k) = v;
+	       }
+	       for (e2m::size_t i(0) ; i < Mn ; ++i) {
+		    double v(nan);
+		    for (e2m::size_t j(0) ; j < Nn ; ++j) {
+			 if (!std::isnan(u[k](i, j)) && !(u[k](i, j) >= v)) {
+			      v = u[k](i, j);
+			 }
+		    }
+		    uy(i, k) = v;
+	       }
+	  }
+	  for (e2m::size_t j(0) ; j < Nn ; ++j) {
+	       for (e2m::size_t i(0) ; i < Mn ; ++i) {
+		    double v(nan);
+		    for (e2m::size_t k(0) ; k < Pn ; ++k) {
+			 if (!std::isnan(u[k](i, j)) && !(u[k](i, j) <= v)) {
+			      v = u[k](i, j);
+			 }
+		    }
+		    uz(i, j) = v;
+	       }
+	  }
+	  for (auto o : orders) {
+	       check(same_values(e2m::tensor_max(u, e2m::X, o), ux), "tensor_max: X with NaN");
+	       check(same_values(e2m::tensor_min(u, e2m::Y, o), uy), "tensor_min: Y with NaN");
+	       check(same_values(e2m::tensor_max(u, e2m::Z, o), uz), "tensor_max: Z with NaN");
+	  }
+	  check(std::isnan(uz(0, 0)) && uz(1, 0) == 1. && uz(2, 0) == -1.,
+		"tensor_max: NaN reference");
+     }
+
+     void check_tensor_page_ops()
+     {
+	  const e2m::size_t P(6);
+	  // 3 x 3 pages use the fixed-size kernels, 5 x 4 ones the generic path
+	  for (e2m::size_t n : {3, 5}) {
+	       const auto a = random_tensor(n, 4, P);
+	       const auto b = random_tensor(n, 4, P);
+	       const auto r = e2m::page_mtimes(a, b, e2m::NO_TRANSPOSE, e2m::TRANSPOSE);
+	       bool ok = r.size() == P;
+	       for (e2m::size_t k(0) ; ok && k < P ; ++k) {
+		    ok = is_close(r[k], a[k] * b[k].transpose());
+	       }
+	       check(ok, "page_mtimes: a * b.'");
+	  }
+
+	  const auto a = random_tensor(3, 3, P);
+	  const e2m::real_matrix_t m = e2m::real_matrix_t::Random(3, 2);
+	  const auto r = e2m::page_mtimes(a, m, e2m::TRANSPOSE, e2m::NO_TRANSPOSE);
+	  bool ok = r.size() == P;
+	  for (e2m::size_t k(0) ; ok && k < P ; ++k) {
+	       ok = is_close(r[k], a[k].transpose() * m);
+	  }
+	  check(ok, "page_mtimes: tensor.' * matrix");
+
+	  e2m::cmplx_tensor_t ca(P), cb(P);
+	  for (e2m::size_t k(0) ; k < P ; ++k) {
+	       ca[k] = e2m::cmplx_matrix_t::Random(4, 3);
+	       cb[k] = e2m::cmplx_matrix_t::Random(4, 2);
+	  }
+	  const auto cr = e2m::page_mtimes(ca, cb, e2m::CTRANSPOSE, e2m::NO_TRANSPOSE);
+	  ok = cr.size() == P;
+	  for (e2m::size_t k(0) ; ok && k < P ; ++k) {
+	       ok = is_close(cr[k], ca[k].adjoint() * cb[k]);
+	  }
+	  check(ok, "page_mtimes: complex a' * b");
+
+	  // diagonally dominant pages, so that the systems are well conditioned
+	  auto s = random_tensor(4, 4, P);
+	  for (auto& page : s) {
+	       page += 8. * e2m::real_matrix_t::Identity(4, 4);
+	  }
+	  const auto rhs = random_tensor(4, 2, P);
+	  const auto x = e2m::page_solve(s, rhs);
+	  ok = x.size() == P;
+	  for (e2m::size_t k(0) ; ok && k < P ; ++k) {
+	       ok = is_close(s[k] * x[k], rhs[k], 1e-10);
+	  }
+	  check(ok, "page_solve");
+     }
+
+     void check_tensor_mode_product()
+     {
+	  const e2m::size_t M(4), N(3), P(5), J(2);
+	  const auto t = random_tensor(M, N, P);
+
+	  const e2m::real_matrix_t ux = e2m::real_matrix_t::Random(J, M);
+	  const e2m::real_matrix_t uy = e2m::real_matrix_t::Random(J, N);
+	  const e2m::real_matrix_t uz = e2m::real_matrix_t::Random(J, P);
+	  e2m::real_tensor_t rx(P), ry(P), rz(J);
+	  for (e2m::size_t k(0) ; k < P ; ++k) {
+	       rx[k] = ux * t[k];
+	       ry[k] = t[k] * uy.transpose();
+	  }
+	  for (e2m::size_t j(0) ; j < J ; ++j) {
+	       rz[j] = e2m::real_matrix_t::Zero(M, N);
+	       for (e2m::size_t k(0) ; k < P ; ++k) {
+		    rz[j] += uz(j, k) * t[k];
+	       }
+	  }
+	  check(tensors_close(e2m::mode_product(t, ux, e2m::X), rx), "mode_product: X");
+	  check(tensors_close(e2m::mode_product(t, uy, e2m::Y), ry), "mode_product: Y");
+	  check(tensors_close(e2m::mode_product(t, uz, e2m::Z), rz), "mode_product: Z");
+	  mxArray* m = e2m::mode_product_to_mxArray(t, uz, e2m::Z);
+	  check(tensors_close(e2m::mxArray_to_real_tensor(m), rz),
+		"mode_product_to_mxArray: Z");
+	  mxDestroyArray(m);
+     }
+
+     // =========================================================================
+
+     //! Dense copy of a MATLAB (sparse or dense) real matrix
+     e2m::real_matrix_t to_dense(const mxArray* m)
+     {
+	  if (mxIsSparse(m)) {
+	       return e2m::real_matrix_t(e2m::mxArray_to_real_sp_matrix(m));
+	  }
+	  return e2m::mxArray_to_real_matrix(m);
+     }
+
+     //! Random matrix with about half of its elements set to zero
+     e2m::real_matrix_t random_sparse_pattern(e2m::size_t M, e2m::size_t N)
+     {
+	  e2m::real_matrix_t A = e2m::real_matrix_t::Random(M, N);
+	  return (A.array() > 0.).select(A, 0.);
+     }
+
+     void check_sparse_cell()
+     {
+	  const e2m::real_matrix_t A = random_sparse_pattern(30, 20);
+	  const e2m::real_matrix_t B = random_sparse_pattern(30, 20);
+	  const e2m::real_sp_matrix_t SA = A.sparseView();
+	  const e2m::real_sp_matrix_t SB = B.sparseView();
+
+	  mxArray* s = e2m::to_mxArray(SA);
+	  check(is_close(to_dense(s), A, 0.), "to_mxArray: sparse matrix");
+	  mxDestroyArray(s);
+
+	  const e2m::real_sp_cell_t cell = {SA, SB, e2m::real_sp_matrix_t(3, 2)};
+	  mxArray* c = e2m::to_mxArray(cell);
+	  const auto back = e2m::mxArray_to_real_sp_cell(c);
+	  mxDestroyArray(c);
+	  bool ok = back.size() == cell.size();
+	  for (e2m::size_t k(0) ; ok && k < cell.size() ; ++k) {
+	       ok = is_close(e2m::real_matrix_t(back[k]), e2m::real_matrix_t(cell[k]), 0.);
+	  }
+	  check(ok, "to_mxArray: sparse cell array");
+
+	  const e2m::cmplx_matrix_t C = e2m::cmplx_matrix_t::Random(6, 4);
+	  const e2m::cmplx_sp_cell_t ccell = {C.sparseView(), C.transpose().sparseView()};
+	  c = e2m::to_mxArray(ccell);
+	  const auto cback = e2m::mxArray_to_cmplx_sp_cell(c);
+	  mxDestroyArray(c);
+	  check(cback.size() == 2
+		&& is_close(e2m::cmplx_matrix_t(cback[0]), C, 0.)
+		&& is_close(e2m::cmplx_matrix_t(cback[1]), C.transpose(), 0.),
+		"to_mxArray: complex sparse cell array");
+     }
+
+     void check_sparse_compact()
+     {
+	  // uncompressed matrix, with room left in every column
+	  e2m::real_sp_matrix_t U(30, 20);
+	  U.reserve(Eigen::VectorXi::Constant(20, 4));
+	  for (int j(0) ; j < 20 ; j += 3) {
+	       U.insert(j, j) = j + 1.;
+	       U.insert(29 - j, j) = -j;
+	  }
+	  check(!U.isCompressed(), "to_mxArray: uncompressed input");
+	  mxArray* u = e2m::to_mxArray(U);
+	  check(is_close(to_dense(u), e2m::real_matrix_t(U), 0.),
+		"to_mxArray: uncompressed sparse matrix");
+	  mxDestroyArray(u);
+
+	  // big enough to be split in parallel chunks
+	  const e2m::size_t n(100000);
+	  std::vector<int> in(n);
+	  for (e2m::size_t i(0) ; i < n ; ++i) {
+	       in[i] = static_cast<int>(i % 7);
+	  }
+	  std::vector<mwIndex> out(n + 1), ref(n + 1, 0);
+	  for (e2m::size_t i(0) ; i < n ; ++i) {
+	       ref[i+1] = ref[i] + in[i];
+	  }
+	  const auto total = e2m::internal::parallel_exclusive_scan(n, in.data(), out.data());
+	  check(out == ref && total == ref[n], "parallel_exclusive_scan");
+     }
+
+     void check_sparse_expression()
+     {
+	  const e2m::real_matrix_t A = random_sparse_pattern(30, 20);
+	  const e2m::real_matrix_t B = random_sparse_pattern(30, 20);
+	  const e2m::real_sp_matrix_t SA = A.sparseView();
+	  const e2m::real_sp_matrix_t SB = B.sparseView();
+
+	  mxArray* x = e2m::to_mxArray(SA + 2. * SB);
+	  check(is_close(to_dense(x), A + 2. * B), "to_mxArray: sparse expression");
+	  mxDestroyArray(x);
+
+	  // row-major expression, scattered column-wise
+	  mxArray* t = e2m::to_mxArray(SA.transpose());
+	  check(is_close(to_dense(t), e2m::real_matrix_t(A.transpose()), 0.),
+		"to_mxArray: transposed sparse expression");
+	  mxDestroyArray(t);
+
+	  const e2m::cmplx_matrix_t C = e2m::cmplx_matrix_t::Random(6, 4);
+	  const e2m::cmplx_sp_matrix_t SC = C.sparseView();
+	  mxArray* c = e2m::to_mxArray(SC * 2.);
+	  check(is_close(e2m::cmplx_matrix_t(e2m::mxArray_to_cmplx_sp_matrix(c)),
+			 e2m::cmplx_matrix_t(C * 2.)),
+		"to_mxArray: complex sparse expression");
+	  mxDestroyArray(c);
+     }
+
+     void check_sparse_prune()
+     {
+	  const e2m::real_matrix_t A = random_sparse_pattern(30, 20);
+	  const e2m::real_sp_matrix_t SA = A.sparseView();
+
+	  const double tol = 0.5;
+	  const e2m::real_matrix_t ref = (A.array().abs() > tol).select(A, 0.);
+	  const auto nnz = static_cast<mwIndex>((ref.array() != 0.).count());
+	  mxArray* p = e2m::prune_to_mxArray(SA, tol);
+	  check(is_close(to_dense(p), ref, 0.) && mxGetJc(p)[20] == nnz,
+		"prune_to_mxArray");
+	  mxDestroyArray(p);
+	  mxArray* d = e2m::dense_to_sparse_mxArray(A, tol);
+	  check(is_close(to_dense(d), ref, 0.) && mxGetJc(d)[20] == nnz,
+		"dense_to_sparse_mxArray");
+	  mxDestroyArray(d);
+
+	  // NaNs are kept, as with MATLAB's sparse()
+	  e2m::real_matrix_t B = e2m::real_matrix_t::Zero(4, 3);
+	  B(1, 0) = std::numeric_limits<double>::quiet_NaN();
+	  B(2, 2) = 0.1;
+	  d = e2m::dense_to_sparse_mxArray(B, 0.5);
+	  check(mxGetJc(d)[3] == 1 && mxGetIr(d)[0] == 1 && std::isnan(mxGetPr(d)[0]),
+		"dense_to_sparse_mxArray: NaN kept");
+	  mxDestroyArray(d);
+	  const e2m::real_sp_matrix_t SB = B.sparseView();
+	  p = e2m::prune_to_mxArray(SB, 0.5);
+	  check(mxGetJc(p)[3] == 1 && std::isnan(mxGetPr(p)[0]),
+		"prune_to_mxArray: NaN kept");
+	  mxDestroyArray(p);
+     }
+
+     void check_sparse_assembler()
+     {
+	  const int M(40), N(30), n(4000);
+	  e2m::real_matrix_t ref = e2m::real_matrix_t::Zero(M, N);
+	  for (int k(0) ; k < n ; ++k) {
+	       ref((k * 7) % M, (k * 13) % N) += k;
+	  }
+
+	  e2m::real_sp_assembler_t A(M, N);
+#pragma omp parallel for
+	  for (int k = 0 ; k < n ; ++k) {
+	       A.add((k * 7) % M, (k * 13) % N, k);
+	  }
+	  check(A.size() == static_cast<e2m::size_t>(n), "sparse_assembler: size");
+	  e2m::real_sp_matrix_t S;
+	  A.to_eigen(S);
+	  check(is_close(e2m::real_matrix_t(S), ref), "sparse_assembler: to_eigen");
+	  mxArray* m = A.to_mxArray();
+	  check(is_close(to_dense(m), ref), "sparse_assembler: to_mxArray");
+	  mxDestroyArray(m);
+
+	  // wide matrix with few contributions: shared count row
+	  e2m::real_sp_assembler_t W(3, 100000);
+#pragma omp parallel for
+	  for (int k = 0 ; k < 100 ; ++k) {
+	       W.add(k % 3, k * 997, 1.);
+	       W.add(k % 3, k * 997, 1.);
+	  }
+	  m = W.to_mxArray();
+	  check(mxGetJc(m)[100000] == 100 && mxGetPr(m)[0] == 2.,
+		"sparse_assembler: wide matrix");
+	  mxDestroyArray(m);
+     }
+
+     void check_dense_slice()
+     {
+	  e2m::real_matrix_t A = e2m::real_matrix_t::Random(9, 6);
+	  const auto A0 = A;
+	  const std::vector<int> cols = {5, 0, 2};
+
+	  // a run of consecutive rows followed by gathered ones
+	  const std::vector<int> run = {1, 2, 3, 4, 5, 8, 0};
+	  e2m::real_matrix_t ref(run.size(), cols.size());
+	  for (e2m::size_t j(0) ; j < cols.size() ; ++j) {
+	       for (e2m::size_t i(0) ; i < run.size() ; ++i) {
+		    ref(i, j) = A0(run[i], cols[j]);
+	       }
+	  }
+	  check(is_close(A.slice(run, cols).eval(), ref, 0.), "dense_slice: eval");
+
+	  // repeated rows
+	  const std::vector<int> rows = {1, 2, 3, 4, 7, 0, 7};
+	  auto s = A.slice(rows, cols);
+
+	  // last wins for repeated indices, as with MATLAB's A(I,J) = B
+	  const e2m::real_matrix_t B = e2m::real_matrix_t::Random(rows.size(), cols.size());
+	  s = B;
+	  auto R = A0;
+	  for (e2m::size_t j(0) ; j < cols.size() ; ++j) {
+	       for (e2m::size_t i(0) ; i < rows.size() ; ++i) {
+		    R(rows[i], cols[j]) = B(i, j);
+	       }
+	  }
+	  check(is_close(A, R, 0.), "dense_slice: assignment");
+
+	  s += 1.;
+	  for (e2m::size_t j(0) ; j < cols.size() ; ++j) {
+	       for (e2m::size_t i(0) ; i < rows.size() ; ++i) {
+		    R(rows[i], cols[j]) += 1.;
+	       }
+	  }
+	  check(is_close(A, R, 0.), "dense_slice: += scalar");
+
+	  // repeated index straddling a run
+	  const std::vector<int> dup = {0, 0, 1, 2, 3};
+	  const e2m::real_matrix_t D = e2m::real_matrix_t::Random(dup.size(), cols.size());
+	  A.slice(dup, cols) = D;
+	  for (e2m::size_t j(0) ; j < cols.size() ; ++j) {
+	       for (e2m::size_t i(0) ; i < dup.size() ; ++i) {
+		    R(dup[i], cols[j]) = D(i, j);
+	       }
+	  }
+	  check(is_close(A, R, 0.), "dense_slice: repeated index before a run");
+     }
+
+     void check_mask_view()
+     {
+	  const e2m::real_matrix_t A = e2m::real_matrix_t::Random(7, 5);
+	  e2m::bool_array_t mask(7, 5);
+	  for (int k(0) ; k < 35 ; ++k) {
+	       mask(k) = (k % 3) != 1;
+	  }
+
+	  e2m::real_matrix_t D = A;
+	  auto v = e2m::masked(D, e2m::mask_t(mask));
+	  std::vector<double> ref;
+	  for (int k(0) ; k < 35 ; ++k) {
+	       if (mask(k)) {
+		    ref.push_back(A(k));
+	       }
+	  }
+	  const e2m::real_vector_t x = v.eval();
+	  check(is_close(x, e2m::real_map_vec_t(ref.data(), ref.size()), 0.),
+		"mask_view: eval");
+	  v = 0.;
+	  check(is_close(D, mask.select(e2m::real_matrix_t::Zero(7, 5), A), 0.),
+		"mask_view: assignment");
+
+	  // block of a larger matrix (outer stride != rows)
+	  e2m::real_matrix_t L = e2m::real_matrix_t::Random(10, 8);
+	  const auto L0 = L;
+	  auto blk = L.block(2, 1, 7, 5);
+	  e2m::masked(blk, e2m::mask_t(mask)) += 1.;
+	  e2m::real_matrix_t R = L0;
+	  R.block(2, 1, 7, 5) += mask.cast<double>().matrix();
+	  check(is_close(L, R, 0.), "mask_view: matrix block");
+
+	  // sparse matrix: masked elements set to zero are removed
+	  e2m::real_sp_matrix_t S = random_sparse_pattern(7, 5).sparseView();
+	  const e2m::real_matrix_t S0(S);
+	  e2m::masked(S, e2m::mask_t(mask)) = 0.;
+	  const e2m::real_matrix_t SR = mask.select(e2m::real_matrix_t::Zero(7, 5), S0);
+	  check(is_close(e2m::real_matrix_t(S), SR, 0.)
+		&& S.nonZeros() == (SR.array() != 0.).count(),
+		"mask_view: sparse assignment");
+
+	  check(std::is_copy_constructible<decltype(v)>::value
+		&& !std::is_copy_assignable<decltype(v)>::value,
+		"mask_view: copy assignment deleted");
+     }
+
+     //! Reference for remove_rows, remove_cols & insert_cols
+     e2m::real_matrix_t select_rows(const e2m::real_matrix_t& A,
+				    const e2m::idx_array_t& removed)
+     {
+	  e2m::real_matrix_t ret(0, A.cols());
+	  for (e2m::size_t i(0) ; i < static_cast<e2m::size_t>(A.rows()) ; ++i) {
+	       if (std::find(removed.begin(), removed.end(), i) == removed.end()) {
+		    ret.conservativeResize(ret.rows() + 1, Eigen::NoChange);
+		    ret.row(ret.rows() - 1) = A.row(i);
+	       }
+	  }
+	  return ret;
+     }
+
+     void check_sparse_edit()
+     {
+	  const e2m::real_matrix_t A = random_sparse_pattern(8, 6);
+	  const e2m::real_sp_matrix_t S0 = A.sparseView();
+	  const e2m::idx_array_t rows = {5, 1, 5};
+	  const e2m::idx_array_t cols = {0, 4};
+
+	  auto S = S0;
+	  e2m::remove_rows(S, rows);
+	  const auto Rr = select_rows(A, rows);
+	  check(is_close(e2m::real_matrix_t(S), Rr, 0.), "remove_rows");
+	  mxArray* m = e2m::remove_rows_to_mxArray(S0, rows);
+	  check(is_close(to_dense(m), Rr, 0.), "remove_rows_to_mxArray");
+	  mxDestroyArray(m);
+
+	  S = S0;
+	  e2m::remove_cols(S, cols);
+	  const e2m::real_matrix_t Rc = select_rows(A.transpose(), cols).transpose();
+	  check(is_close(e2m::real_matrix_t(S), Rc, 0.), "remove_cols");
+	  m = e2m::remove_cols_to_mxArray(S0, cols);
+	  check(is_close(to_dense(m), Rc, 0.), "remove_cols_to_mxArray");
+	  mxDestroyArray(m);
+
+	  const e2m::real_matrix_t C = random_sparse_pattern(8, 3);
+	  const e2m::real_sp_matrix_t SC = C.sparseView();
+	  const e2m::idx_array_t pos = {0, 4, 8};
+	  e2m::real_matrix_t Ri(8, 9);
+	  for (e2m::size_t j(0), c(0), q(0) ; j < 9 ; ++j) {
+	       Ri.col(j) = (q < pos.size() && pos[q] == j) ? C.col(q++) : A.col(c++);
+	  }
+	  S = S0;
+	  e2m::insert_cols(S, pos, SC);
+	  check(is_close(e2m::real_matrix_t(S), Ri, 0.), "insert_cols");
+	  m = e2m::insert_cols_to_mxArray(S0, pos, SC);
+	  check(is_close(to_dense(m), Ri, 0.), "insert_cols_to_mxArray");
+	  mxDestroyArray(m);
+
+	  // m inserted into itself
+	  S = S0;
+	  const e2m::idx_array_t self_pos = {1, 2, 5, 6, 9, 11};
+	  e2m::insert_cols(S, self_pos, S);
+	  e2m::real_matrix_t Rs(8, 12);
+	  for (e2m::size_t j(0), c(0), q(0) ; j < 12 ; ++j) {
+	       Rs.col(j) = (q < self_pos.size() && self_pos[q] == j) ? A.col(q++) : A.col(c++);
+	  }
+	  check(is_close(e2m::real_matrix_t(S), Rs, 0.), "insert_cols: aliasing");
+     }
+
+     void check_sparse_block_builder()
+     {
+	  const e2m::real_matrix_t K = random_sparse_pattern(5, 5);
+	  const e2m::real_matrix_t B = random_sparse_pattern(3, 5);
+	  const e2m::real_matrix_t C = random_sparse_pattern(3, 3);
+	  const e2m::real_sp_matrix_t SK = K.sparseView();
+	  const e2m::real_sp_matrix_t SB = B.sparseView();
+	  const e2m::real_sp_matrix_t SC = C.sparseView();
+
+	  e2m::real_sp_block_builder_t b(3, 2);
+	  b.set(0, 0, SK);
+	  b.set(0, 1, SB, 1., e2m::TRANSPOSE);
+	  b.set(1, 0, SB);
+	  b.set(1, 1, SC, -1.);
+	  b.set_zero(2, 0, 3, 5);
+	  b.set(2, 1, SC, 0.);
+	  e2m::real_matrix_t ref = e2m::real_matrix_t::Zero(11, 8);
+	  ref.block(0, 0, 5, 5) = K;
+	  ref.block(0, 5, 5, 3) = B.transpose();
+	  ref.block(5, 0, 3, 5) = B;
+	  ref.block(5, 5, 3, 3) = -C;
+
+	  e2m::real_sp_matrix_t S;
+	  b.to_eigen(S);
+	  check(is_close(e2m::real_matrix_t(S), ref, 0.), "sparse_block_builder: to_eigen");
+	  mxArray* m = b.to_mxArray();
+	  check(is_close(to_dense(m), ref, 0.), "sparse_block_builder: to_mxArray");
+	  mxDestroyArray(m);
+     }
+
+     void check_sparse_row_major()
+     {
+	  const e2m::real_matrix_t A = random_sparse_pattern(30, 20);
+	  const e2m::real_sp_matrix_t SA = A.sparseView();
+
+	  const e2m::real_sp_rm_matrix_t R(SA);
+	  mxArray* r = e2m::to_mxArray(R);
+	  check(is_close(to_dense(r), A, 0.), "to_mxArray: row-major sparse matrix");
+	  check(is_close(e2m::real_matrix_t(e2m::mxArray_to_real_sp_rm_matrix(r)), A, 0.),
+		"mxArray_to_real_sp_rm_matrix");
+	  mxDestroyArray(r);
+
+	  // uncompressed row-major matrix
+	  e2m::real_sp_rm_matrix_t U(20, 30);
+	  U.reserve(Eigen::VectorXi::Constant(20, 4));
+	  for (int i(0) ; i < 20 ; i += 3) {
+	       U.insert(i, 29 - i) = i + 1.;
+	       U.insert(i, i) = -i;
+	  }
+	  mxArray* u = e2m::to_mxArray(U);
+	  check(is_close(to_dense(u), e2m::real_matrix_t(U), 0.),
+		"to_mxArray: uncompressed row-major sparse matrix");
+	  mxDestroyArray(u);
+     }
+
+     void check_scatter_assembler()
+     {
+	  const e2m::size_t N(50);
+	  std::vector<e2m::idx_array_t> elements;
+	  for (e2m::size_t e(0) ; e + 2 < N ; ++e) {
+	       // a repeated dof inside the element
+	       elements.push_back({e, e + 1, e + 2, e});
+	  }
+	  const auto Ke = [](e2m::size_t e, e2m::real_matrix_t& K) {
+	       for (int j(0) ; j < K.cols() ; ++j) {
+		    for (int i(0) ; i < K.rows() ; ++i) {
+			 K(i, j) = static_cast<double>(e + 1) + i - 2 * j;
+		    }
+	       }
+	  };
+
+	  e2m::real_matrix_t ref = e2m::real_matrix_t::Zero(N, N);
+	  e2m::real_matrix_t K(4, 4);
+	  for (e2m::size_t e(0) ; e < elements.size() ; ++e) {
+	       Ke(e, K);
+	       for (e2m::size_t j(0) ; j < 4 ; ++j) {
+		    for (e2m::size_t i(0) ; i < 4 ; ++i) {
+			 ref(elements[e][i], elements[e][j]) += K(i, j);
+		    }
+	       }
+	  }
+
+	  e2m::real_scatter_assembler_t A(N, elements);
+	  A.assemble(Ke);
+	  check(is_close(e2m::real_matrix_t(A.matrix()), ref, 0.),
+		"scatter_assembler: assemble");
+	  bool ok(true);
+	  for (e2m::size_t c(0) ; c < A.n_colors() ; ++c) {
+	       std::vector<int> seen(N, 0);
+	       for (auto k(A.color_ptr()[c]) ; k < A.color_ptr()[c+1] ; ++k) {
+		    const auto& dofs = elements[A.color_elements()[k]];
+		    for (e2m::size_t i(0) ; i < dofs.size() ; ++i) {
+			 // a repeated dof of the same element is fine
+			 ok &= seen[dofs[i]] == 0 || seen[dofs[i]] == static_cast<int>(k + 1);
+			 seen[dofs[i]] = static_cast<int>(k + 1);
+		    }
+	       }
+	  }
+	  check(ok, "scatter_assembler: colouring");
+
+	  A.set_zero();
+	  A.assemble(Ke);
+	  check(is_close(e2m::real_matrix_t(A.matrix()), ref, 0.),
+		"scatter_assembler: set_zero & assemble again");
+
+	  // one assembler per thread of an enclosing parallel region
+	  bool par_ok(true);
+#pragma omp parallel num_threads(2) reduction(&&:par_ok)
+	  {
+	       e2m::real_scatter_assembler_t B(N, elements);
+	       B.assemble(Ke);
+	       par_ok = is_close(e2m::real_matrix_t(B.matrix()), ref, 0.);
+	  }
+	  check(par_ok, "scatter_assembler: inside a parallel region");
+     }
+
+     void check_accumarray()
+     {
+	  const e2m::size_t n(5000), B(37);
+	  e2m::idx_array_t subs(n);
+	  e2m::real_vector_t vals(n);
+	  for (e2m::size_t k(0) ; k < n ; ++k) {
+	       subs[k] = (k * 7919) % (B - 1);  // last bin stays empty
+	       vals[k] = static_cast<double>((k * 31) % 101) - 50.;
+	  }
+	  vals[3] = std::numeric_limits<double>::quiet_NaN();
+
+	  e2m::real_vector_t sum = e2m::real_vector_t::Zero(B);
+	  e2m::real_vector_t cnt = e2m::real_vector_t::Zero(B);
+	  e2m::real_vector_t mx = e2m::real_vector_t::Constant(B, -1e300);
+	  for (e2m::size_t k(0) ; k < n ; ++k) {
+	       sum[subs[k]] += vals[k];
+	       cnt[subs[k]] += 1.;
+	       if (!std::isnan(vals[k])) {
+		    mx[subs[k]] = std::max(mx[subs[k]], vals[k]);
+	       }
+	  }
+	  mx[B-1] = 0.;
+
+	  auto rs = e2m::accumarray(subs, vals, B, e2m::ACCUM_SUM);
+	  check(std::isnan(rs[subs[3]]), "accumarray: NaN propagates to the sum");
+	  sum[subs[3]] = rs[subs[3]] = 0.;
+	  check(is_close(rs, sum), "accumarray: sum");
+	  check(is_close(e2m::accumarray(subs, vals, B, e2m::ACCUM_MAX), mx, 0.),
+		"accumarray: max (NaN ignored)");
+	  check(is_close(e2m::accumarray(subs, vals, B, e2m::ACCUM_COUNT), cnt, 0.),
+		"accumarray: count");
+
+	  // 2D, sparse
+	  e2m::int_array_t rows(n), cols(n);
+	  e2m::real_matrix_t ref = e2m::real_matrix_t::Zero(9, 7);
+	  for (e2m::size_t k(0) ; k < n ; ++k) {
+	       rows[k] = static_cast<int>((k * 5) % 9);
+	       cols[k] = static_cast<int>((k * 3) % 6);
+	       vals[k] = 1. / static_cast<double>(k + 1);
+	       ref(rows[k], cols[k]) += vals[k];
+	  }
+	  const auto S = e2m::sp_accumarray(rows, cols, vals, 9, 7, e2m::ACCUM_SUM);
+	  check(is_close(e2m::real_matrix_t(S), ref), "sp_accumarray: sum");
+	  mxArray* m = e2m::accumarray_to_mxArray(rows, cols, vals, 9, 7,
+						  e2m::ACCUM_MEAN, true);
+	  e2m::real_matrix_t mean_ref = ref;
+	  for (int j(0) ; j < 7 ; ++j) {
+	       for (int i(0) ; i < 9 ; ++i) {
+		    int c(0);
+		    for (e2m::size_t k(0) ; k < n ; ++k) {
+			 c += rows[k] == i && cols[k] == j;
+		    }
+		    mean_ref(i, j) = c == 0 ? 0. : ref(i, j) / c;
+	       }
+	  }
+	  check(mxIsSparse(m) && is_close(to_dense(m), mean_ref),
+		"accumarray_to_mxArray: mean, sparse");
+	  mxDestroyArray(m);
+     }
+
+	  // many more bins than values: sorted lists, empty columns
+	  e2m::real_matrix_t big_ref = e2m::real_matrix_t::Zero(1000, 1000);
+	  for (e2m::size_t k(0) ; k < n ; ++k) {
+	       rows[k] = static_cast<int>((k * 7919) % 1000);
+	       cols[k] = static_cast<int>((k * 13) % 997);
+	       vals[k] = (k % 3 == 0) ? 0. : static_cast<double>(k);
+	       big_ref(rows[k], cols[k]) = std::max(big_ref(rows[k], cols[k]), vals[k]);
+	  }
+	  const auto SB = e2m::sp_accumarray(rows, cols, vals, 1000, 1000, e2m::ACCUM_MAX);
+	  check(is_close(e2m::real_matrix_t(SB), big_ref, 0.)
+		&& SB.nonZeros() == (big_ref.array() != 0.).count(),
+		"sp_accumarray: max, many bins");
+	  m = e2m::accumarray_to_mxArray(rows, cols, vals, 1000, 1000,
+					 e2m::ACCUM_MAX, true);
+	  check(is_close(to_dense(m), big_ref, 0.)
+		&& mxGetJc(m)[1000] == static_cast<mwIndex>(SB.nonZeros()),
+		"accumarray_to_mxArray: max, many bins");
+	  mxDestroyArray(m);
+     }
+} // namespace
+
+CLANG_RESTORE_WARNINGS
+GCC_RESTORE_WARNINGS
+
 int main(int /*argc*/, char** /*argv*/)
 {
      // typedef Eigen::VectorXd real_vector_t;
@@ -146,5 +1161,29 @@ int main(int /*argc*/, char** /*argv*/)
      eigen2mat::print(mat);
      eigen2mat::print("====================");
 
-     return 0;
+     check_mex_args();
+     check_stats();
+     check_trace();
+     check_tensor_to_matrix();
+     check_tensor_slice_assign();
+     check_tensor_permute();
+     check_tensor_block();
+     check_tensor_reduce();
+     check_tensor_page_ops();
+     check_tensor_mode_product();
+     check_sparse_cell();
+     check_sparse_compact();
+     check_sparse_expression();
+     check_sparse_prune();
+     check_sparse_assembler();
+     check_dense_slice();
+     check_mask_view();
+     check_sparse_edit();
+     check_sparse_block_builder();
+     check_sparse_row_major();
+     check_scatter_assembler();
+     check_accumarray();
+     PRINTF("%d check(s) failed\n", n_failed);
+
+     return n_failed == 0 ? 0 : 1;
 }
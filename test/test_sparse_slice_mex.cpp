@@ -1,4 +1,5 @@
 #include "conversion.hpp"
+#include "mex_args.hpp"
 #include "sparse_slice.hpp"
 
 #include "Eigen_Sparse"
@@ -9,24 +10,19 @@ void mexFunction( int nlhs, mxArray *plhs[],
 		  int nrhs, const mxArray*prhs[] )
 
 {
-     if (nrhs != 3) {
-	  mexErrMsgTxt("Function requires three arguments (sparse matrix + range1 + range2)!");
-     }
-     if (nlhs != 1) {
-     	  mexErrMsgTxt("Function requires one output argument!");
-     }
+     eigen2mat::check_nlhs(nlhs, 1, 1, "test_sparse_slice_mex");
+     eigen2mat::mex_args<const mxArray*,
+			 eigen2mat::int_array_t,
+			 eigen2mat::int_array_t> args(nrhs, prhs, "test_sparse_slice_mex");
 
-     const auto a     = prhs[0];
-     const auto mrows = prhs[1];
-     const auto mcols = prhs[2];
+     const auto a = args.get<0>();
+     auto& rows = args.get<1>();
+     auto& cols = args.get<2>();
 
      if (!mxIsSparse(a)) {
 	  mexErrMsgTxt("Input argument is not sparse!");	  
      }
 
-     eigen2mat::int_array_t rows = eigen2mat::mxArray_to_int_array(mrows);
-     eigen2mat::int_array_t cols = eigen2mat::mxArray_to_int_array(mcols);
-
      // convert MATLAB indices to C++ indices...
      for (auto i(0UL) ; i < rows.size() ; ++i) {
 	  rows[i] -= 1;